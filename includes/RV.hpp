@@ -26,6 +26,7 @@
 # include "glm/gtc/matrix_transform.hpp"
 # include "glm/gtc/type_ptr.hpp"
 # include "glm/gtx/euler_angles.hpp"
+# include "glm/gtc/matrix_integer.hpp"
 
 # include "glad/gl.h"
 # include "GLFW/glfw3.h"
@@ -49,20 +50,147 @@
 # include <memory>
 # include <set>
 # include <map>
+# include <functional>
+# include <random>
 
 struct Vertex {
     glm::vec2 position;
     glm::vec2 texCoord;
 };
 
+// index in the textures vector, the ones before DENOISE_PING_TEXTURE stay bound
+// to the image unit of the same index, units 4 to 7 are rebound by each pass
+enum TextureIndex
+{
+	OUTPUT_TEXTURE,
+	NORMAL_DEPTH_TEXTURE,
+	ALBEDO_TEXTURE,
+	MOMENTS_TEXTURE,
+	DENOISE_PING_TEXTURE,
+	DENOISE_PONG_TEXTURE,
+	HISTORY_COLOR_TEXTURE,
+	HISTORY_NORMAL_DEPTH_TEXTURE,
+	HISTORY_MOMENTS_TEXTURE,
+	MOTION_TEXTURE,
+	TRAVERSAL_TEXTURE,
+	TEXTURE_COUNT
+};
+
+// bits of u_aovMask, which feature images the trace pass writes this frame
+enum AovMask
+{
+	AOV_NORMAL_DEPTH = 1,
+	AOV_ALBEDO = 2,
+	AOV_TRAVERSAL = 4
+};
+
+// what the display shader shows, same values as u_view in shaders/frag.frag
+enum AovView
+{
+	VIEW_COLOR,
+	VIEW_DEPTH,
+	VIEW_NORMAL,
+	VIEW_ALBEDO,
+	VIEW_VOXEL_ID,
+	VIEW_NODE_VISITS,
+	VIEW_VOXEL_VISITS,
+	VIEW_MOTION,
+	VIEW_HISTORY,
+	VIEW_RAW,
+	VIEW_COUNT
+};
+
+struct AovViewInfo
+{
+	const char		*name;
+	TextureIndex	texture;
+	int				mask;
+};
+
+extern const AovViewInfo	aov_views[VIEW_COUNT];
+
+// command line, `RedVox [scene.vox] [--trace file.json] [--headless ...]`
+struct Options
+{
+	std::string	scene;
+	std::string	trace;
+
+	bool		headless;
+	int			frames;
+	float		scale;
+	bool		has_camera;
+	float		camera[5];
+	std::string	output;
+
+	std::string	record;
+	std::string	benchmark;
+	float		timestep;
+	int			import_runs;
+
+	std::string	capture;
+	bool		capture_exr;
+
+	int			stream_slots;
+	float		lod_bias;
+	bool		validate_denoise;
+
+	int			world_dim;
+	float		voxel_size;
+	int			chunk_radius;
+
+	bool		has_terrain;
+	uint32_t	terrain_seed;
+
+	std::vector<std::string>	instances;
+};
+
+bool	parseOptions(int argc, char **argv, Options &options);
+float	percentile(const std::vector<float> &sorted, float p);
+
+class Scene;
+struct GPUVoxel;
+
+// fills voxels with the cells of the chunk whose corner is origin in world
+// voxels, positions relative to origin, runs on the ThreadPool workers
+typedef std::function<void(glm::ivec3 origin, std::vector<GPUVoxel> &voxels)>	ChunkSource;
+
+glm::vec3	voxelNormal(glm::ivec3 position, const std::function<bool(glm::ivec3)> &filled);
+bool	addInstances(Scene &scene, const std::vector<std::string> &specs);
+void	setupTerrain(Scene &scene, const Options &options);
+
+void	readTexture(GLuint texture, glm::ivec2 resolution, std::vector<glm::vec4> &pixels);
+float	aovValue(AovView view, const glm::vec4 &texel);
+
 # include "VoxModel.hpp"
+# include "CameraPath.hpp"
 # include "SVO.hpp"
 # include "Buffer.hpp"
+# include "PagedBuffer.hpp"
 # include "Camera.hpp"
 # include "Window.hpp"
 # include "Shader.hpp"
 # include "ShaderProgram.hpp"
 # include "Scene.hpp"
+# include "Denoiser.hpp"
+# include "Reprojection.hpp"
+# include "GPUTimer.hpp"
+# include "DynamicResolution.hpp"
+# include "Profiler.hpp"
+# include "Trace.hpp"
+# include "Renderer.hpp"
+# include "ImageWriter.hpp"
+# include "Headless.hpp"
+# include "FrameCapture.hpp"
+# include "SVOStreamer.hpp"
+# include "VoxelEditor.hpp"
+# include "ThreadPool.hpp"
+# include "TLAS.hpp"
+# include "SceneLoader.hpp"
+# include "ChunkWorld.hpp"
+# include "TerrainGenerator.hpp"
+# include "ImageImporter.hpp"
+# include "MeshModel.hpp"
+# include "VoxelImporter.hpp"
 
 
 
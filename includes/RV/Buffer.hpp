@@ -15,6 +15,35 @@
 
 # include "RV.hpp"
 
+# define BUFFER_FRAMES 3
+# define STAGING_REGION_SIZE (16 * 1024 * 1024)
+
+// persistently mapped buffer cut in BUFFER_FRAMES regions, one is written
+// per frame while the gpu may still read the others, a fence per region
+// says when it can be written again
+class StreamRing
+{
+	public:
+		StreamRing(GLenum target, GLsizeiptr region_size);
+		~StreamRing();
+
+		void		nextRegion();
+		bool		allocate(GLsizeiptr size, GLintptr alignment, GLintptr &offset, void *&data);
+
+		GLuint		getID() const;
+		GLsizeiptr	getRegionSize() const;
+
+	private:
+		GLenum		_target;
+		GLuint		_buffer_id;
+		uint8_t		*_mapped;
+
+		GLsizeiptr	_region_size;
+		int			_region;
+		GLintptr	_head;
+		GLsync		_fences[BUFFER_FRAMES];
+};
+
 class Buffer
 {
 	public:
@@ -23,32 +52,39 @@ class Buffer
 			SSBO,
 			UBO
 		};
-	
-		Buffer(Type type, GLuint binding_point, GLuint size, const void *data)
-			: _type(type), _binding_point(binding_point)
+
+		// STATIC is a plain buffer, STREAM a StreamRing rebound to the written
+		// region on every update, for data that changes each frame
+		enum Mode
 		{
-			glGenBuffers(1, &_buffer_id);
-			glBindBuffer(_type == SSBO ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER, _buffer_id);
-			glBufferData(_type == SSBO ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
-			glBindBufferBase(_type == SSBO ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER, _binding_point, _buffer_id);
-			glBindBuffer(_type == SSBO ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER, 0);
-		}
-	
-		~Buffer() { glDeleteBuffers(1, &_buffer_id); }
+			STATIC,
+			STREAM
+		};
 	
-		void update(const void *data, GLuint size)
-		{
-			glBindBuffer(_type == SSBO ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER, _buffer_id);
-			glBufferSubData(_type == SSBO ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER, 0, size, data);
-			glBindBuffer(_type == SSBO ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER, 0);
-		}
+		Buffer(Type type, GLuint binding_point, GLuint size, const void *data, Mode mode = STATIC);
+		~Buffer();
 	
-		GLuint getID() const { return _buffer_id; }
+		void		update(const void *data, GLuint size);
+		void		updateRange(const void *data, GLintptr offset, GLsizeiptr size);
+
+		GLuint		getID() const;
+
+		static void	nextFrame();
+		static void	releaseStaging();
 	
 	private:
-		Type	_type;
-		GLuint	_buffer_id;
-		GLuint	_binding_point;
+		GLenum		getTarget() const;
+
+		Type		_type;
+		Mode		_mode;
+		GLuint		_buffer_id;
+		GLuint		_binding_point;
+		GLuint		_size;
+
+		StreamRing	*_ring;
+		GLintptr	_alignment;
+
+		static StreamRing	*_staging;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -52,6 +52,10 @@ class Camera
 		int			&getBounce();
 		
 		GPUCamera	getGPUData();
+		GPUCamera	&getPreviousGPUData();
+
+		bool		hasMoved();
+		void		storeGPUData();
 
 		void		setPosition(glm::vec3 position);
 		void		setDirection(float pitch, float yaw);
@@ -82,6 +86,8 @@ class Camera
 		float _fov = 90.0f;
 
 		int	_bounce = 5;
+
+		GPUCamera	_previous_gpu_data;
 };
 
 #endif
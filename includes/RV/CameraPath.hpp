@@ -0,0 +1,59 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CameraPath.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 16:31:08 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 16:31:08 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_CAMERAPATH__HPP
+# define RV_CAMERAPATH__HPP
+
+# include "RV.hpp"
+
+class Camera;
+
+struct CameraKey
+{
+	float		time;
+
+	glm::vec3	position;
+	glm::vec2	direction;
+
+	float		aperture;
+	float		focus;
+	float		fov;
+	int			bounce;
+};
+
+// timestamped camera states, one per line in a text file:
+//   time  x y z  pitch yaw  aperture focus fov  bounce
+// lines printed by the C key ("CAM ...") are read too, one second apart
+class CameraPath
+{
+	public:
+		CameraPath();
+		~CameraPath();
+
+		bool				load(const std::string &path);
+		bool				save(const std::string &path) const;
+
+		void				clear();
+		void				addKey(const CameraKey &key);
+
+		CameraKey			sample(float time) const;
+		float				getDuration() const;
+		size_t				getKeyCount() const;
+
+		static CameraKey	capture(Camera &camera, float time);
+		static void			apply(Camera &camera, const CameraKey &key);
+
+	private:
+		std::vector<CameraKey>	_keys;
+};
+
+#endif
@@ -0,0 +1,87 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ChunkWorld.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 15:02:31 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 15:02:31 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_CHUNKWORLD__HPP
+# define RV_CHUNKWORLD__HPP
+
+# include "RV.hpp"
+
+# include <mutex>
+
+// side of a chunk in voxels, chunks tile the xz plane from y 0 up
+# define CHUNK_DIM 64
+
+// room of a slot in voxels per column of its chunk, as many nodes
+# define CHUNK_SLOT_LAYERS 6
+
+class Scene;
+class PagedBuffer;
+
+struct ChunkSlot
+{
+	glm::ivec2	chunk;
+	int			model;
+	int			instance;
+	int			ticket;
+	bool		resident;
+};
+
+struct ChunkBuild
+{
+	int							slot;
+	int							ticket;
+	std::vector<FlatSVONode>	nodes;
+	std::vector<GPUVoxel>		voxels;
+};
+
+// an unbounded world of chunks around the camera in a fixed number of
+// slots: every slot is a model reserved after the flat arrays with an
+// instance moved onto its chunk, chunks the camera leaves behind hand
+// their slot to the ones coming into range, which are built from the
+// source on the shared ThreadPool and written into the slot when done
+class ChunkWorld
+{
+	public:
+		ChunkWorld(Scene &scene, int radius, ChunkSource source);
+		~ChunkWorld();
+
+		void				update(PagedBuffer &nodes, PagedBuffer &voxels);
+		bool				consumeChanges();
+
+		void				imGuiRender();
+
+		static ChunkSource	groundSource(int world_dim);
+
+	private:
+		void				build(ChunkBuild &build, glm::ivec2 chunk);
+		bool				write(const ChunkBuild &build);
+		void				request(int slot, glm::ivec2 chunk);
+		glm::ivec2			cameraChunk() const;
+		glm::mat4			chunkTransform(glm::ivec2 chunk) const;
+
+		Scene						&_scene;
+		int							_radius;
+		ChunkSource					_source;
+
+		std::vector<ChunkSlot>		_slots;
+		std::map<std::pair<int, int>, int>	_chunk_slots;
+		glm::ivec2					_center;
+
+		std::mutex					_mutex;
+		std::vector<ChunkBuild>		_ready;
+
+		int							_built;
+		int							_dropped;
+		bool						_changed;
+};
+
+#endif
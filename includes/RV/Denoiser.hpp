@@ -0,0 +1,61 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Denoiser.hpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 14:02:11 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 14:02:11 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_DENOISER__HPP
+# define RV_DENOISER__HPP
+
+# include "RV.hpp"
+
+class Shader;
+class ShaderProgram;
+
+struct GPUDenoise;
+
+// cpu side copy of the images the denoiser reads, one vec4 per pixel
+struct DenoiseImages
+{
+	glm::ivec2				resolution;
+
+	std::vector<glm::vec4>	color;
+	std::vector<glm::vec4>	normal_depth;
+	std::vector<glm::vec4>	albedo;
+	std::vector<glm::vec4>	moments;
+};
+
+// biggest difference between the gpu passes and the cpu reference that
+// --validate-denoise lets through, float rounding only
+# define DENOISE_TOLERANCE 1e-3f
+
+class Denoiser
+{
+	public:
+		Denoiser();
+		~Denoiser();
+
+		void		process(std::vector<GLuint> &textures, GPUDenoise &settings, glm::vec2 resolution);
+		float		validate(std::vector<GLuint> &textures, GPUDenoise &settings, glm::vec2 resolution);
+
+		static void	readImages(std::vector<GLuint> &textures, glm::ivec2 resolution, DenoiseImages &images);
+
+		static void	referenceVariance(const DenoiseImages &images, const GPUDenoise &settings, std::vector<glm::vec4> &dst);
+		static void	referenceAtrous(const DenoiseImages &images, const GPUDenoise &settings, int step, const std::vector<glm::vec4> &src, std::vector<glm::vec4> &dst);
+		static void	reference(DenoiseImages &images, const GPUDenoise &settings);
+
+	private:
+		Shader			*_variance_shader;
+		Shader			*_atrous_shader;
+
+		ShaderProgram	*_variance_program;
+		ShaderProgram	*_atrous_program;
+};
+
+#endif
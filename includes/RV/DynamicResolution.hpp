@@ -0,0 +1,50 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   DynamicResolution.hpp                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 10:52:09 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 10:52:09 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_DYNAMICRESOLUTION__HPP
+# define RV_DYNAMICRESOLUTION__HPP
+
+# include "RV.hpp"
+
+class DynamicResolution
+{
+	public:
+		DynamicResolution(glm::ivec2 display);
+		~DynamicResolution();
+
+		void		update(float gpu_ms);
+		void		endFrame();
+
+		glm::vec2	getResolution() const;
+		glm::vec2	getPreviousResolution() const;
+		glm::vec2	getDisplayResolution() const;
+
+		bool		&getEnabled();
+		float		&getScale();
+		float		&getTarget();
+		float		getGPUTime() const;
+
+	private:
+		void		adjust(float gpu_ms);
+
+		glm::ivec2	_display;
+		glm::vec2	_previous_resolution;
+
+		bool		_enabled = true;
+		float		_scale = 1.0f;
+		float		_min_scale = 0.25f;
+		float		_max_scale = 1.0f;
+		float		_target_ms = 16.6f;
+		float		_gpu_ms = 0.0f;
+};
+
+#endif
@@ -0,0 +1,101 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FrameCapture.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:05:19 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 17:05:19 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_FRAMECAPTURE__HPP
+# define RV_FRAMECAPTURE__HPP
+
+# include "RV.hpp"
+
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+# include <atomic>
+
+# define CAPTURE_RING_SIZE 3
+# define CAPTURE_MAX_QUEUED 8
+
+enum CaptureFormat
+{
+	CAPTURE_PNG,
+	CAPTURE_EXR
+};
+
+// one readback in flight, the fence tells when the copy into the pbo is done
+struct CaptureSlot
+{
+	GLuint			pbo;
+	GLsync			fence;
+
+	CaptureFormat	format;
+	glm::ivec2		size;
+	glm::ivec2		crop;
+	std::string		path;
+};
+
+// pixels copied out of a mapped pbo, waiting for the encoder thread
+struct CaptureJob
+{
+	CaptureFormat		format;
+	glm::ivec2			size;
+	glm::ivec2			crop;
+	std::string			path;
+	std::vector<char>	data;
+};
+
+// screenshots and image sequences without stalling the frame: the image
+// goes into a ring of pixel buffers, is mapped once its fence signaled and
+// is encoded on a worker thread, when the ring is full the frame is dropped
+class FrameCapture
+{
+	public:
+		FrameCapture(glm::ivec2 size);
+		~FrameCapture();
+
+		void			capture(GLuint output_texture, glm::vec2 render_size);
+		void			flush();
+
+		void			requestScreenshot();
+		bool			&getRecording();
+		void			setDirectory(const std::string &directory);
+		void			setFormat(CaptureFormat format);
+
+		void			imGuiRender();
+
+	private:
+		void			poll(bool wait);
+		void			worker();
+		static void		encode(CaptureJob &job);
+
+		glm::ivec2						_size;
+		std::string						_directory;
+		int								_format;
+
+		bool							_screenshot;
+		bool							_recording;
+		int								_frame;
+		int								_screenshot_count;
+
+		CaptureSlot						_slots[CAPTURE_RING_SIZE];
+		int								_next_slot;
+
+		int								_dropped;
+		std::atomic<int>				_written;
+
+		std::thread						_thread;
+		std::mutex						_mutex;
+		std::condition_variable			_condition;
+		std::queue<CaptureJob>			_jobs;
+		bool							_stop;
+		bool							_busy;
+};
+
+#endif
@@ -0,0 +1,65 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   GPUTimer.hpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 10:41:25 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 10:41:25 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_GPUTIMER__HPP
+# define RV_GPUTIMER__HPP
+
+# include "RV.hpp"
+
+// GL_TIME_ELAPSED query pair, a result is read one frame after it was
+// issued so asking for it never waits on the gpu
+class GPUTimer
+{
+	public:
+		GPUTimer() : _current(0)
+		{
+			glGenQueries(2, _queries);
+			_pending[0] = false;
+			_pending[1] = false;
+		}
+
+		~GPUTimer() { glDeleteQueries(2, _queries); }
+
+		void begin() { glBeginQuery(GL_TIME_ELAPSED, _queries[_current]); }
+
+		void end()
+		{
+			glEndQuery(GL_TIME_ELAPSED);
+			_pending[_current] = true;
+			_current ^= 1;
+		}
+
+		bool poll(float &ms)
+		{
+			if (!_pending[_current])
+				return (false);
+
+			GLint available = 0;
+			glGetQueryObjectiv(_queries[_current], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				return (false);
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(_queries[_current], GL_QUERY_RESULT, &elapsed);
+
+			_pending[_current] = false;
+			ms = static_cast<float>(elapsed) / 1000000.0f;
+			return (true);
+		}
+
+	private:
+		GLuint	_queries[2];
+		bool	_pending[2];
+		int		_current;
+};
+
+#endif
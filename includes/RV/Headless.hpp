@@ -0,0 +1,45 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Headless.hpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 15:40:11 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 15:40:11 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_HEADLESS__HPP
+# define RV_HEADLESS__HPP
+
+# define EGL_NO_X11
+# include "RV.hpp"
+
+# include <EGL/egl.h>
+# include <EGL/eglext.h>
+
+// offscreen gl context through EGL (surfaceless when the driver has it, so
+// llvmpipe works without any display), rendering goes to its own framebuffer
+class HeadlessContext
+{
+	public:
+		HeadlessContext(glm::ivec2 size);
+		~HeadlessContext();
+
+		void		bindFramebuffer();
+		void		readPixels(std::vector<uint8_t> &pixels);
+
+		glm::ivec2	getSize() const;
+
+	private:
+		EGLDisplay	_display;
+		EGLContext	_context;
+
+		GLuint		_framebuffer;
+		GLuint		_color;
+
+		glm::ivec2	_size;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ImageImporter.hpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 10:42:18 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 10:42:18 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_IMAGEIMPORTER__HPP
+# define RV_IMAGEIMPORTER__HPP
+
+# include "RV.hpp"
+
+// rows of the heightmap, or slices of the stack, one task builds into its
+// own tree before the trees are merged
+# define IMPORT_BAND 32
+
+// the heightmap spans this fraction of the world side from black to white
+# define HEIGHTMAP_HEIGHT 0.25f
+
+// stack pixels at least this bright and this opaque are solid
+# define STACK_THRESHOLD 96
+
+class SVO;
+
+// worlds from images through stb_image, only the cells that touch air are
+// kept and go straight into a tree, bands build in parallel on the shared
+// ThreadPool and keep no more than a few rows or slices around, so the
+// volume is never dense in memory; images larger than the world are
+// sampled down by a whole step to fit it
+class ImageImporter
+{
+	public:
+		static bool	isImage(const std::string &path);
+
+		// a greyscale image, 8 or 16 bit, brightness is the height
+		static SVO	*heightmap(const std::string &path, int world_dim);
+
+		// a directory of slices sorted by name, bottom first, each slice
+		// is one layer of the volume
+		static SVO	*stack(const std::string &path, int world_dim);
+
+	private:
+		static int	sampleStep(glm::ivec3 size, int world_dim);
+};
+
+#endif
@@ -0,0 +1,32 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ImageWriter.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 15:52:29 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 15:52:29 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_IMAGEWRITER__HPP
+# define RV_IMAGEWRITER__HPP
+
+# include "RV.hpp"
+
+// 8 bit png and float rgb exr without any dependency, neither is compressed
+// (png only uses stored deflate blocks) so files are big but cheap to write
+class ImageWriter
+{
+	public:
+		static bool	writePNG(const std::string &path, glm::ivec2 size, int channels, const uint8_t *pixels);
+		static bool	writeEXR(const std::string &path, glm::ivec2 size, const float *rgb);
+
+	private:
+		static uint32_t	crc32(uint32_t crc, const uint8_t *data, size_t size);
+		static uint32_t	adler32(uint32_t adler, const uint8_t *data, size_t size);
+		static void		writeChunk(std::ofstream &file, const char *type, const std::vector<uint8_t> &data);
+};
+
+#endif
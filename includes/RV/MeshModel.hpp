@@ -0,0 +1,73 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MeshModel.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 14:03:51 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 14:03:51 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_MESHMODEL__HPP
+# define RV_MESHMODEL__HPP
+
+# include "RV.hpp"
+
+// side of the cubes of cells the triangles are binned into, one tile is
+// voxelized by one task
+# define MESH_TILE 32
+
+// kd color and map_Kd of an obj material, texture is rgba, rows top first
+struct MeshMaterial
+{
+	glm::vec3				color;
+	glm::ivec2				texture_size;
+	std::vector<uint8_t>	texture;
+};
+
+// material -1 is plain white, vertex colors are white when the file has none
+struct MeshTriangle
+{
+	glm::vec3	position[3];
+	glm::vec2	uv[3];
+	glm::vec3	color[3];
+	int			material;
+};
+
+class SVO;
+
+// an obj (with its mtl) or ply (ascii or binary little endian) file as
+// triangles, polygons are split in fans
+class MeshModel
+{
+	public:
+		MeshModel(const std::string &path);
+
+		static bool	isMesh(const std::string &path);
+
+		const bool	&isParsed() const;
+		glm::vec3	getMin() const;
+		glm::vec3	getMax() const;
+		size_t		getTriangleCount() const;
+
+		// every cell of the world box a triangle touches once transform takes
+		// the mesh to world voxels, colored from the nearest triangle
+		SVO			*voxelize(const glm::mat4 &transform, int world_dim, glm::vec3 tint) const;
+
+	private:
+		bool		parseOBJ(const std::string &path);
+		void		parseMTL(const std::string &path, std::map<std::string, int> &names);
+		bool		parsePLY(const std::string &path);
+		void		addPolygon(const std::vector<glm::vec3> &positions, const std::vector<glm::vec2> &uvs, const std::vector<glm::vec3> &colors, int material);
+		glm::vec3	sample(const MeshTriangle &triangle, glm::vec3 weights) const;
+
+		bool						_parsed;
+		glm::vec3					_min;
+		glm::vec3					_max;
+		std::vector<MeshTriangle>	_triangles;
+		std::vector<MeshMaterial>	_materials;
+};
+
+#endif
@@ -0,0 +1,53 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   PagedBuffer.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:40:26 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 18:40:26 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_PAGEDBUFFER__HPP
+# define RV_PAGEDBUFFER__HPP
+
+# include "RV.hpp"
+
+// same values as shaders/paging.glsl
+# define PAGE_COUNT 4
+# define NODE_PAGE_BINDING 0
+# define VOXEL_PAGE_BINDING 4
+
+class Buffer;
+
+// an array split over PAGE_COUNT ssbos so no single block goes over
+// GL_MAX_SHADER_STORAGE_BLOCK_SIZE, element i lives in page i >> shift
+class PagedBuffer
+{
+	public:
+		PagedBuffer(GLuint first_binding, size_t element_size, size_t count, const void *data, size_t max_page_bytes = 0);
+		~PagedBuffer();
+
+		void		updateRange(const void *data, size_t first, size_t count);
+
+		int			getPageShift() const;
+		int			getPageCount() const;
+		size_t		getCount() const;
+		bool		isComplete() const;
+
+		static int		pageShift(size_t element_size, size_t max_page_bytes);
+		static size_t	capacity(size_t element_size);
+
+	private:
+		GLuint					_first_binding;
+		size_t					_element_size;
+		size_t					_count;
+		int						_shift;
+		bool					_complete;
+
+		std::vector<Buffer *>	_pages;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Profiler.hpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 11:20:33 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 11:20:33 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_PROFILER__HPP
+# define RV_PROFILER__HPP
+
+# include "RV.hpp"
+
+# define PROFILER_HISTORY 240
+
+class GPUTimer;
+
+struct ProfileSection
+{
+	std::string	name;
+	const char	*trace_name;
+
+	GPUTimer	*gpu;
+	std::chrono::steady_clock::time_point	cpu_start;
+
+	float		gpu_history[PROFILER_HISTORY];
+	float		cpu_history[PROFILER_HISTORY];
+	int			gpu_count;
+	int			cpu_count;
+
+	int			used_frame;
+};
+
+struct ProfileStats
+{
+	float	min;
+	float	avg;
+	float	p99;
+	float	last;
+};
+
+// per pass timings, gpu ones come from query pairs read a frame late so the
+// render loop never waits on them, passes with a gpu timer can not be nested,
+// the cpu side also goes to the TraceRecorder when tracing is on
+class Profiler
+{
+	public:
+		Profiler();
+		~Profiler();
+
+		void			newFrame();
+
+		void			begin(const std::string &name, bool gpu);
+		void			end(const std::string &name);
+
+		ProfileStats	getGPUStats(const std::string &name) const;
+		ProfileStats	getCPUStats(const std::string &name) const;
+		float			getLatestGPUTime(const std::string &name) const;
+
+		void			imGuiRender();
+		void			writeStats(std::ostream &out) const;
+
+	private:
+		ProfileSection	*getSection(const std::string &name, bool gpu);
+		ProfileStats	computeStats(const float *history, int count) const;
+
+		std::vector<ProfileSection *>			_sections;
+		std::map<std::string, ProfileSection *>	_by_name;
+
+		int										_frame;
+};
+
+class ProfileScope
+{
+	public:
+		ProfileScope(Profiler &profiler, const std::string &name, bool gpu = true)
+			: _profiler(profiler), _name(name)
+		{
+			_profiler.begin(_name, gpu);
+		}
+
+		~ProfileScope() { _profiler.end(_name); }
+
+	private:
+		Profiler	&_profiler;
+		std::string	_name;
+};
+
+#endif
@@ -0,0 +1,110 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Renderer.hpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 15:12:40 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 15:12:40 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_RENDERER__HPP
+# define RV_RENDERER__HPP
+
+# include "RV.hpp"
+
+class Scene;
+class Buffer;
+class PagedBuffer;
+class Shader;
+class ShaderProgram;
+class Reprojection;
+class Denoiser;
+class DynamicResolution;
+class Profiler;
+class FrameCapture;
+class SVOStreamer;
+class VoxelEditor;
+class TLAS;
+class SceneLoader;
+class ChunkWorld;
+
+// what the frontend (window or headless loop) decides for the coming frame
+struct FrameSettings
+{
+	int		frame_count;
+	int		max_history;
+	bool	accumulate;
+
+	AovView	view;
+	int		aov_mask;
+	int		output_texture;
+
+	float	lod_bias;
+
+	bool	validate_denoise;
+	bool	readback_aov;
+
+	float	time;
+};
+
+// every gpu pass of a frame, without anything tied to a window so it can
+// run on an offscreen context as well
+class Renderer
+{
+	public:
+		Renderer(Scene &scene, glm::ivec2 display, int stream_slots = 0, int chunk_radius = 0, SceneLoader *loader = nullptr);
+		~Renderer();
+
+		void					beginFrame();
+		void					render(const FrameSettings &settings);
+		void					present(const FrameSettings &settings);
+		void					endFrame();
+
+		ShaderProgram			&getRaytracingProgram();
+		DynamicResolution		&getResolution();
+		Profiler				&getProfiler();
+		FrameCapture			&getCapture();
+		SVOStreamer				*getStreamer();
+		VoxelEditor				*getEditor();
+		TLAS					*getTLAS();
+		ChunkWorld				*getChunks();
+		SceneLoader				*getLoader();
+		std::vector<GLuint>		&getTextures();
+		float					getDenoiseError() const;
+
+	private:
+		void					attachScene();
+
+		Scene					&_scene;
+
+		GLuint					_vao;
+		std::vector<GLuint>		_textures;
+		std::vector<Buffer *>	_buffers;
+		std::vector<PagedBuffer *>	_paged_buffers;
+
+		Shader					*_compute_shader;
+		Shader					*_vertex_shader;
+		Shader					*_fragment_shader;
+
+		ShaderProgram			*_raytracing_program;
+		ShaderProgram			*_render_program;
+
+		Reprojection			*_reprojection;
+		Denoiser				*_denoiser;
+		DynamicResolution		*_resolution;
+		Profiler				*_profiler;
+		FrameCapture			*_capture;
+		SVOStreamer				*_streamer;
+		VoxelEditor				*_editor;
+		TLAS					*_tlas;
+		ChunkWorld				*_chunks;
+		SceneLoader				*_loader;
+		int						_stream_slots;
+		int						_chunk_radius;
+		float					_denoise_error;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Reprojection.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 16:12:48 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 16:12:48 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_REPROJECTION__HPP
+# define RV_REPROJECTION__HPP
+
+# include "RV.hpp"
+
+class Shader;
+class ShaderProgram;
+
+class Reprojection
+{
+	public:
+		Reprojection();
+		~Reprojection();
+
+		void	process(std::vector<GLuint> &textures, glm::vec2 resolution, glm::vec2 previous_resolution, int frame_count, int max_history, float voxel_size);
+
+	private:
+		void	storeHistory(std::vector<GLuint> &textures, glm::vec2 resolution);
+
+		Shader			*_temporal_shader;
+		ShaderProgram	*_temporal_program;
+};
+
+#endif
@@ -18,11 +18,13 @@
 struct FlatSVONode
 {
 	alignas(16) glm::ivec3 min;
+    int color;         // Mean color of the subtree as 0xRRGGBBAA, alpha is how much of a face it covers.
 	alignas(16) glm::ivec3 max;
     int childOffset;   // If not a leaf, the index where the children start in the flat node array.
     int voxelIndex;    // If a leaf, the index into the voxel array.
     int voxelCount;    // Number of voxels stored in this leaf.
     uint8_t childMask; // Bits 0-7: each bit indicates existence of a child.
+    int normal;        // Mean normal of the subtree, glm::packSnorm4x8.
 };
 
 class GPUVoxel;
@@ -34,20 +36,27 @@ class SVO
 		~SVO();
 
 		bool insert(GPUVoxel &voxel, int depth);
+		void merge(SVO *other, int depth);
+		static SVO *mergeAll(std::vector<SVO *> &trees);
 		bool contains(GPUVoxel &voxel);
 		void subdivide();
 
 		void flatten(std::vector<FlatSVONode> &flatNodes, std::vector<GPUVoxel> &flatVoxels);
+		static void aggregate(std::vector<FlatSVONode> &flatNodes, const std::vector<GPUVoxel> &flatVoxels, int index);
 
 		void print(int level);
 		
 		bool isLeaf();
+		SVO *getChild(int index);
 
 		int	getNodeCount();
 		
 
 
 	private:
+		bool place(GPUVoxel &voxel, int depth, bool replace);
+		void swapContent(SVO *other);
+
 		SVO *_children[8];
 
 		std::vector<GPUVoxel> _voxels;
@@ -0,0 +1,127 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SVOStreamer.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 10:12:40 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 10:12:40 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_SVOSTREAMER__HPP
+# define RV_SVOSTREAMER__HPP
+
+# include "RV.hpp"
+
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+
+// same values as shaders/svo.glsl
+# define STREAM_TABLE_BINDING 8
+# define STREAM_PROXY -2
+
+# define STREAM_SLOT_NODES 4096
+# define STREAM_SLOT_VOXELS 16384
+# define STREAM_LOADS_PER_FRAME 8
+# define STREAM_FEEDBACK_FRAMES 3
+
+class Scene;
+class Buffer;
+class PagedBuffer;
+class ShaderProgram;
+
+// one per brick, slot is written by the cpu, last_used by the rays that
+// reach the brick proxy, the whole table is read back as feedback
+struct StreamEntry
+{
+	int		slot;
+	int		last_used;
+};
+
+// where a brick is in the cache file, indices inside are brick local
+struct StreamBrick
+{
+	uint64_t	offset;
+	int			node_count;
+	int			voxel_count;
+};
+
+// a brick read from the cache and relocated into its pool slot
+struct StreamLoad
+{
+	int							brick;
+	int							slot;
+	std::vector<FlatSVONode>	nodes;
+	std::vector<GPUVoxel>		voxels;
+};
+
+// out of core svo: subtrees small enough to fit a pool slot are cut off
+// into a mapped cache file and replaced by proxy nodes holding their
+// averages, the gpu keeps the top tree plus a fixed pool of slots, rays that
+// reach a proxy mark it in the table and stop on its averages until a
+// worker thread brought the brick in, the least recently used go first,
+// with a stream source the bricks are cut from it and never all in memory
+class SVOStreamer
+{
+	public:
+		SVOStreamer(Scene &scene, int slots, const std::string &cache_path);
+		~SVOStreamer();
+
+		void			update(PagedBuffer &nodes, PagedBuffer &voxels);
+		void			setUniforms(ShaderProgram &program) const;
+
+		void			imGuiRender();
+
+	private:
+		void			split(Scene &scene, std::vector<FlatSVONode> &top_nodes, std::vector<GPUVoxel> &top_voxels);
+		void			build(Scene &scene, std::vector<FlatSVONode> &top_nodes, std::vector<GPUVoxel> &top_voxels);
+		void			attach(Scene &scene, std::vector<FlatSVONode> &top_nodes, std::vector<GPUVoxel> &top_voxels);
+		bool			mapCache();
+
+		void			readFeedback();
+		void			request();
+		int				findSlot();
+		void			upload(PagedBuffer &nodes, PagedBuffer &voxels);
+
+		void			worker();
+		void			load(StreamLoad &load);
+
+		std::string						_cache_path;
+		std::vector<StreamBrick>		_bricks;
+
+		int								_fd;
+		const uint8_t					*_mapped;
+		size_t							_mapped_size;
+
+		int								_top_nodes;
+		int								_top_voxels;
+		int								_slot_count;
+
+		std::vector<int>				_resident;
+		std::vector<int>				_last_used;
+		std::vector<bool>				_pending;
+		std::vector<int>				_slot_brick;
+
+		Buffer							*_table;
+		GLuint							_readback[STREAM_FEEDBACK_FRAMES];
+		GLsync							_fences[STREAM_FEEDBACK_FRAMES];
+		int								_readback_frame[STREAM_FEEDBACK_FRAMES];
+
+		int								_frame;
+		int								_seen_frame;
+
+		int								_loads;
+		int								_evictions;
+
+		std::thread						_thread;
+		std::mutex						_mutex;
+		std::condition_variable			_condition;
+		std::queue<StreamLoad>			_jobs;
+		std::queue<StreamLoad>			_done;
+		bool							_stop;
+};
+
+#endif
@@ -43,38 +43,157 @@ struct GPUDebug
 	int	box_treshold;
 };
 
+struct GPUDenoise
+{
+	int		enabled;
+	int		temporal;
+	int		iterations;
+
+	float	phi_color;
+	float	phi_normal;
+	float	phi_depth;
+	float	phi_albedo;
+	float	alpha;
+};
+
 struct FlatSVONode;
 
+// a shape loaded once, its trees live in flatNodes/flatVoxels after the
+// world in one range starting at first_node, an animated shape has a root
+// per frame and the frames share the subtrees that did not change
+struct SceneModel
+{
+	std::string			path;
+	std::vector<int>	chunks;
+	glm::ivec3			size;
+	int					root;
+	std::vector<int>	frame_roots;
+	int					first_node;
+	int					first_voxel;
+	int					node_count;
+	int					voxel_count;
+};
+
+// the shapes of a vox file, each transform places a model in [0, size]
+struct SceneModelFile
+{
+	std::string				path;
+	glm::ivec3				size;
+	std::vector<int>		models;
+	std::vector<glm::mat4>	transforms;
+};
+
+// a named view from a scene file, in world units like the camera
+struct CameraPreset
+{
+	std::string	name;
+	glm::vec3	position;
+	float		pitch;
+	float		yaw;
+};
+
+// a model, mesh or instance line of a scene file, in world units,
+// resolution is the longest side in voxels of a mesh, 0 for vox models
+struct SceneFileEntry
+{
+	std::string	path;
+	glm::vec3	position;
+	float		yaw;
+	float		scale;
+	glm::vec3	tint;
+	int			resolution;
+};
+
+// what a scene file sets besides the world voxels, read with the tree and
+// applied by applySetup once the tree is in the flat arrays
+struct SceneSetup
+{
+	std::vector<GPUMaterial>	materials;
+	std::vector<SceneFileEntry>	instances;
+	std::vector<CameraPreset>	cameras;
+};
+
+// transform goes from the model voxel grid to world voxels
+struct SceneInstance
+{
+	int			model;
+	glm::mat4	transform;
+};
+
 class Camera;
 class VoxModel;
+class SVO;
 
 class Scene
 {
 	public:
-		Scene();
+		Scene(int world_dim = VOXEL_DIM, float voxel_size = VOXEL_SIZE);
 		~Scene();
 
 		void							parseScene(std::string &name);
-		void							placeModel(VoxModel &model, glm::ivec3 position, std::vector<GPUVoxel> &voxel_data);
+		bool							streamScene(std::string &name);
+		void							applySetup(const SceneSetup &setup);
+
+		SVO								*buildWorld(const std::string &name, SceneSetup &setup) const;
+		static SVO						*placeModel(VoxModel &model, glm::ivec3 position, int world_dim);
 
 		void							addMaterial(GPUMaterial material);
 		
 		std::vector<GPUMaterial>		&getMaterialData();
 		GPUDebug						&getDebug(void);
+		GPUDenoise						&getDenoise(void);
 
 		Camera							*getCamera(void) const;
+		int								getWorldDim(void) const;
+		float							getVoxelSize(void) const;
 		GPUMaterial						getMaterial(int material_index);
 
+		void							setChunkSource(const ChunkSource &source);
+		const ChunkSource				&getChunkSource(void) const;
+		const ChunkSource				&getStreamSource(void) const;
+
+		const std::vector<CameraPreset>	&getCameraPresets(void) const;
+		void							applyCameraPreset(int index);
+
+		int								loadModel(const std::string &path);
+		int								addInstance(int file, const glm::mat4 &transform);
+		int								reserveModel(glm::ivec3 size, int node_count, int voxel_count);
+		int								addModelInstance(int model, const glm::mat4 &transform);
+		void							setInstanceTransform(int instance, const glm::mat4 &transform, bool rebuild = false);
+		bool							consumeInstanceChanges(bool &added);
+
+		std::vector<SceneModel>			&getModels(void);
+		const std::vector<SceneModelFile>	&getModelFiles(void) const;
+		const std::vector<SceneInstance>	&getInstances(void) const;
+
+		static glm::mat4				instanceTransform(glm::ivec3 size, glm::vec3 position, float yaw, float scale);
+
 		std::vector<FlatSVONode> flatNodes;
 		std::vector<GPUVoxel> flatVoxels;
 		
 	private:
 
+		int							_world_dim;
+		float						_voxel_size;
+
 		std::vector<GPUMaterial>	_gpu_materials;
 
 		GPUDebug					_gpu_debug;
+		GPUDenoise					_gpu_denoise;
 
 		Camera						*_camera;
+
+		int							buildModel(VoxModel &model, const std::string &path, const std::vector<int> &chunks);
+
+		std::vector<CameraPreset>	_camera_presets;
+		ChunkSource					_chunk_source;
+		ChunkSource					_stream_source;
+
+		std::vector<SceneModel>		_models;
+		std::vector<SceneModelFile>	_model_files;
+		std::vector<SceneInstance>	_instances;
+		bool						_instances_added;
+		bool						_instances_moved;
 };
 
 #endif
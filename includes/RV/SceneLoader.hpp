@@ -0,0 +1,89 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SceneLoader.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 13:58:10 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 13:58:10 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_SCENELOADER__HPP
+# define RV_SCENELOADER__HPP
+
+# include "RV.hpp"
+
+# include <thread>
+# include <mutex>
+# include <atomic>
+
+// the world is cut two levels below the root, each of these bricks is
+// flattened on its own and spliced into the tree when it is done
+# define LOADER_BRICKS 64
+# define LOADER_FIRST_BRICK 9
+
+// nodes spliced per frame at most, a brick is never split across frames
+# define LOADER_FRAME_NODES (1 << 18)
+
+class Scene;
+class PagedBuffer;
+struct SceneSetup;
+
+struct LoaderBrick
+{
+	int							slot;
+	std::vector<FlatSVONode>	nodes;
+	std::vector<GPUVoxel>		voxels;
+};
+
+// loads a scene while frames are drawn: the flat arrays start as the root
+// and the two levels of empty bricks, a thread builds the world tree and
+// flattens its bricks on the shared ThreadPool, nearest to the camera
+// first, update() appends the finished ones on the main thread and
+// uploads what it touched, the scene setup and the --instance models are
+// applied once every brick is in
+class SceneLoader
+{
+	public:
+		SceneLoader(Scene &scene, const std::string &name, const std::vector<std::string> &instances);
+		~SceneLoader();
+
+		bool		update(PagedBuffer &nodes, PagedBuffer &voxels);
+		bool		consumeChanges();
+		bool		isDone() const;
+		void		stop();
+
+		void		imGuiRender();
+
+	private:
+		void		build();
+		bool		splice(const LoaderBrick &brick);
+		void		finish();
+
+		Scene						&_scene;
+		std::string					_name;
+		std::vector<std::string>	_instances;
+		std::vector<int>			_order;
+
+		std::thread					_thread;
+		std::mutex					_mutex;
+		std::queue<LoaderBrick>		_ready;
+		std::atomic<bool>			_built;
+		std::atomic<bool>			_cancel;
+		SceneSetup					*_setup;
+
+		size_t						_node_end;
+		size_t						_voxel_end;
+		int							_spliced;
+		bool						_changed;
+		bool						_done;
+		bool						_stopped;
+
+		std::chrono::high_resolution_clock::time_point	_start;
+		float						_first_brick_ms;
+		float						_load_ms;
+};
+
+#endif
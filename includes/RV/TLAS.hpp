@@ -0,0 +1,89 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TLAS.hpp                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 13:18:49 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 13:18:49 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_TLAS__HPP
+# define RV_TLAS__HPP
+
+# include "RV.hpp"
+
+// same values as shaders/svo.glsl
+# define TLAS_NODE_BINDING 9
+# define INSTANCE_BINDING 10
+# define TLAS_LEAF_SIZE 2
+# define TLAS_MAX_LEAF 8
+# define TLAS_MAX_DEPTH 30
+# define TLAS_BINS 16
+# define TLAS_TASK_MIN 4096
+# define ANIMATION_FPS 10
+
+class Scene;
+class Buffer;
+class ShaderProgram;
+
+// root is the model tree in the node array, rays are moved into the model
+// grid with world_to_model and the hit comes back with model_to_world
+struct alignas(16) GPUInstance
+{
+	glm::mat4	world_to_model;
+	glm::mat4	model_to_world;
+	int			root;
+};
+
+// world voxel bounds, an inner node has its children at left_first and
+// left_first + 1, a leaf has count instances from left_first
+struct GPUTLASNode
+{
+	alignas(16) glm::vec3	min;
+	int						left_first;
+	alignas(16) glm::vec3	max;
+	int						count;
+};
+
+// top level over the scene instances, the model trees below never change
+// so moving an instance only refits the boxes up to the root, built with
+// binned sah, the first splits on this thread and the subtrees below them
+// on the shared ThreadPool, an animated model plays by swapping the root of
+// its instances, one int per instance and frame change
+class TLAS
+{
+	public:
+		TLAS();
+		~TLAS();
+
+		void			update(Scene &scene);
+		void			animate(Scene &scene, float time);
+		void			setUniforms(ShaderProgram &program) const;
+
+		int				getInstanceCount() const;
+		int				getNodeCount() const;
+		float			getBuildTime() const;
+
+	private:
+		void			build(const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs);
+		void			refit(const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs);
+		void			upload(Scene &scene);
+
+		std::vector<GPUTLASNode>	_nodes;
+		std::vector<int>			_order;
+
+		Buffer						*_node_buffer;
+		Buffer						*_instance_buffer;
+		size_t						_node_capacity;
+		size_t						_instance_capacity;
+
+		float						_build_time;
+
+		int									_frame;
+		std::vector<std::pair<int, int>>	_animated;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TerrainGenerator.hpp                               :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 16:04:55 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 16:04:55 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_TERRAINGENERATOR__HPP
+# define RV_TERRAINGENERATOR__HPP
+
+# include "RV.hpp"
+
+// noise is evaluated this many points at a time, one sse or neon register
+# define NOISE_LANES 4
+
+// caves are sampled on a lattice of this step and interpolated in between
+# define CAVE_STEP 4
+# define CAVE_THRESHOLD 0.3f
+
+// a column of a chunk is one bit per cell
+# define TERRAIN_HEIGHT CHUNK_DIM
+
+// the radius --terrain uses when --chunks is not given
+# define TERRAIN_RADIUS 4
+
+// heights, biomes and caves from seeded gradient noise, same seed same
+// world, a chunk only needs its own columns and a border of one so chunks
+// build independently on any thread, only the cells that touch air are
+// emitted and straight into the chunk tree
+class TerrainGenerator
+{
+	public:
+		TerrainGenerator(uint32_t seed);
+
+		void		generate(glm::ivec3 origin, std::vector<GPUVoxel> &voxels) const;
+		int			getHeight(int x, int z) const;
+		ChunkSource	getSource() const;
+
+	private:
+		void		columns(glm::ivec2 origin, int side, std::vector<int> &heights, std::vector<float> &temperature, std::vector<float> &moisture) const;
+		void		caves(glm::ivec3 origin, std::vector<float> &density) const;
+
+		uint32_t	_seed;
+};
+
+#endif
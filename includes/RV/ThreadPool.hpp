@@ -0,0 +1,52 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ThreadPool.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 13:26:32 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 13:26:32 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_THREADPOOL__HPP
+# define RV_THREADPOOL__HPP
+
+# include "RV.hpp"
+
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+# include <atomic>
+
+// fixed set of workers for cpu work that splits into independent jobs,
+// wait() blocks until every submitted job is done, shared() is the pool
+// the whole program uses so builds don't each spawn their own threads
+class ThreadPool
+{
+	public:
+		ThreadPool(int threads = 0);
+		~ThreadPool();
+
+		void			submit(std::function<void()> job);
+		void			wait();
+		void			parallelFor(int count, const std::function<void(int, int)> &job);
+
+		int				getThreadCount() const;
+
+		static ThreadPool	&shared();
+
+	private:
+		void			worker(int index);
+
+		std::vector<std::thread>			_threads;
+		std::mutex							_mutex;
+		std::condition_variable				_condition;
+		std::condition_variable				_idle;
+		std::queue<std::function<void()>>	_jobs;
+		int									_running;
+		bool								_stop;
+};
+
+#endif
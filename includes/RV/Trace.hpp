@@ -0,0 +1,92 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Trace.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 14:02:11 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 14:02:11 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_TRACE__HPP
+# define RV_TRACE__HPP
+
+# include "RV.hpp"
+
+# include <atomic>
+# include <mutex>
+
+# define TRACE_EVENTS_PER_THREAD 65536
+
+# define RV_TRACE_CONCAT_(a, b) a##b
+# define RV_TRACE_CONCAT(a, b) RV_TRACE_CONCAT_(a, b)
+# define RV_TRACE_SCOPE(name) TraceScope RV_TRACE_CONCAT(_trace_scope_, __LINE__)(name)
+
+struct TraceEvent
+{
+	const char	*name;
+	int64_t		start_ns;
+	int64_t		duration_ns;
+};
+
+// one per thread, only its owner writes so recording takes no lock, when
+// it wraps the oldest events are overwritten
+struct TraceThread
+{
+	std::vector<TraceEvent>	events;
+	std::atomic<uint64_t>	head;
+	int						id;
+	std::string				name;
+};
+
+// scoped cpu markers dumped as a chrome trace json (chrome://tracing or
+// ui.perfetto.dev), event names must outlive the call to write(), intern()
+// gives such a copy of a runtime string
+class TraceRecorder
+{
+	public:
+		static void		enable(size_t events_per_thread = TRACE_EVENTS_PER_THREAD);
+		static bool		isEnabled() { return (_enabled.load(std::memory_order_relaxed)); }
+
+		static void		setThreadName(const std::string &name);
+		static const char	*intern(const std::string &name);
+		static void		record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+		static bool		write(const std::string &path);
+
+	private:
+		static TraceThread	*getThread();
+
+		static std::atomic<bool>							_enabled;
+		static size_t										_capacity;
+		static std::chrono::steady_clock::time_point		_epoch;
+
+		static std::mutex									_threads_mutex;
+		static std::vector<std::unique_ptr<TraceThread>>	_threads;
+		static std::set<std::string>						_names;
+};
+
+class TraceScope
+{
+	public:
+		TraceScope(const char *name) : _name(name), _active(TraceRecorder::isEnabled())
+		{
+			if (_active)
+				_start = std::chrono::steady_clock::now();
+		}
+
+		~TraceScope()
+		{
+			if (_active)
+				TraceRecorder::record(_name, _start, std::chrono::steady_clock::now());
+		}
+
+	private:
+		const char								*_name;
+		bool									_active;
+		std::chrono::steady_clock::time_point	_start;
+};
+
+#endif
@@ -21,13 +21,23 @@ struct Voxel
 	uint8_t paletteIndex;
 };
 
+// one shape of the file, in y up order: voxels[z][y][x]
 struct VoxChunk
 {
 	int width, height, depth;
-    int offset_x, offset_y, offset_z;
 	std::vector<std::vector<std::vector<Voxel>>> voxels;
 };
 
+// a shape placed by the scene graph, transform goes from the chunk grid to
+// the file space (y up), a cell lands on the cell MagicaVoxel puts it on,
+// an animated shape has the chunk of every frame in frames
+struct VoxInstance
+{
+	int					chunk;
+	glm::mat4			transform;
+	std::vector<int>	frames;
+};
+
 class VoxModel
 {
 	public:
@@ -37,13 +47,18 @@ class VoxModel
 		static bool parseVoxFile(const std::string& filename, VoxModel& model);
 
 		glm::ivec3				&getSize();
+		glm::ivec3				getMin() const;
 
 		std::vector<VoxChunk>	&getChunks();
+		std::vector<VoxInstance>	&getInstances();
+		int						getFrameCount() const;
 		const uint32_t			*getPalette() const;
 
 		const bool				&isParsed() const;
 
 		void					setSize(glm::ivec3 size);
+		void					setMin(glm::ivec3 min);
+		void					setFrameCount(int frame_count);
 		void					setPalette(uint32_t palette[256]);
 
 
@@ -51,8 +66,11 @@ class VoxModel
 		bool					_parsed;
 
 		glm::ivec3				_size;
+		glm::ivec3				_min;
 
 		std::vector<VoxChunk>	_chunks;
+		std::vector<VoxInstance>	_instances;
+		int						_frame_count;
 
 		bool					_hasPalette;
 		uint32_t				_palette[256];
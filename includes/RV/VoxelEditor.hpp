@@ -0,0 +1,99 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   VoxelEditor.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 11:02:17 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 11:02:17 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_VOXELEDITOR__HPP
+# define RV_VOXELEDITOR__HPP
+
+# include "RV.hpp"
+
+// same split rule as SVO::insert
+# define EDIT_LEAF_VOXELS 8
+
+// spare room left behind the flat arrays for edits before they have to grow
+# define EDIT_NODE_HEADROOM 65536
+# define EDIT_VOXEL_HEADROOM 262144
+
+class Scene;
+class PagedBuffer;
+
+enum EditMode
+{
+	EDIT_ADD,
+	EDIT_REMOVE,
+	EDIT_PAINT
+};
+
+// edits the flattened svo in place: a leaf that grows gets a new voxel
+// range and splits past EDIT_LEAF_VOXELS, emptied leaves fold back into
+// their parent, freed child groups and voxel ranges go to free lists,
+// normals around the edit and the lod averages above it are redone and
+// only the elements that changed are uploaded
+class VoxelEditor
+{
+	public:
+		VoxelEditor(Scene &scene);
+		~VoxelEditor();
+
+		bool		setVoxel(glm::ivec3 position, int color);
+		bool		clearVoxel(glm::ivec3 position);
+		int			setRegion(glm::ivec3 min, glm::ivec3 max, int color);
+		int			clearRegion(glm::ivec3 min, glm::ivec3 max);
+		int			applySphere(glm::ivec3 center, int radius, EditMode mode, int color);
+
+		int			findVoxel(glm::ivec3 position) const;
+		bool		raycast(glm::vec3 origin, glm::vec3 direction, glm::ivec3 &hit, glm::ivec3 &before) const;
+
+		bool		upload(PagedBuffer &nodes, PagedBuffer &voxels);
+
+		float		getLastEditTime() const;
+		size_t		getLastUploadBytes() const;
+		bool		isFull() const;
+
+	private:
+		int			descend(glm::ivec3 position, std::vector<int> &path) const;
+
+		bool		add(glm::ivec3 position, int color);
+		bool		remove(glm::ivec3 position);
+		void		finish();
+
+		void		buildLeaf(int index, std::vector<GPUVoxel> &voxels);
+		void		updateNormal(glm::ivec3 position);
+
+		bool		reserve();
+		int			allocateNodes();
+		int			allocateVoxels(int count);
+		void		freeNodes(int offset);
+		void		freeVoxels(int index, int count);
+
+		void		touch(const std::vector<int> &path);
+		void		markNode(int index);
+		void		markVoxels(int index, int count);
+
+		Scene							&_scene;
+
+		size_t							_node_end;
+		size_t							_voxel_end;
+		std::vector<int>				_free_nodes;
+		std::vector<int>				_free_voxels[EDIT_LEAF_VOXELS + 1];
+		bool							_grown;
+		bool							_full;
+
+		std::vector<glm::ivec3>			_normal_queue;
+		std::set<std::pair<int, int>>	_stale;
+		std::vector<int>				_dirty_nodes;
+		std::vector<int>				_dirty_voxels;
+
+		float							_last_edit_ms;
+		size_t							_last_upload_bytes;
+};
+
+#endif
@@ -0,0 +1,46 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   VoxelImporter.hpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 11:27:04 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 11:27:04 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RV_VOXELIMPORTER__HPP
+# define RV_VOXELIMPORTER__HPP
+
+# include "RV.hpp"
+
+// Ace of Spades maps are always this wide and this high
+# define VXL_SIDE 512
+# define VXL_HEIGHT 64
+
+// binvox files carry no color
+# define BINVOX_COLOR 0xBEBEBEFF
+
+class SVO;
+
+// Qubicle (.qb), binvox and Ace of Spades (.vxl) files, the runs of the
+// files are decoded slice by slice (column by column for vxl) with only
+// the slices around the current one kept, and only the cells that touch
+// air become voxels, models stand on the ground in the middle of the
+// world, maps are centered on it
+class VoxelImporter
+{
+	public:
+		static bool	isVoxelFile(const std::string &path);
+		static bool	isMap(const std::string &path);
+		static SVO	*load(const std::string &path, int world_dim);
+
+	private:
+		static bool	qubicle(std::ifstream &file, std::vector<GPUVoxel> &voxels);
+		static bool	binvox(std::ifstream &file, std::vector<GPUVoxel> &voxels);
+		static SVO	*vxl(const std::string &path, int world_dim);
+		static SVO	*buildTree(std::vector<GPUVoxel> &voxels, int world_dim);
+};
+
+#endif
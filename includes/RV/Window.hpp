@@ -16,7 +16,11 @@
 # include "RV.hpp"
 
 class Scene;
-class ShaderProgram;
+class Renderer;
+class CameraPath;
+class VoxelEditor;
+
+struct FrameSettings;
 
 class Window
 {
@@ -36,29 +40,57 @@ class Window
 		static void	mouseButtonCallback(GLFWwindow *window, int button, int action, int mods);
 
 		void		imGuiNewFrame();
-		void		imGuiRender(ShaderProgram &raytracing_program);
+		void		imGuiRender(Renderer &renderer);
 
 		GLFWwindow	*getWindow(void) const;
 		float		getFps(void) const;
 		int			getFrameCount(void) const;
 		int			getOutputTexture(void) const;
+		AovView		getView(void) const;
+		int			getAovMask(void) const;
 
 		bool		&getAccumulate(void);
+		bool		&getReproject(void);
+		int			getMaxHistory(bool moving) const;
+		bool		consumeDenoiseValidation(void);
+		bool		consumeAovReadback(void);
+		FrameSettings	getFrameSettings(void);
 
 		void		setFrameCount(int nb);
+		void		setRecordPath(const std::string &path);
 
 		private:
+		void		applyBrush(VoxelEditor &editor);
+
 		GLFWwindow	*_window;
 		Scene		*_scene;
 
 		int			_output_texture;
+		int			_view;
+		int			_aov_mask;
 		
 		float		_fps;
 		float		_delta;
 		int			_frameCount;
-		int			_pixelisation;
 
 		bool		accumulate = true;
+		bool		reproject = true;
+		int			_moving_history = 16;
+		float		_lod_bias = 1.0f;
+		bool		_validate_denoise = false;
+		bool		_readback_aov = false;
+		bool		_screenshot = false;
+
+		int			_brush_mode = 0;
+		int			_brush_radius = 2;
+		float		_brush_color[3] = {0.8f, 0.3f, 0.2f};
+
+		int			_selected_instance = 0;
+
+		CameraPath	*_recording;
+		std::string	_record_path;
+		bool		_record_active = false;
+		double		_record_start = 0.0;
 };
 
 #endif
@@ -0,0 +1,76 @@
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0, rgba32f) uniform writeonly image2D output_image;
+layout(binding = 1, rgba32f) uniform readonly image2D normal_depth_image;
+layout(binding = 2, rgba32f) uniform readonly image2D albedo_image;
+layout(binding = 6, rgba32f) uniform readonly image2D src_image;
+layout(binding = 7, rgba32f) uniform writeonly image2D dst_image;
+
+uniform vec2	u_resolution;
+uniform int		u_step;
+uniform int		u_last;
+
+#include "shaders/denoise.glsl"
+
+// B3 spline, indexed by distance to the center tap
+const float kernel[3] = float[3](3.0 / 8.0, 1.0 / 4.0, 1.0 / 16.0);
+
+vec4 filterPixel(ivec2 pixel_coords, vec4 center, vec4 center_normal_depth, vec3 center_albedo)
+{
+	float sigma_lum = denoise.phi_color * sqrt(max(center.a, 0.0)) + 1e-4;
+	float center_lum = luminance(center.rgb);
+
+	vec3 sum_color = vec3(0.0);
+	float sum_variance = 0.0;
+	float sum_weight = 0.0;
+
+	for (int y = -2; y <= 2; y++)
+	{
+		for (int x = -2; x <= 2; x++)
+		{
+			ivec2 coords = pixel_coords + ivec2(x, y) * u_step;
+			if (!insideImage(coords))
+				continue;
+
+			vec4 normal_depth = imageLoad(normal_depth_image, coords);
+			if (normal_depth.w < 0.0)
+				continue;
+
+			vec4 sample_color = imageLoad(src_image, coords);
+			vec3 albedo = imageLoad(albedo_image, coords).rgb;
+
+			float w_normal = pow(max(dot(center_normal_depth.xyz, normal_depth.xyz), 0.0), denoise.phi_normal);
+			float w_depth = exp(-abs(center_normal_depth.w - normal_depth.w) / (denoise.phi_depth * center_normal_depth.w * float(u_step) + 1e-4));
+			float w_lum = exp(-abs(center_lum - luminance(sample_color.rgb)) / sigma_lum);
+			float w_albedo = exp(-length(center_albedo - albedo) / (denoise.phi_albedo + 1e-4));
+
+			float weight = kernel[abs(x)] * kernel[abs(y)] * w_normal * w_depth * w_lum * w_albedo;
+
+			sum_color += sample_color.rgb * weight;
+			sum_variance += sample_color.a * weight * weight;
+			sum_weight += weight;
+		}
+	}
+
+	return (vec4(sum_color / sum_weight, sum_variance / (sum_weight * sum_weight)));
+}
+
+void main()
+{
+	ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
+	if (pixel_coords.x >= int(u_resolution.x) || pixel_coords.y >= int(u_resolution.y))
+		return;
+
+	vec4 center = imageLoad(src_image, pixel_coords);
+	vec4 center_normal_depth = imageLoad(normal_depth_image, pixel_coords);
+	vec3 center_albedo = imageLoad(albedo_image, pixel_coords).rgb;
+
+	vec4 result = center;
+	if (center_normal_depth.w >= 0.0)
+		result = filterPixel(pixel_coords, center, center_normal_depth, center_albedo);
+
+	if (u_last != 0)
+		imageStore(output_image, pixel_coords, vec4(remodulate(result.rgb, center_albedo), 1.0));
+	else
+		imageStore(dst_image, pixel_coords, result);
+}
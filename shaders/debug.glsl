@@ -13,17 +13,20 @@ struct GPUVoxel
 	vec3 normal;
 	ivec3 position;
 	int color;
+	int light;
 };
 
 struct GPUFlatVoxel
 {
 	ivec3 min;
+	int color;
 	ivec3 max;
     int childOffset;
     int voxelIndex;
     int voxelCount;
 
 	uint childMask;
+	int normal;
 };
 
 struct GPUCamera
@@ -47,15 +50,7 @@ struct GPUDebug
 };
 
 
-layout(std430, binding = 0) buffer FlatSVONode
-{
-	GPUFlatVoxel flatSVONodes[];
-};
-
-layout(std430, binding = 1) buffer VoxelFlatData
-{
-	GPUVoxel flatVoxels[];
-};
+#include "shaders/paging.glsl"
 
 layout(std140, binding = 0) uniform CameraData
 {
@@ -75,9 +70,9 @@ struct Ray {
 
 struct hitInfo
 {
-	vec3 position;
-	vec3 normal;
-	vec4 color;
+	int voxel_index;
+	int node_index;
+	int instance;
 	float dist;
 };
 
@@ -90,7 +85,7 @@ vec3 debugColor(Ray ray)
 	hitInfo hit;
 
 
-	traverseSVO(ray, hit, stats);
+	bool hit_voxel = traverseSVO(ray, hit, stats);
 
 	float node_display = float(stats.nodes) / float(debug.box_treshold);
 	float voxel_display = float(stats.voxels) / float(debug.triangle_treshold);
@@ -98,7 +93,7 @@ vec3 debugColor(Ray ray)
 	switch (debug.mode)
 	{
 		case 0:
-			return (hit.normal);
+			return (hit_voxel ? hitVoxel(ray, hit).normal : vec3(0.));
 		case 1:
 			return (node_display < 1. ? vec3(node_display) : vec3(1., 0., 0.));
 		case 2:
@@ -0,0 +1,38 @@
+struct GPUDenoise
+{
+	int		enabled;
+	int		temporal;
+	int		iterations;
+
+	float	phi_color;
+	float	phi_normal;
+	float	phi_depth;
+	float	phi_albedo;
+	float	alpha;
+};
+
+layout(std140, binding = 2) uniform DenoiseData
+{
+	GPUDenoise denoise;
+};
+
+float luminance(vec3 color)
+{
+	return (dot(color, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+// the filter works on lighting only, albedo is put back on the last iteration
+vec3 demodulate(vec3 color, vec3 albedo)
+{
+	return (color / max(albedo, vec3(1e-3)));
+}
+
+vec3 remodulate(vec3 irradiance, vec3 albedo)
+{
+	return (irradiance * max(albedo, vec3(1e-3)));
+}
+
+bool insideImage(ivec2 pixel_coords)
+{
+	return (pixel_coords.x >= 0 && pixel_coords.y >= 0 && pixel_coords.x < int(u_resolution.x) && pixel_coords.y < int(u_resolution.y));
+}
@@ -2,8 +2,129 @@ in vec2 TexCoords;
 out vec4 FragColor;
 
 uniform sampler2D screenTexture;
+uniform vec2 u_renderResolution;
+uniform int u_view;
+uniform float u_nodeTreshold;
+uniform float u_voxelTreshold;
+
+#define VIEW_COLOR          0
+#define VIEW_DEPTH          1
+#define VIEW_NORMAL         2
+#define VIEW_ALBEDO         3
+#define VIEW_VOXEL_ID       4
+#define VIEW_NODE_VISITS    5
+#define VIEW_VOXEL_VISITS   6
+#define VIEW_MOTION         7
+#define VIEW_HISTORY        8
+#define VIEW_RAW            9
+
+// catmull-rom weights for the 4 taps around a sample at fraction t
+vec4 cubicWeights(float t)
+{
+    float t2 = t * t;
+    float t3 = t2 * t;
+
+    return (vec4(-0.5 * t3 + t2 - 0.5 * t,
+                  1.5 * t3 - 2.5 * t2 + 1.0,
+                 -1.5 * t3 + 2.0 * t2 + 0.5 * t,
+                  0.5 * t3 - 0.5 * t2));
+}
+
+// the frame only fills the bottom left u_renderResolution texels of the texture
+vec4 upscale(vec2 uv)
+{
+    vec2 position = uv * u_renderResolution - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+
+    vec4 wx = cubicWeights(f.x);
+    vec4 wy = cubicWeights(f.y);
+
+    ivec2 last = ivec2(u_renderResolution) - 1;
+
+    vec4 color = vec4(0.0);
+    vec4 low = vec4(1e30);
+    vec4 high = vec4(-1e30);
+
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            ivec2 coords = clamp(base + ivec2(x - 1, y - 1), ivec2(0), last);
+            vec4 texel = texelFetch(screenTexture, coords, 0);
+
+            color += texel * wx[x] * wy[y];
+            if (x >= 1 && x <= 2 && y >= 1 && y <= 2)
+            {
+                low = min(low, texel);
+                high = max(high, texel);
+            }
+        }
+    }
+
+    // no ringing past the 4 nearest texels
+    return (clamp(color, low, high));
+}
+
+vec4 nearest(vec2 uv)
+{
+    ivec2 coords = clamp(ivec2(uv * u_renderResolution), ivec2(0), ivec2(u_renderResolution) - 1);
+    return (texelFetch(screenTexture, coords, 0));
+}
+
+vec3 heat(float value)
+{
+    return (value < 1.0 ? vec3(value) : vec3(1.0, 0.0, 0.0));
+}
+
+vec3 hashColor(int id)
+{
+    uint h = uint(id) * 747796405u + 2891336453u;
+    h = ((h >> ((h >> 28u) + 4u)) ^ h) * 277803737u;
+    return (vec3(h & 0xFFu, (h >> 8u) & 0xFFu, (h >> 16u) & 0xFFu) / 255.0);
+}
 
 void main() {
     // FragColor = imageLoad(screenTexture, ivec2(gl_FragCoord.xy));
-    FragColor = texture(screenTexture, TexCoords);
-}
\ No newline at end of file
+    vec4 texel;
+    vec3 color;
+
+    // ids and counters can not be interpolated
+    if (u_view == VIEW_VOXEL_ID || u_view == VIEW_NODE_VISITS || u_view == VIEW_VOXEL_VISITS)
+        texel = nearest(TexCoords);
+    else
+        texel = upscale(TexCoords);
+
+    switch (u_view)
+    {
+        case VIEW_COLOR:
+        case VIEW_ALBEDO:
+            color = sqrt(max(texel.rgb, vec3(0.0)));
+            break;
+        case VIEW_DEPTH:
+            color = texel.w < 0.0 ? vec3(0.0) : vec3(1.0 - texel.w / (texel.w + 128.0));
+            break;
+        case VIEW_NORMAL:
+            color = texel.xyz * 0.5 + 0.5;
+            break;
+        case VIEW_VOXEL_ID:
+            color = floatBitsToInt(texel.x) < 0 ? vec3(0.0) : hashColor(floatBitsToInt(texel.x));
+            break;
+        case VIEW_NODE_VISITS:
+            color = heat(texel.y / u_nodeTreshold);
+            break;
+        case VIEW_VOXEL_VISITS:
+            color = heat(texel.z / u_voxelTreshold);
+            break;
+        case VIEW_MOTION:
+            color = vec3(abs(texel.xy) * 50.0, 0.0);
+            break;
+        case VIEW_HISTORY:
+            color = vec3(texel.z / 64.0);
+            break;
+        default:
+            color = texel.rgb;
+    }
+
+    FragColor = vec4(color, 1.0);
+}
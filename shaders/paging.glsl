@@ -0,0 +1,48 @@
+// node and voxel arrays split in up to PAGE_COUNT ssbos each, a page holds
+// 1 << shift elements so an index is a page number and an offset in it,
+// see PagedBuffer, pages that are not used are bound to the first one
+
+#define PAGE_COUNT			4
+#define NODE_PAGE_BINDING	0
+#define VOXEL_PAGE_BINDING	4
+
+uniform int	u_nodePageShift;
+uniform int	u_voxelPageShift;
+
+layout(std430, binding = 0) readonly buffer NodePage0 { GPUFlatVoxel nodePage0[]; };
+layout(std430, binding = 1) readonly buffer NodePage1 { GPUFlatVoxel nodePage1[]; };
+layout(std430, binding = 2) readonly buffer NodePage2 { GPUFlatVoxel nodePage2[]; };
+layout(std430, binding = 3) readonly buffer NodePage3 { GPUFlatVoxel nodePage3[]; };
+
+layout(std430, binding = 4) readonly buffer VoxelPage0 { GPUVoxel voxelPage0[]; };
+layout(std430, binding = 5) readonly buffer VoxelPage1 { GPUVoxel voxelPage1[]; };
+layout(std430, binding = 6) readonly buffer VoxelPage2 { GPUVoxel voxelPage2[]; };
+layout(std430, binding = 7) readonly buffer VoxelPage3 { GPUVoxel voxelPage3[]; };
+
+GPUFlatVoxel getNode(int index)
+{
+	int page = index >> u_nodePageShift;
+	int local = index & ((1 << u_nodePageShift) - 1);
+
+	if (page == 0)
+		return (nodePage0[local]);
+	if (page == 1)
+		return (nodePage1[local]);
+	if (page == 2)
+		return (nodePage2[local]);
+	return (nodePage3[local]);
+}
+
+GPUVoxel getVoxel(int index)
+{
+	int page = index >> u_voxelPageShift;
+	int local = index & ((1 << u_voxelPageShift) - 1);
+
+	if (page == 0)
+		return (voxelPage0[local]);
+	if (page == 1)
+		return (voxelPage1[local]);
+	if (page == 2)
+		return (voxelPage2[local]);
+	return (voxelPage3[local]);
+}
@@ -1,12 +1,20 @@
 
 layout(local_size_x = 16, local_size_y = 16) in;
 layout(binding = 0, rgba32f) uniform image2D output_image;
+layout(binding = 1, rgba32f) uniform image2D normal_depth_image;
+layout(binding = 2, rgba32f) uniform image2D albedo_image;
+layout(binding = 4, rgba32f) uniform image2D traversal_image;
 
 uniform vec2    u_resolution;
 uniform int		u_frameCount;
 uniform float	u_time;
 uniform int		u_voxelDim;
 uniform float	u_voxelSize;
+uniform int		u_aovMask;
+
+#define AOV_NORMAL_DEPTH	1
+#define AOV_ALBEDO			2
+#define AOV_TRAVERSAL		4
 
 struct GPUVoxel
 {
@@ -19,12 +27,14 @@ struct GPUVoxel
 struct GPUFlatVoxel
 {
 	ivec3 min;
+	int color;
 	ivec3 max;
     int childOffset;
     int voxelIndex;
     int voxelCount;
 
 	uint childMask;
+	int normal;
 };
 
 struct GPUCamera
@@ -39,15 +49,7 @@ struct GPUCamera
 	int		bounce;
 };
 
-layout(std430, binding = 0) buffer FlatSVONode
-{
-	GPUFlatVoxel flatSVONodes[];
-};
-
-layout(std430, binding = 1) buffer VoxelFlatData
-{
-	GPUVoxel flatVoxels[];
-};
+#include "shaders/paging.glsl"
 
 layout(std140, binding = 0) uniform CameraData
 {
@@ -63,16 +65,25 @@ struct Ray {
 struct hitInfo
 {
 	int voxel_index;
+	int node_index;
+	int instance;
 	float dist;
 };
 
 #include "shaders/random.glsl"
 #include "shaders/svo.glsl"
 
-vec3 pathtrace(Ray ray, inout uint rng_state)
+// everything the trace writes besides the color, primary hit only except the stats
+struct AovData
 {
-	Stats stats;
+	vec4	normal_depth;
+	vec3	albedo;
+	int		voxel_index;
+	Stats	stats;
+};
 
+vec3 pathtrace(Ray ray, inout uint rng_state, inout AovData aov)
+{
 	vec3 color = vec3(1.);
 
 	vec3 light_dir = normalize(vec3(0.01, -0.5, sin(u_time * 0.05) * 0.2));
@@ -80,13 +91,13 @@ vec3 pathtrace(Ray ray, inout uint rng_state)
 	for (int i = 0; i < 1; i++)
 	{
 		hitInfo hit;
-		if (!traverseSVO(ray, hit, stats))
+		if (!traverseSVO(ray, hit, aov.stats))
 		{
 			color *= vec3(0.2, 0.4, 1.0);
 			break;
 		}
 		
-		GPUVoxel voxel = flatVoxels[hit.voxel_index];
+		GPUVoxel voxel = hitVoxel(ray, hit);
 		vec4 voxel_color = vec4(
 			float((voxel.color >> 24u) & 0xFFu) / 255.0,
 			float((voxel.color >> 16u) & 0xFFu) / 255.0,
@@ -95,6 +106,13 @@ vec3 pathtrace(Ray ray, inout uint rng_state)
 
 		color *= voxel_color.rgb; 
 
+		if (i == 0)
+		{
+			aov.normal_depth = vec4(voxel.normal, hit.dist);
+			aov.albedo = voxel_color.rgb;
+			aov.voxel_index = hit.voxel_index;
+		}
+
 		//shadow ray//
 		Ray shadow_ray;
 		shadow_ray.origin = voxel.position + (u_voxelSize / 2.0) + voxel.normal;
@@ -102,7 +120,7 @@ vec3 pathtrace(Ray ray, inout uint rng_state)
 		shadow_ray.inv_direction = 1.0 / shadow_ray.direction;
 
 		hitInfo temp;
-		if (traverseSVO(shadow_ray, temp, stats))
+		if (traverseSVO(shadow_ray, temp, aov.stats))
 			color.rgb *= 0.5;
 		//
 		
@@ -152,7 +170,15 @@ void main()
 
 	Ray ray = initRay(uv, rng_state);
 
-	vec3 color = pathtrace(ray, rng_state);
+	AovData aov = AovData(vec4(0., 0., 0., -1.), vec3(0.2, 0.4, 1.0), -1, Stats(0, 0));
+	vec3 color = pathtrace(ray, rng_state, aov);
+
+	imageStore(output_image, pixel_coords, vec4(color, 1.0));
 
-	imageStore(output_image, pixel_coords, vec4(sqrt(color), 1.0));
+	if ((u_aovMask & AOV_NORMAL_DEPTH) != 0)
+		imageStore(normal_depth_image, pixel_coords, aov.normal_depth);
+	if ((u_aovMask & AOV_ALBEDO) != 0)
+		imageStore(albedo_image, pixel_coords, vec4(aov.albedo, 1.0));
+	if ((u_aovMask & AOV_TRAVERSAL) != 0)
+		imageStore(traversal_image, pixel_coords, vec4(intBitsToFloat(aov.voxel_index), float(aov.stats.nodes), float(aov.stats.voxels), 1.0));
 }
@@ -5,6 +5,67 @@ struct Stats
 	int voxels;
 };
 
+#if SHADER_STREAMING
+// same values as SVOStreamer.hpp, a proxy node stands for a brick that
+// lives on disk, its voxelCount is the brick id in the table
+#define STREAM_TABLE_BINDING	8
+#define STREAM_PROXY			-2
+#define STREAM_SLOT_NODES		4096
+
+struct StreamEntry
+{
+	int slot;
+	int last_used;
+};
+
+layout(std430, binding = STREAM_TABLE_BINDING) buffer StreamTable { StreamEntry streamTable[]; };
+
+uniform int	u_streamFrame;
+uniform int	u_streamNodeBase;
+#endif
+
+// a node narrower than the pixel cone where the ray enters it is shaded as
+// a whole from its averages, u_lodBias scales the cone and 0 turns it off,
+// scale takes a model node to its world size since dist is a world distance
+#define LOD_MIN_COVERAGE	0.5
+
+uniform float	u_lodBias;
+
+bool lodCut(GPUFlatVoxel node, float dist, float spread, float scale)
+{
+	float coverage = float(node.color & 0xFF) / 255.0;
+
+	return (coverage >= LOD_MIN_COVERAGE && float(node.max.x - node.min.x) * scale < spread * dist);
+}
+
+#if SHADER_INSTANCING
+// same values as TLAS.hpp, the top level over the instanced models, a leaf
+// holds count instances from left_first, an inner node its two children
+#define TLAS_NODE_BINDING	9
+#define INSTANCE_BINDING	10
+#define TLAS_MAX_DEPTH		30
+
+struct GPUTLASNode
+{
+	vec3	min;
+	int		left_first;
+	vec3	max;
+	int		count;
+};
+
+struct GPUInstance
+{
+	mat4	world_to_model;
+	mat4	model_to_world;
+	int		root;
+};
+
+layout(std430, binding = TLAS_NODE_BINDING) buffer TLASNodes { GPUTLASNode tlasNodes[]; };
+layout(std430, binding = INSTANCE_BINDING) buffer Instances { GPUInstance instances[]; };
+
+uniform int	u_instanceCount;
+#endif
+
 bool intersectRayBox(Ray ray, vec3 box_min, vec3 box_max, inout float dist)
 {
 	vec3 t1 = (box_min - ray.origin) * ray.inv_direction;
@@ -19,25 +80,59 @@ bool intersectRayBox(Ray ray, vec3 box_min, vec3 box_max, inout float dist)
 	return (dist <= last_dist && last_dist >= 0.0);
 }
 
-bool traverseSVO(Ray ray, inout hitInfo hit, inout Stats stats)
+// a ray crosses at most 4 of the 8 children, so each level adds 3 entries
+// at most, the Renderer sets it from the world depth
+#ifndef SHADER_SVO_STACK
+#define SHADER_SVO_STACK	29
+#endif
+
+// closest hit in the tree at root that beats hit.dist, the world is at 0
+// and every instanced model has its own root further in the node array,
+// scale is the size of one of its voxels in the world
+void traverseTree(Ray ray, int root, float scale, inout hitInfo hit, inout Stats stats)
 {
-	hit.dist = 1e30;
+	float spread = u_lodBias * 2.0 * tan(radians(camera.fov) / 2.0) / u_resolution.y;
 
-	int stack[16];
+	int stack[SHADER_SVO_STACK];
 	int stack_ptr = 0;
-	stack[0] = 0;
+	stack[0] = root;
 
 	while (stack_ptr >= 0)
 	{
 		int current_index = stack[stack_ptr--];
-		GPUFlatVoxel node = flatSVONodes[current_index];
+		GPUFlatVoxel node = getNode(current_index);
+
+#if SHADER_STREAMING
+		if (node.childOffset == STREAM_PROXY)
+		{
+			int brick = node.voxelCount;
+			streamTable[brick].last_used = u_streamFrame;
+
+			int slot = streamTable[brick].slot;
+			if (slot >= 0)
+			{
+				stack[++stack_ptr] = u_streamNodeBase + slot * STREAM_SLOT_NODES;
+				continue ;
+			}
+
+			// not loaded yet, the proxy is shaded like a node cut by the lod
+			float dist = 0.;
+			if (intersectRayBox(ray, vec3(node.min), vec3(node.max), dist) && dist < hit.dist)
+			{
+				hit.dist = max(dist, 0.);
+				hit.voxel_index = -1;
+				hit.node_index = current_index;
+			}
+			continue ;
+		}
+#endif
 		
 		if (node.childOffset == -1) // leaf
 		{
 			for (int i = 0; i < node.voxelCount; i++)
             {
                 int index = node.voxelIndex + i;
-                GPUVoxel voxel = flatVoxels[index];
+                GPUVoxel voxel = getVoxel(index);
 
 				vec3 box_min = voxel.position;
 				vec3 box_max = voxel.position + vec3(1.001);
@@ -47,6 +142,7 @@ bool traverseSVO(Ray ray, inout hitInfo hit, inout Stats stats)
 				{
 					hit.dist = dist;
 					hit.voxel_index = index;
+					hit.node_index = -1;
 				}
 
 				stats.voxels++;
@@ -58,17 +154,106 @@ bool traverseSVO(Ray ray, inout hitInfo hit, inout Stats stats)
 			{
 				if ((node.childMask & (1 << i)) != 0)
 				{
-					GPUFlatVoxel child = flatSVONodes[node.childOffset + i];
+					GPUFlatVoxel child = getNode(node.childOffset + i);
 
 					float dist = 0.;
 					if (intersectRayBox(ray, vec3(child.min), vec3(child.max), dist) && dist < hit.dist)
-						stack[++stack_ptr] = node.childOffset + i;
+					{
+						if (lodCut(child, dist, spread, scale))
+						{
+							hit.dist = max(dist, 0.);
+							hit.voxel_index = -1;
+							hit.node_index = node.childOffset + i;
+						}
+						else if (stack_ptr + 1 < SHADER_SVO_STACK)
+							stack[++stack_ptr] = node.childOffset + i;
+					}
 
 					stats.nodes++;
 				}
 			}
 		}
 	}
+}
+
+bool traverseSVO(Ray ray, inout hitInfo hit, inout Stats stats)
+{
+	hit.dist = 1e30;
+	hit.node_index = -1;
+	hit.instance = -1;
+
+	traverseTree(ray, 0, 1.0, hit, stats);
+
+#if SHADER_INSTANCING
+	if (u_instanceCount == 0)
+		return (hit.dist < 1e30);
+
+	// the model ray is not normalized so its distances stay world distances
+	int stack[TLAS_MAX_DEPTH + 2];
+	int stack_ptr = 0;
+	stack[0] = 0;
+
+	while (stack_ptr >= 0)
+	{
+		GPUTLASNode node = tlasNodes[stack[stack_ptr--]];
+
+		float dist = 0.;
+		if (!intersectRayBox(ray, node.min, node.max, dist) || dist >= hit.dist)
+			continue ;
+
+		if (node.count == 0)
+		{
+			stack[++stack_ptr] = node.left_first;
+			stack[++stack_ptr] = node.left_first + 1;
+			continue ;
+		}
+
+		for (int i = node.left_first; i < node.left_first + node.count; i++)
+		{
+			Ray model_ray;
+			model_ray.origin = (instances[i].world_to_model * vec4(ray.origin, 1.0)).xyz;
+			model_ray.direction = (instances[i].world_to_model * vec4(ray.direction, 0.0)).xyz;
+			model_ray.inv_direction = 1.0 / model_ray.direction;
+
+			float best = hit.dist;
+			traverseTree(model_ray, instances[i].root, length(instances[i].model_to_world[0].xyz), hit, stats);
+			if (hit.dist < best)
+				hit.instance = i;
+		}
+	}
+#endif
 
 	return (hit.dist < 1e30);
-}
\ No newline at end of file
+}
+
+// what a hit is shaded with, a node cut by the lod or a proxy stands in
+// with its averages in the cell just before the ray entered it, outside the
+// node so that the shadow ray started there does not hit it again
+GPUVoxel hitVoxel(Ray ray, hitInfo hit)
+{
+	GPUVoxel voxel;
+
+	if (hit.node_index < 0)
+		voxel = getVoxel(hit.voxel_index);
+	else
+	{
+		GPUFlatVoxel node = getNode(hit.node_index);
+		vec3 normal = normalize(unpackSnorm4x8(uint(node.normal)).xyz);
+		ivec3 position = ivec3(floor(ray.origin + ray.direction * max(hit.dist - 0.01, 0.)));
+
+		voxel = GPUVoxel(normal, position, node.color, 0);
+	}
+
+#if SHADER_INSTANCING
+	// model space back to world, a voxel lands in the cell holding its center
+	if (hit.instance >= 0)
+	{
+		mat4 model_to_world = instances[hit.instance].model_to_world;
+		voxel.normal = normalize(mat3(model_to_world) * voxel.normal);
+		if (hit.node_index < 0)
+			voxel.position = ivec3(floor((model_to_world * vec4(vec3(voxel.position) + 0.5, 1.0)).xyz));
+	}
+#endif
+
+	return (voxel);
+}
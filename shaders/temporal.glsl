@@ -0,0 +1,154 @@
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0, rgba32f) uniform image2D output_image;
+layout(binding = 1, rgba32f) uniform readonly image2D normal_depth_image;
+layout(binding = 2, rgba32f) uniform readonly image2D albedo_image;
+layout(binding = 3, rgba32f) uniform writeonly image2D moments_image;
+layout(binding = 4, rgba32f) uniform readonly image2D history_color_image;
+layout(binding = 5, rgba32f) uniform readonly image2D history_normal_depth_image;
+layout(binding = 6, rgba32f) uniform readonly image2D history_moments_image;
+layout(binding = 7, rgba32f) uniform writeonly image2D motion_image;
+
+uniform vec2	u_resolution;
+uniform vec2	u_prevResolution;
+uniform int		u_frameCount;
+uniform int		u_maxHistory;
+uniform float	u_voxelSize;
+
+struct GPUCamera
+{
+	mat4	view_matrix;
+    vec3	position;
+	
+	float	aperture_size;
+	float	focus_distance;
+	float	fov;
+
+	int		bounce;
+};
+
+layout(std140, binding = 0) uniform CameraData
+{
+    GPUCamera camera;
+};
+
+layout(std140, binding = 3) uniform PreviousCameraData
+{
+    GPUCamera previous_camera;
+};
+
+#include "shaders/denoise.glsl"
+
+vec3 primaryDirection(vec2 pixel_coords)
+{
+	float focal_length = 1.0 / tan(radians(camera.fov) / 2.0);
+
+	vec2 uv = (pixel_coords / u_resolution) * 2.0 - 1.0;
+	uv.x *= u_resolution.x / u_resolution.y;
+
+	vec3 view_space_ray = normalize(vec3(uv.x, uv.y, -focal_length));
+	return (normalize((inverse(camera.view_matrix) * vec4(view_space_ray, 0.0)).xyz));
+}
+
+// where the surface seen by this pixel was on the previous frame, in the previous
+// frame pixel coordinates since the render resolution can change between frames
+bool previousPixel(ivec2 pixel_coords, float depth, out vec2 previous_coords, out float previous_depth)
+{
+	vec3 direction = primaryDirection(vec2(pixel_coords));
+	vec3 relative = direction;
+
+	if (depth >= 0.0)
+	{
+		vec3 position = camera.position / u_voxelSize + direction * depth;
+		relative = position - previous_camera.position / u_voxelSize;
+	}
+
+	vec3 view = mat3(previous_camera.view_matrix) * relative;
+	if (view.z >= 0.0)
+		return (false);
+
+	float focal_length = 1.0 / tan(radians(previous_camera.fov) / 2.0);
+	vec2 uv = view.xy * focal_length / -view.z;
+	uv.x /= u_prevResolution.x / u_prevResolution.y;
+
+	previous_coords = (uv + 1.0) * 0.5 * u_prevResolution;
+	previous_depth = length(relative);
+
+	return (true);
+}
+
+bool consistentHistory(ivec2 coords, vec4 normal_depth, float previous_depth)
+{
+	if (coords.x < 0 || coords.y < 0 || coords.x >= int(u_prevResolution.x) || coords.y >= int(u_prevResolution.y))
+		return (false);
+
+	vec4 history = imageLoad(history_normal_depth_image, coords);
+
+	if (normal_depth.w < 0.0 || history.w < 0.0)
+		return (normal_depth.w < 0.0 && history.w < 0.0);
+
+	bool depth_ok = abs(history.w - previous_depth) < 0.05 * previous_depth + 1.0;
+	bool normal_ok = dot(history.xyz, normal_depth.xyz) > 0.9;
+
+	return (depth_ok && normal_ok);
+}
+
+void main()
+{
+	ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
+	if (pixel_coords.x >= int(u_resolution.x) || pixel_coords.y >= int(u_resolution.y))
+		return;
+
+	vec3 color = imageLoad(output_image, pixel_coords).rgb;
+	vec4 normal_depth = imageLoad(normal_depth_image, pixel_coords);
+	vec3 albedo = imageLoad(albedo_image, pixel_coords).rgb;
+
+	float lum = luminance(demodulate(color, albedo));
+
+	vec2 previous_coords = vec2(pixel_coords);
+	float previous_depth = 0.0;
+
+	vec3 history_color = vec3(0.0);
+	vec3 history_moments = vec3(0.0);
+	float history_weight = 0.0;
+
+	if (u_frameCount > 0 && previousPixel(pixel_coords, normal_depth.w, previous_coords, previous_depth))
+	{
+		// bilinear fetch, taps that fail the depth/normal test are dropped
+		ivec2 base = ivec2(floor(previous_coords));
+		vec2 f = previous_coords - vec2(base);
+
+		for (int i = 0; i < 4; i++)
+		{
+			ivec2 offset = ivec2(i & 1, i >> 1);
+			ivec2 coords = base + offset;
+
+			float weight = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+			if (weight <= 0.0 || !consistentHistory(coords, normal_depth, previous_depth))
+				continue;
+
+			history_color += imageLoad(history_color_image, coords).rgb * weight;
+			history_moments += imageLoad(history_moments_image, coords).xyz * weight;
+			history_weight += weight;
+		}
+	}
+
+	vec4 moments = vec4(lum, lum * lum, 1.0, 0.0);
+
+	if (history_weight > 0.01)
+	{
+		history_color /= history_weight;
+		history_moments /= history_weight;
+
+		float history_length = min(floor(history_moments.z + 0.5) + 1.0, float(u_maxHistory));
+
+		color = mix(history_color, color, 1.0 / history_length);
+		moments.xy = mix(history_moments.xy, moments.xy, max(denoise.alpha, 1.0 / history_length));
+		moments.z = history_length;
+	}
+
+	imageStore(output_image, pixel_coords, vec4(color, 1.0));
+	imageStore(moments_image, pixel_coords, moments);
+	vec2 motion = previous_coords / u_prevResolution - vec2(pixel_coords) / u_resolution;
+	imageStore(motion_image, pixel_coords, vec4(motion, moments.z, history_weight));
+}
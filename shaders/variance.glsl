@@ -0,0 +1,66 @@
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0, rgba32f) uniform readonly image2D output_image;
+layout(binding = 1, rgba32f) uniform readonly image2D normal_depth_image;
+layout(binding = 2, rgba32f) uniform readonly image2D albedo_image;
+layout(binding = 3, rgba32f) uniform readonly image2D moments_image;
+layout(binding = 7, rgba32f) uniform writeonly image2D dst_image;
+
+uniform vec2	u_resolution;
+
+#include "shaders/denoise.glsl"
+
+float spatialVariance(ivec2 pixel_coords)
+{
+	float sum = 0.0;
+	float sum_squared = 0.0;
+	float count = 0.0;
+
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			ivec2 coords = pixel_coords + ivec2(x, y);
+			if (!insideImage(coords))
+				continue;
+
+			vec3 color = imageLoad(output_image, coords).rgb;
+			vec3 albedo = imageLoad(albedo_image, coords).rgb;
+			float lum = luminance(demodulate(color, albedo));
+
+			sum += lum;
+			sum_squared += lum * lum;
+			count += 1.0;
+		}
+	}
+
+	float mean = sum / count;
+	return (max(sum_squared / count - mean * mean, 0.0));
+}
+
+void main()
+{
+	ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
+	if (pixel_coords.x >= int(u_resolution.x) || pixel_coords.y >= int(u_resolution.y))
+		return;
+
+	vec3 color = imageLoad(output_image, pixel_coords).rgb;
+	vec3 albedo = imageLoad(albedo_image, pixel_coords).rgb;
+	vec3 irradiance = demodulate(color, albedo);
+
+	float variance = 1.0;
+
+	if (denoise.temporal != 0)
+	{
+		// moments are integrated over time by the reprojection pass
+		vec4 moments = imageLoad(moments_image, pixel_coords);
+
+		// not enough history for the moments to mean anything yet
+		if (moments.z < 4.0)
+			variance = spatialVariance(pixel_coords);
+		else
+			variance = max(moments.y - moments.x * moments.x, 0.0);
+	}
+
+	imageStore(dst_image, pixel_coords, vec4(irradiance, variance));
+}
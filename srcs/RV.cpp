@@ -12,76 +12,340 @@
 
 #include "RV.hpp"
 
-void					setupScreenTriangle(GLuint *VAO);
-void					drawScreenTriangle(GLuint VAO, GLuint output_texture, GLuint program);
+// one frame into the offscreen framebuffer, waits for the gpu so the
+// returned time covers the whole frame, validate runs the denoiser against
+// its cpu reference
+static float	renderHeadlessFrame(HeadlessContext &context, Renderer &renderer, Scene &scene, int frame, float time, float lod_bias,
+	bool validate = false)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	FrameSettings settings;
+	settings.frame_count = frame;
+	settings.max_history = scene.getCamera()->hasMoved() ? 16 : 1 << 16;
+	settings.accumulate = true;
+	settings.view = VIEW_COLOR;
+	settings.aov_mask = AOV_NORMAL_DEPTH | AOV_ALBEDO;
+	settings.output_texture = OUTPUT_TEXTURE;
+	settings.lod_bias = lod_bias;
+	settings.validate_denoise = validate;
+	settings.readback_aov = false;
+	settings.time = time;
+
+	renderer.beginFrame();
+	renderer.render(settings);
+	context.bindFramebuffer();
+	renderer.present(settings);
+	renderer.endFrame();
+
+	glFinish();
+	return (std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+// --capture records every frame as an image sequence
+static void		setupHeadlessRenderer(Renderer &renderer, Options &options)
+{
+	renderer.getResolution().getEnabled() = false;
+	renderer.getResolution().getScale() = options.scale;
+
+	if (!options.capture.empty())
+	{
+		renderer.getCapture().setDirectory(options.capture);
+		renderer.getCapture().setFormat(options.capture_exr ? CAPTURE_EXR : CAPTURE_PNG);
+		renderer.getCapture().getRecording() = true;
+	}
+}
+
+// renders options.frames frames offscreen from a fixed camera, then writes
+// the last image and the timings next to options.output
+static int	runHeadless(HeadlessContext &context, Options &options)
+{
+	Scene scene(options.world_dim, options.voxel_size);
+
+	if (options.stream_slots == 0 || !scene.streamScene(options.scene))
+		scene.parseScene(options.scene);
+	if (!addInstances(scene, options.instances))
+		return (1);
+	setupTerrain(scene, options);
+
+	Camera *camera = scene.getCamera();
+	if (options.has_camera)
+	{
+		camera->setPosition(glm::vec3(options.camera[0], options.camera[1], options.camera[2]));
+		camera->setDirection(options.camera[3], options.camera[4]);
+		camera->storeGPUData();
+	}
+
+	Renderer renderer(scene, context.getSize(), options.stream_slots, options.chunk_radius);
+	setupHeadlessRenderer(renderer, options);
+
+	std::vector<float> frame_ms;
+	for (int i = 0; i < options.frames; i++)
+		frame_ms.push_back(renderHeadlessFrame(context, renderer, scene, i, i * options.timestep, options.lod_bias,
+			options.validate_denoise && i == options.frames - 1));
+
+	std::vector<uint8_t> pixels;
+	context.readPixels(pixels);
+	ImageWriter::writePNG(options.output + ".png", context.getSize(), 4, pixels.data());
+
+	std::ofstream frames_file(options.output + "_frames.csv");
+	frames_file << "frame,ms" << std::endl;
+	for (size_t i = 0; i < frame_ms.size(); i++)
+		frames_file << i << "," << frame_ms[i] << std::endl;
+
+	std::ofstream passes_file(options.output + "_passes.csv");
+	renderer.getProfiler().writeStats(passes_file);
+
+	std::sort(frame_ms.begin(), frame_ms.end());
+	glm::vec2 render_size = renderer.getResolution().getResolution();
+
+	std::cout << "Headless: " << options.frames << " frames at " << int(render_size.x) << "x" << int(render_size.y)
+		<< "\tp50 " << percentile(frame_ms, 50.0f) << " ms\tmax " << frame_ms.back() << " ms" << std::endl;
+	std::cout << "Wrote " << options.output << ".png, " << options.output << "_frames.csv, " << options.output << "_passes.csv" << std::endl;
+
+	// the last frame went through the cpu reference as well
+	if (options.validate_denoise)
+	{
+		float error = renderer.getDenoiseError();
+		if (error < 0.0f)
+		{
+			std::cerr << "Denoiser not validated, it is turned off in this scene" << std::endl;
+			return (1);
+		}
+		if (error > DENOISE_TOLERANCE)
+		{
+			std::cerr << "Denoiser max error " << error << " is above the tolerance of " << DENOISE_TOLERANCE << std::endl;
+			return (1);
+		}
+	}
+
+	return (0);
+}
+
+// replays the camera path at a fixed timestep over options.scene, or over
+// every .vox in scenes/ when none is given, and writes the frame times
+static int	runBenchmark(HeadlessContext &context, Options &options)
+{
+	CameraPath path;
+	if (!path.load(options.benchmark))
+		return (1);
+
+	std::vector<std::string> scenes;
+	if (!options.scene.empty())
+		scenes.push_back(options.scene);
+	else
+	{
+		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator("scenes"))
+			if (entry.path().extension() == ".vox")
+				scenes.push_back(entry.path().string());
+		std::sort(scenes.begin(), scenes.end());
+	}
+
+	int frames = static_cast<int>(std::floor(path.getDuration() / options.timestep)) + 1;
+
+	std::ofstream csv(options.output + "_bench.csv");
+	std::ofstream json(options.output + "_bench.json");
+
+	csv << "scene,frame,time,ms" << std::endl;
+	json << "{\n\t\"path\": \"" << options.benchmark << "\",\n\t\"timestep\": " << options.timestep
+		<< ",\n\t\"frames\": " << frames << ",\n\t\"scenes\": [";
+
+	for (size_t s = 0; s < scenes.size(); s++)
+	{
+		Scene scene(options.world_dim, options.voxel_size);
+		if (options.stream_slots == 0 || !scene.streamScene(scenes[s]))
+			scene.parseScene(scenes[s]);
+		if (!addInstances(scene, options.instances))
+			return (1);
+		setupTerrain(scene, options);
+
+		Camera *camera = scene.getCamera();
+		CameraPath::apply(*camera, path.sample(0.0f));
+		camera->storeGPUData();
+
+		Renderer renderer(scene, context.getSize(), options.stream_slots, options.chunk_radius);
+		setupHeadlessRenderer(renderer, options);
+
+		std::vector<float> frame_ms;
+		for (int i = 0; i < frames; i++)
+		{
+			float time = i * options.timestep;
 
-std::vector<GLuint>		generateTextures(unsigned int textures_count);
+			CameraPath::apply(*camera, path.sample(time));
+			frame_ms.push_back(renderHeadlessFrame(context, renderer, scene, i, time, options.lod_bias));
 
-std::vector<Buffer *>	createDataOnGPU(Scene &scene);
-void					updateDataOnGPU(Scene &scene, std::vector<Buffer *> buffers);
+			csv << scenes[s] << "," << i << "," << time << "," << frame_ms.back() << std::endl;
+		}
+
+		std::sort(frame_ms.begin(), frame_ms.end());
+		float sum = 0.0f;
+		for (float ms : frame_ms)
+			sum += ms;
+
+		json << (s ? "," : "") << "\n\t\t{\"scene\": \"" << scenes[s] << "\""
+			<< ", \"min\": " << frame_ms.front() << ", \"avg\": " << sum / frame_ms.size()
+			<< ", \"p50\": " << percentile(frame_ms, 50.0f) << ", \"p95\": " << percentile(frame_ms, 95.0f)
+			<< ", \"p99\": " << percentile(frame_ms, 99.0f) << ", \"max\": " << frame_ms.back() << "}";
+
+		std::cout << "Benchmark: " << scenes[s] << "\t" << frames << " frames\tp50 " << percentile(frame_ms, 50.0f)
+			<< " ms\tp95 " << percentile(frame_ms, 95.0f) << " ms\tp99 " << percentile(frame_ms, 99.0f) << " ms" << std::endl;
+	}
+	json << "\n\t]\n}\n";
+
+	std::cout << "Wrote " << options.output << "_bench.csv, " << options.output << "_bench.json" << std::endl;
+	return (0);
+}
+
+// builds the world of options.scene, or of every file in scenes/ when none
+// is given, options.import_runs times without a window or GL and writes
+// how fast each loads, in MB of file and in voxels of the world per second
+static int	runImportBenchmark(Options &options)
+{
+	std::vector<std::string> scenes;
+	if (!options.scene.empty())
+		scenes.push_back(options.scene);
+	else
+	{
+		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator("scenes"))
+			if (entry.is_regular_file())
+				scenes.push_back(entry.path().string());
+		std::sort(scenes.begin(), scenes.end());
+	}
+
+	std::ofstream json(options.output + "_import.json");
+	json << "{\n\t\"world\": " << options.world_dim << ",\n\t\"runs\": " << options.import_runs
+		<< ",\n\t\"threads\": " << ThreadPool::shared().getThreadCount() << ",\n\t\"files\": [";
+
+	for (size_t s = 0; s < scenes.size(); s++)
+	{
+		// a slice directory counts all of its files
+		std::error_code error;
+		uintmax_t bytes = 0;
+		if (std::filesystem::is_directory(scenes[s]))
+		{
+			for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(scenes[s]))
+				if (entry.is_regular_file())
+					bytes += entry.file_size();
+		}
+		else
+			bytes = std::filesystem::file_size(scenes[s], error);
+
+		Scene scene(options.world_dim, options.voxel_size);
+		std::vector<float> load_ms;
+		size_t voxels = 0;
+		for (int run = 0; run < options.import_runs; run++)
+		{
+			SceneSetup setup;
+			auto start = std::chrono::high_resolution_clock::now();
+			SVO *root = scene.buildWorld(scenes[s], setup);
+			load_ms.push_back(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+			if (run == 0)
+			{
+				std::vector<FlatSVONode> nodes;
+				std::vector<GPUVoxel> flat_voxels;
+				root->flatten(nodes, flat_voxels);
+				voxels = flat_voxels.size();
+			}
+			delete (root);
+		}
+		std::sort(load_ms.begin(), load_ms.end());
+
+		float p50 = std::max(percentile(load_ms, 50.0f), 1e-3f);
+		float mb_per_s = bytes / 1e6f / (p50 / 1000.0f);
+		float voxels_per_s = voxels / (p50 / 1000.0f);
+
+		json << (s ? "," : "") << "\n\t\t{\"file\": \"" << scenes[s] << "\", \"bytes\": " << bytes << ", \"voxels\": " << voxels
+			<< ", \"min\": " << load_ms.front() << ", \"p50\": " << p50 << ", \"max\": " << load_ms.back()
+			<< ", \"mb_per_s\": " << mb_per_s << ", \"voxels_per_s\": " << voxels_per_s << "}";
+
+		std::cout << "Import: " << scenes[s] << "\t" << voxels << " voxels\tp50 " << p50 << " ms\t"
+			<< mb_per_s << " MB/s\t" << voxels_per_s / 1e6f << " Mvoxels/s" << std::endl;
+	}
+	json << "\n\t]\n}\n";
+
+	std::cout << "Wrote " << options.output << "_import.json" << std::endl;
+	return (0);
+}
 
 int main(int argc, char **argv)
 {
-	std::string args = "";
-	if (argc == 2)
-		args = argv[1];
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return (1);
 
-	Scene		scene;
-	Window		window(&scene, WIDTH, HEIGHT, "RedVoxel", 0);
-	
-	scene.parseScene(args);
+	if (!options.trace.empty())
+		TraceRecorder::enable();
 
-	GLuint VAO;
-	setupScreenTriangle(&VAO);
+	if (options.import_runs > 0)
+	{
+		int status = runImportBenchmark(options);
 
-	std::vector<GLuint> textures = generateTextures(1);
-	
-	ShaderProgram raytracing_program;
-	Shader compute = Shader(GL_COMPUTE_SHADER, "shaders/compute.glsl");
+		if (!options.trace.empty())
+			TraceRecorder::write(options.trace);
+		return (status);
+	}
 
-	raytracing_program.attachShader(&compute);
-	raytracing_program.link();
+	if (options.headless)
+	{
+		HeadlessContext context(glm::ivec2(WIDTH, HEIGHT));
 
-	ShaderProgram render_program;
-	Shader vertex = Shader(GL_VERTEX_SHADER, "shaders/vertex.vert");
-	Shader frag = Shader(GL_FRAGMENT_SHADER, "shaders/frag.frag");
-	render_program.attachShader(&vertex);
-	render_program.attachShader(&frag);
-	render_program.link();
+		int status = options.benchmark.empty() ? runHeadless(context, options) : runBenchmark(context, options);
 
-	std::vector<Buffer *> buffers = createDataOnGPU(scene);
+		if (!options.trace.empty())
+			TraceRecorder::write(options.trace);
+		return (status);
+	}
+
+	Scene		scene(options.world_dim, options.voxel_size);
+	Window		window(&scene, WIDTH, HEIGHT, "RedVoxel", 0);
+	
+	window.setRecordPath(options.record);
+	setupTerrain(scene, options);
+
+	// the first frame does not wait for the scene, it comes in brick by
+	// brick, a streamed world is cut into bricks on disk before it
+	SceneLoader	*loader = nullptr;
+	if (options.stream_slots > 0 && scene.streamScene(options.scene))
+	{
+		if (!addInstances(scene, options.instances))
+			return (1);
+	}
+	else
+		loader = new SceneLoader(scene, options.scene, options.instances);
+
+	Renderer	renderer(scene, glm::ivec2(WIDTH, HEIGHT), options.stream_slots, options.chunk_radius, loader);
+	if (!options.capture.empty())
+		renderer.getCapture().setDirectory(options.capture);
+	renderer.getCapture().setFormat(options.capture_exr ? CAPTURE_EXR : CAPTURE_PNG);
 
 	while (!window.shouldClose())
 	{
 		window.updateDeltaTime();
-		
-		updateDataOnGPU(scene, buffers);
-		
-		glClear(GL_COLOR_BUFFER_BIT);
-		
-		raytracing_program.use();
-		raytracing_program.set_int("u_frameCount", window.getFrameCount());
-		raytracing_program.set_int("u_voxelDim", VOXEL_DIM);
-		raytracing_program.set_float("u_voxelSize", VOXEL_SIZE);
-		raytracing_program.set_float("u_time", (float)(glfwGetTime()));
-		raytracing_program.set_vec2("u_resolution", glm::vec2(WIDTH, HEIGHT));
-		
-		raytracing_program.dispathCompute((WIDTH + 15) / 16, (HEIGHT + 15) / 16, 1);
+
+		FrameSettings settings = window.getFrameSettings();
+
+		renderer.beginFrame();
+		renderer.render(settings);
 
 		window.imGuiNewFrame();
 
-		render_program.use();
-		drawScreenTriangle(VAO, textures[window.getOutputTexture()], render_program.getProgram());
+		renderer.present(settings);
+
+		{
+			ProfileScope scope(renderer.getProfiler(), "ImGui");
+			window.imGuiRender(renderer);
+		}
 
-		window.imGuiRender(raytracing_program);
+		renderer.endFrame();
 
 		window.display();
 		window.pollEvents();
-
-		// glClearTexImage(textures[3], 0, GL_RGBA, GL_FLOAT, nullptr);
-		// glClearTexImage(textures[4], 0, GL_RGBA, GL_FLOAT, nullptr);
 	}
 
+	if (!options.trace.empty())
+		TraceRecorder::write(options.trace);
+
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
@@ -12,6 +12,19 @@
 
 #include "RV.hpp"
 
+const AovViewInfo	aov_views[VIEW_COUNT] = {
+	{"Color", OUTPUT_TEXTURE, 0},
+	{"Depth", NORMAL_DEPTH_TEXTURE, AOV_NORMAL_DEPTH},
+	{"Normal", NORMAL_DEPTH_TEXTURE, AOV_NORMAL_DEPTH},
+	{"Albedo", ALBEDO_TEXTURE, AOV_ALBEDO},
+	{"Voxel ID", TRAVERSAL_TEXTURE, AOV_TRAVERSAL},
+	{"Node visits", TRAVERSAL_TEXTURE, AOV_TRAVERSAL},
+	{"Voxel visits", TRAVERSAL_TEXTURE, AOV_TRAVERSAL},
+	{"Motion", MOTION_TEXTURE, 0},
+	{"History length", MOTION_TEXTURE, 0},
+	{"Raw texture", OUTPUT_TEXTURE, 0}
+};
+
 void				setupScreenTriangle(GLuint *VAO)
 {
 	GLuint VBO;
@@ -48,7 +61,7 @@ void				drawScreenTriangle(GLuint VAO, GLuint output_texture, GLuint program)
 	glDrawArrays(GL_TRIANGLES, 0, 1 * 3); // size 1
 }
 
-//0 output
+//0 output 1 normal/depth 2 albedo 3 moments 4-5 denoiser ping pong 6-8 history 9 motion 10 traversal
 std::vector<GLuint> generateTextures(unsigned int textures_count)
 {
 	std::vector<GLuint> textures(textures_count);
@@ -62,35 +75,447 @@ std::vector<GLuint> generateTextures(unsigned int textures_count)
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, WIDTH, HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-		glBindImageTexture(i, textures[i], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+		if (i < DENOISE_PING_TEXTURE)
+			glBindImageTexture(i, textures[i], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
 	}
 	return (textures);
 }
 
-std::vector<Buffer *>	createDataOnGPU(Scene &scene)
+void	readTexture(GLuint texture, glm::ivec2 resolution, std::vector<glm::vec4> &pixels)
 {
-	GLint max_gpu_size;
-	glGetIntegerv(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_gpu_size);
+	std::vector<glm::vec4> full(WIDTH * HEIGHT);
+
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, full.data());
 
-	const std::vector<FlatSVONode> &flatNodes = scene.flatNodes;
-	const std::vector<GPUVoxel> &flatVoxels = scene.flatVoxels;
+	pixels.resize(resolution.x * resolution.y);
+	for (int y = 0; y < resolution.y; y++)
+		memcpy(&pixels[y * resolution.x], &full[y * WIDTH], resolution.x * sizeof(glm::vec4));
+}
+
+// the scalar a view shows for one texel, before any display mapping
+float	aovValue(AovView view, const glm::vec4 &texel)
+{
+	int voxel_index;
 
+	switch (view)
+	{
+		case VIEW_DEPTH:
+			return (texel.w);
+		case VIEW_VOXEL_ID:
+			memcpy(&voxel_index, &texel.x, sizeof(int));
+			return (static_cast<float>(voxel_index));
+		case VIEW_NODE_VISITS:
+			return (texel.y);
+		case VIEW_VOXEL_VISITS:
+			return (texel.z);
+		case VIEW_MOTION:
+			return (glm::length(glm::vec2(texel)));
+		case VIEW_HISTORY:
+			return (texel.z);
+		default:
+			return (glm::dot(glm::vec3(texel), glm::vec3(0.2126f, 0.7152f, 0.0722f)));
+	}
+}
+
+void	printAovStats(std::vector<GLuint> &textures, AovView view, int raw_texture, glm::vec2 resolution)
+{
+	TextureIndex texture = (view == VIEW_RAW) ? static_cast<TextureIndex>(raw_texture) : aov_views[view].texture;
+
+	std::vector<glm::vec4> pixels;
+	readTexture(textures[texture], glm::ivec2(resolution), pixels);
+
+	double	sum = 0.0;
+	float	min = std::numeric_limits<float>::max();
+	float	max = std::numeric_limits<float>::lowest();
+
+	for (const glm::vec4 &texel : pixels)
+	{
+		float value = aovValue(view, texel);
+
+		sum += value;
+		min = std::min(min, value);
+		max = std::max(max, value);
+	}
+
+	std::cout << aov_views[view].name << " " << int(resolution.x) << "x" << int(resolution.y)
+		<< "\tmin " << min << "\tmax " << max << "\tavg " << sum / std::max<size_t>(pixels.size(), 1) << std::endl;
+}
+
+static bool	optionValue(int argc, char **argv, int &i, std::string &value)
+{
+	if (i + 1 >= argc)
+	{
+		std::cerr << argv[i] << " needs a value" << std::endl;
+		return (false);
+	}
+	value = argv[++i];
+	return (true);
+}
+
+bool	parseOptions(int argc, char **argv, Options &options)
+{
+	options.headless = false;
+	options.frames = 64;
+	options.scale = 1.0f;
+	options.has_camera = false;
+	options.output = "headless";
+	options.timestep = 1.0f / 60.0f;
+	options.import_runs = 0;
+	options.capture_exr = false;
+	options.stream_slots = 0;
+	options.lod_bias = 1.0f;
+	options.validate_denoise = false;
+	options.world_dim = VOXEL_DIM;
+	options.voxel_size = VOXEL_SIZE;
+	options.chunk_radius = 0;
+	options.has_terrain = false;
+	options.terrain_seed = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value;
+
+		if (arg == "--headless")
+			options.headless = true;
+		else if (arg == "--trace")
+		{
+			if (!optionValue(argc, argv, i, options.trace))
+				return (false);
+		}
+		else if (arg == "--output")
+		{
+			if (!optionValue(argc, argv, i, options.output))
+				return (false);
+		}
+		else if (arg == "--capture")
+		{
+			if (!optionValue(argc, argv, i, options.capture))
+				return (false);
+		}
+		else if (arg == "--exr")
+			options.capture_exr = true;
+		else if (arg == "--validate-denoise")
+			options.validate_denoise = true;
+		else if (arg == "--record")
+		{
+			if (!optionValue(argc, argv, i, options.record))
+				return (false);
+		}
+		else if (arg == "--benchmark")
+		{
+			if (!optionValue(argc, argv, i, options.benchmark))
+				return (false);
+			options.headless = true;
+		}
+		else if (arg == "--import-bench")
+		{
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			char *end = nullptr;
+			long runs = strtol(value.c_str(), &end, 10);
+			if (*end != '\0' || runs <= 0)
+			{
+				std::cerr << "--import-bench needs a run count, got " << value << std::endl;
+				return (false);
+			}
+			options.import_runs = static_cast<int>(runs);
+		}
+		else if (arg == "--stream")
+		{
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			char *end = nullptr;
+			long slots = strtol(value.c_str(), &end, 10);
+			if (*end != '\0' || slots <= 0)
+			{
+				std::cerr << "--stream needs a slot count, got " << value << std::endl;
+				return (false);
+			}
+			options.stream_slots = static_cast<int>(slots);
+		}
+		else if (arg == "--world" || arg == "--chunks")
+		{
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			char *end = nullptr;
+			long number = strtol(value.c_str(), &end, 10);
+			if (arg == "--world" && (*end != '\0' || number < 16 || number > 65536 || (number & (number - 1)) != 0))
+			{
+				std::cerr << "--world needs a power of two side between 16 and 65536, got " << value << std::endl;
+				return (false);
+			}
+			if (arg == "--chunks" && (*end != '\0' || number <= 0))
+			{
+				std::cerr << "--chunks needs a radius in chunks, got " << value << std::endl;
+				return (false);
+			}
+			if (arg == "--world")
+				options.world_dim = static_cast<int>(number);
+			else
+				options.chunk_radius = static_cast<int>(number);
+		}
+		else if (arg == "--terrain")
+		{
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			char *end = nullptr;
+			unsigned long seed = strtoul(value.c_str(), &end, 10);
+			if (*end != '\0' || value.empty())
+			{
+				std::cerr << "--terrain needs a seed, got " << value << std::endl;
+				return (false);
+			}
+			options.has_terrain = true;
+			options.terrain_seed = static_cast<uint32_t>(seed);
+		}
+		else if (arg == "--voxel-size")
+		{
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			char *end = nullptr;
+			options.voxel_size = strtof(value.c_str(), &end);
+			if (*end != '\0' || options.voxel_size <= 0.0f)
+			{
+				std::cerr << "--voxel-size needs a positive size, got " << value << std::endl;
+				return (false);
+			}
+		}
+		else if (arg == "--instance")
+		{
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+			options.instances.push_back(value);
+		}
+		else if (arg == "--lod")
+		{
+			// 0 turns the cone cut off, for comparing against full traversal
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			char *end = nullptr;
+			options.lod_bias = strtof(value.c_str(), &end);
+			if (*end != '\0' || options.lod_bias < 0.0f)
+			{
+				std::cerr << "--lod needs a bias of 0 or more, got " << value << std::endl;
+				return (false);
+			}
+		}
+		else if (arg == "--frames")
+		{
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			char *end = nullptr;
+			long frames = strtol(value.c_str(), &end, 10);
+			if (*end != '\0' || value.empty() || frames < 1 || frames > std::numeric_limits<int>::max())
+			{
+				std::cerr << "--frames needs a frame count of 1 or more, got " << value << std::endl;
+				return (false);
+			}
+			options.frames = static_cast<int>(frames);
+		}
+		else if (arg == "--scale" || arg == "--timestep")
+		{
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			char *end = nullptr;
+			float number = strtof(value.c_str(), &end);
+			if (*end != '\0' || number <= 0.0f)
+			{
+				std::cerr << arg << " needs a positive number, got " << value << std::endl;
+				return (false);
+			}
+			if (arg == "--timestep")
+				options.timestep = number;
+			else
+				options.scale = std::min(number, 1.0f);
+		}
+		else if (arg == "--camera")
+		{
+			// same order as the CAM line printed by the C key: x,y,z,pitch,yaw
+			if (!optionValue(argc, argv, i, value))
+				return (false);
+
+			std::replace(value.begin(), value.end(), ',', ' ');
+			std::istringstream stream(value);
+			for (int j = 0; j < 5; j++)
+				stream >> options.camera[j];
+			if (stream.fail())
+			{
+				std::cerr << "--camera needs x,y,z,pitch,yaw" << std::endl;
+				return (false);
+			}
+			options.has_camera = true;
+		}
+		else if (arg.rfind("--", 0) == 0 || !options.scene.empty())
+		{
+			std::cerr << "Unknown argument: " << arg << std::endl;
+			std::cerr << "Usage: " << argv[0] << " [scene.vox|level.scene|model.qb|model.binvox|map.vxl|mesh.obj|mesh.ply|heightmap.png|slices/] [--trace file.json] [--record path.txt] [--capture dir] [--exr] [--stream slots] [--instance path:x,y,z[,yaw[,scale]]]... [--world dim] [--voxel-size s] [--chunks radius] [--terrain seed]" << std::endl;
+			std::cerr << "       " << argv[0] << " scene.vox|level.scene|model.qb|model.binvox|map.vxl|mesh.obj|mesh.ply|heightmap.png|slices/ --headless [--frames n] [--scale s] [--camera x,y,z,pitch,yaw] [--output prefix] [--capture dir] [--exr] [--stream slots] [--lod bias] [--validate-denoise] [--world dim] [--voxel-size s] [--chunks radius] [--terrain seed]" << std::endl;
+			std::cerr << "       " << argv[0] << " [scene.vox|level.scene|model.qb|model.binvox|map.vxl|mesh.obj|mesh.ply|heightmap.png|slices/] --benchmark path.txt [--timestep s] [--scale s] [--output prefix] [--lod bias]" << std::endl;
+			std::cerr << "       " << argv[0] << " [scene.vox|level.scene|model.qb|model.binvox|map.vxl|mesh.obj|mesh.ply|heightmap.png|slices/] --import-bench runs [--output prefix] [--world dim]" << std::endl;
+			return (false);
+		}
+		else
+			options.scene = arg;
+	}
+
+	// the generated terrain only lives in chunks
+	if (options.has_terrain && options.chunk_radius == 0)
+		options.chunk_radius = TERRAIN_RADIUS;
+	return (true);
+}
+
+// nearest rank on an already sorted list
+float	percentile(const std::vector<float> &sorted, float p)
+{
+	if (sorted.empty())
+		return (0.0f);
+
+	size_t rank = static_cast<size_t>(std::ceil(p / 100.0f * sorted.size()));
+	return (sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1]);
+}
+
+// same rule as the scene build: points away from the empty neighbours, up
+// when there are none or all of them are
+glm::vec3	voxelNormal(glm::ivec3 position, const std::function<bool(glm::ivec3)> &filled)
+{
+	glm::vec3 normal(0.0f);
+
+	for (int z = -1; z <= 1; z++)
+		for (int y = -1; y <= 1; y++)
+			for (int x = -1; x <= 1; x++)
+				if (!filled(position + glm::ivec3(x, y, z)))
+					normal += glm::vec3(x, y, z);
+
+	return (glm::length(normal) > 1e-6f ? glm::normalize(normal) : glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// each spec is path:x,y,z[,yaw[,scale]], the position of the model center
+// in world units like --camera, a model is only loaded once
+bool	addInstances(Scene &scene, const std::vector<std::string> &specs)
+{
+	for (const std::string &spec : specs)
+	{
+		size_t colon = spec.rfind(':');
+		if (colon == std::string::npos)
+		{
+			std::cerr << "--instance needs path:x,y,z[,yaw[,scale]], got " << spec << std::endl;
+			return (false);
+		}
+
+		std::string values = spec.substr(colon + 1);
+		std::replace(values.begin(), values.end(), ',', ' ');
+		std::istringstream stream(values);
+
+		glm::vec3 position;
+		float yaw = 0.0f;
+		float scale = 1.0f;
+		stream >> position.x >> position.y >> position.z;
+		if (stream.fail())
+		{
+			std::cerr << "--instance needs x,y,z after the path, got " << spec << std::endl;
+			return (false);
+		}
+		stream >> yaw >> scale;
+
+		int file = scene.loadModel(spec.substr(0, colon));
+		if (file < 0)
+			return (false);
+
+		glm::mat4 transform = Scene::instanceTransform(scene.getModelFiles()[file].size, position / scene.getVoxelSize(), yaw, scale);
+		scene.addInstance(file, transform);
+	}
+	return (true);
+}
+
+// --terrain: the chunks come from the seeded generator, without --camera
+// the camera starts above the ground at the middle of the world
+void	setupTerrain(Scene &scene, const Options &options)
+{
+	if (!options.has_terrain)
+		return ;
+
+	TerrainGenerator generator(options.terrain_seed);
+	scene.setChunkSource(generator.getSource());
+	if (options.has_camera)
+		return ;
+
+	int middle = scene.getWorldDim() / 2;
+	float height = generator.getHeight(middle, middle) + 12.0f;
+
+	Camera *camera = scene.getCamera();
+	camera->setPosition(glm::vec3(middle, height, middle) * scene.getVoxelSize());
+	camera->setDirection(-15.0f, -90.0f);
+	camera->storeGPUData();
+}
+
+// the node and voxel arrays in paged_buffers (nodes then voxels), also
+// used again when the arrays grew, false when they do not fit in the
+// pages, the buffers already there are kept then
+bool	createSceneBuffers(Scene &scene, std::vector<PagedBuffer *> &paged_buffers)
+{
+	RV_TRACE_SCOPE("Upload scene");
+
+	if (scene.flatNodes.size() > PagedBuffer::capacity(sizeof(FlatSVONode))
+		|| scene.flatVoxels.size() > PagedBuffer::capacity(sizeof(GPUVoxel)))
+	{
+		std::cerr << "The scene does not fit in the GPU pages: " << scene.flatNodes.size() << " nodes and "
+			<< scene.flatVoxels.size() << " voxels" << std::endl;
+		return (false);
+	}
+
+	for (PagedBuffer *buffer : paged_buffers)
+		delete (buffer);
+	paged_buffers.clear();
+
+	paged_buffers.push_back(new PagedBuffer(NODE_PAGE_BINDING, sizeof(FlatSVONode), scene.flatNodes.size(), scene.flatNodes.data()));
+	paged_buffers.push_back(new PagedBuffer(VOXEL_PAGE_BINDING, sizeof(GPUVoxel), scene.flatVoxels.size(), scene.flatVoxels.data()));
+	return (true);
+}
+
+// the first upload of a whole scene has nothing to fall back on, a scene
+// that does not fit is never rendered
+void	uploadWholeScene(Scene &scene, std::vector<PagedBuffer *> &paged_buffers)
+{
+	if (!createSceneBuffers(scene, paged_buffers))
+	{
+		std::cerr << "Try a smaller --world" << std::endl;
+		exit(-1);
+	}
+}
+
+// uniforms in buffers, the scene arrays through createSceneBuffers
+std::vector<Buffer *>	createDataOnGPU(Scene &scene, std::vector<PagedBuffer *> &paged_buffers)
+{
 	std::vector<Buffer *> buffers;
 	
-	buffers.push_back(new Buffer(Buffer::Type::UBO, 0, sizeof(GPUCamera), nullptr));
-	buffers.push_back(new Buffer(Buffer::Type::UBO, 1, sizeof(GPUDebug), nullptr));
+	buffers.push_back(new Buffer(Buffer::Type::UBO, 0, sizeof(GPUCamera), nullptr, Buffer::STREAM));
+	buffers.push_back(new Buffer(Buffer::Type::UBO, 1, sizeof(GPUDebug), nullptr, Buffer::STREAM));
+	buffers.push_back(new Buffer(Buffer::Type::UBO, 2, sizeof(GPUDenoise), nullptr, Buffer::STREAM));
+	buffers.push_back(new Buffer(Buffer::Type::UBO, 3, sizeof(GPUCamera), nullptr, Buffer::STREAM));
 	
-	buffers.push_back(new Buffer(Buffer::Type::SSBO, 0, sizeof(FlatSVONode) * flatNodes.size(), flatNodes.data()));
-	buffers.push_back(new Buffer(Buffer::Type::SSBO, 1, sizeof(GPUVoxel) * flatVoxels.size(), flatVoxels.data()));
+	uploadWholeScene(scene, paged_buffers);
 
 	return (buffers);
 }
 
-void	updateDataOnGPU(Scene &scene, std::vector<Buffer *> buffers)
+void	updateDataOnGPU(Scene &scene, const std::vector<Buffer *> &buffers)
 {
-
 	GPUCamera camera_data = scene.getCamera()->getGPUData();
 	buffers[0]->update(&camera_data, sizeof(GPUCamera));
 
 	buffers[1]->update(&scene.getDebug(), sizeof(GPUDebug));
+	buffers[2]->update(&scene.getDenoise(), sizeof(GPUDenoise));
+	buffers[3]->update(&scene.getCamera()->getPreviousGPUData(), sizeof(GPUCamera));
 }
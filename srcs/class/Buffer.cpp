@@ -0,0 +1,210 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Buffer.cpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:02:16 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 18:02:16 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Buffer.hpp"
+
+StreamRing	*Buffer::_staging = nullptr;
+
+StreamRing::StreamRing(GLenum target, GLsizeiptr region_size) : _target(target), _region_size(region_size)
+{
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &_buffer_id);
+	glBindBuffer(_target, _buffer_id);
+	glBufferStorage(_target, _region_size * BUFFER_FRAMES, nullptr, flags);
+	_mapped = static_cast<uint8_t *>(glMapBufferRange(_target, 0, _region_size * BUFFER_FRAMES, flags));
+	glBindBuffer(_target, 0);
+
+	_region = 0;
+	_head = 0;
+	for (GLsync &fence : _fences)
+		fence = nullptr;
+}
+
+StreamRing::~StreamRing()
+{
+	for (GLsync fence : _fences)
+		if (fence)
+			glDeleteSync(fence);
+
+	glBindBuffer(_target, _buffer_id);
+	glUnmapBuffer(_target);
+	glBindBuffer(_target, 0);
+	glDeleteBuffers(1, &_buffer_id);
+}
+
+// the fence goes behind everything issued so far, which covers the reads
+// of the region that was just filled
+void		StreamRing::nextRegion()
+{
+	if (_fences[_region])
+		glDeleteSync(_fences[_region]);
+	_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	_region = (_region + 1) % BUFFER_FRAMES;
+	_head = 0;
+
+	if (!_fences[_region])
+		return ;
+
+	GLenum status = glClientWaitSync(_fences[_region], 0, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		RV_TRACE_SCOPE("Stream ring wait");
+
+		while (status == GL_TIMEOUT_EXPIRED)
+			status = glClientWaitSync(_fences[_region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	}
+	glDeleteSync(_fences[_region]);
+	_fences[_region] = nullptr;
+}
+
+// offset is from the start of the whole buffer, false when the region is full
+bool		StreamRing::allocate(GLsizeiptr size, GLintptr alignment, GLintptr &offset, void *&data)
+{
+	GLintptr start = (_head + alignment - 1) / alignment * alignment;
+
+	if (!_mapped || start + size > _region_size)
+		return (false);
+
+	offset = _region * _region_size + start;
+	data = _mapped + offset;
+	_head = start + size;
+
+	return (true);
+}
+
+GLuint		StreamRing::getID() const
+{
+	return (_buffer_id);
+}
+
+GLsizeiptr	StreamRing::getRegionSize() const
+{
+	return (_region_size);
+}
+
+Buffer::Buffer(Type type, GLuint binding_point, GLuint size, const void *data, Mode mode)
+	: _type(type), _mode(mode), _binding_point(binding_point), _size(size)
+{
+	_buffer_id = 0;
+	_ring = nullptr;
+
+	GLint alignment = 256;
+	glGetIntegerv(_type == SSBO ? GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT : GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	_alignment = std::max(alignment, 1);
+
+	if (_mode == STREAM)
+	{
+		_ring = new StreamRing(this->getTarget(), (_size + _alignment - 1) / _alignment * _alignment);
+		if (data)
+			this->update(data, _size);
+		else
+			glBindBufferRange(this->getTarget(), _binding_point, _ring->getID(), 0, _size);
+		return ;
+	}
+
+	glGenBuffers(1, &_buffer_id);
+	glBindBuffer(this->getTarget(), _buffer_id);
+	glBufferData(this->getTarget(), size, data, GL_DYNAMIC_DRAW);
+	glBindBufferBase(this->getTarget(), _binding_point, _buffer_id);
+	glBindBuffer(this->getTarget(), 0);
+}
+
+Buffer::~Buffer()
+{
+	delete (_ring);
+	if (_buffer_id)
+		glDeleteBuffers(1, &_buffer_id);
+}
+
+void		Buffer::update(const void *data, GLuint size)
+{
+	if (_mode == STATIC)
+	{
+		glBindBuffer(this->getTarget(), _buffer_id);
+		glBufferSubData(this->getTarget(), 0, size, data);
+		glBindBuffer(this->getTarget(), 0);
+		return ;
+	}
+
+	GLintptr offset;
+	void *mapped;
+
+	_ring->nextRegion();
+	if (!_ring->allocate(size, _alignment, offset, mapped))
+	{
+		// larger than a region (or the ring could not be mapped): a plain
+		// buffer respecified with the data, bound in place of the ring
+		if (!_buffer_id)
+			glGenBuffers(1, &_buffer_id);
+		glBindBuffer(this->getTarget(), _buffer_id);
+		glBufferData(this->getTarget(), size, data, GL_DYNAMIC_DRAW);
+		glBindBufferBase(this->getTarget(), _binding_point, _buffer_id);
+		glBindBuffer(this->getTarget(), 0);
+		return ;
+	}
+
+	memcpy(mapped, data, size);
+	glBindBufferRange(this->getTarget(), _binding_point, _ring->getID(), offset, size);
+}
+
+// part of a STATIC buffer, copied on the gpu from the shared staging ring so
+// the driver neither keeps its own copy nor waits for the buffer to be idle,
+// anything that does not fit the frame's staging region goes the usual way
+void		Buffer::updateRange(const void *data, GLintptr offset, GLsizeiptr size)
+{
+	if (!_staging)
+		_staging = new StreamRing(GL_COPY_READ_BUFFER, STAGING_REGION_SIZE);
+
+	GLintptr staging_offset;
+	void *mapped;
+
+	if (_mode == STREAM || !_staging->allocate(size, 16, staging_offset, mapped))
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer_id);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		return ;
+	}
+
+	memcpy(mapped, data, size);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, _staging->getID());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer_id);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, staging_offset, offset, size);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+GLuint		Buffer::getID() const
+{
+	return (_ring ? _ring->getID() : _buffer_id);
+}
+
+// once per frame, moves the staging ring to its next region
+void		Buffer::nextFrame()
+{
+	if (_staging)
+		_staging->nextRegion();
+}
+
+void		Buffer::releaseStaging()
+{
+	delete (_staging);
+	_staging = nullptr;
+}
+
+GLenum		Buffer::getTarget() const
+{
+	return (_type == SSBO ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER);
+}
@@ -17,6 +17,7 @@ Camera::Camera(glm::vec3 start_pos, glm::vec3 start_up, float start_yaw, float s
 				_velocity(0.0f), _acceleration(0.0f)
 {
 	updateCameraVectors();
+	storeGPUData();
 }
 
 Camera::~Camera(void)
@@ -139,6 +140,28 @@ GPUCamera	Camera::getGPUData()
 	return (data);
 }
 
+GPUCamera	&Camera::getPreviousGPUData()
+{
+	return (_previous_gpu_data);
+}
+
+// anything that changes where primary rays go since the last storeGPUData
+bool		Camera::hasMoved()
+{
+	GPUCamera data = getGPUData();
+
+	return (data.view_matrix != _previous_gpu_data.view_matrix
+		|| data.camera_position != _previous_gpu_data.camera_position
+		|| data.fov != _previous_gpu_data.fov
+		|| data.aperture_size != _previous_gpu_data.aperture_size
+		|| data.focus_distance != _previous_gpu_data.focus_distance);
+}
+
+void		Camera::storeGPUData()
+{
+	_previous_gpu_data = getGPUData();
+}
+
 float		Camera::getVelocity()
 {
 	return (glm::length(_velocity));
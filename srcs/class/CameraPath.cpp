@@ -0,0 +1,167 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CameraPath.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 16:36:45 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 16:36:45 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "CameraPath.hpp"
+
+CameraPath::CameraPath()
+{
+}
+
+CameraPath::~CameraPath()
+{
+}
+
+bool		CameraPath::load(const std::string &path)
+{
+	std::ifstream	file(path);
+	std::string		line;
+	int				line_number = 0;
+
+	if (!file.is_open())
+	{
+		std::cerr << "Failed to open camera path: " << path << std::endl;
+		return (false);
+	}
+
+	_keys.clear();
+	while (std::getline(file, line))
+	{
+		line_number++;
+
+		std::istringstream stream(line);
+		std::string first;
+		if (!(stream >> first) || first[0] == '#')
+			continue ;
+
+		CameraKey key;
+		if (first == "CAM")
+			key.time = _keys.empty() ? 0.0f : _keys.back().time + 1.0f;
+		else
+			key.time = std::strtof(first.c_str(), nullptr);
+
+		stream >> key.position.x >> key.position.y >> key.position.z
+			>> key.direction.x >> key.direction.y
+			>> key.aperture >> key.focus >> key.fov >> key.bounce;
+
+		if (stream.fail() || (!_keys.empty() && key.time < _keys.back().time))
+		{
+			std::cerr << path << ":" << line_number << ": invalid camera key" << std::endl;
+			_keys.clear();
+			return (false);
+		}
+		_keys.push_back(key);
+	}
+
+	if (_keys.empty())
+	{
+		std::cerr << path << ": no camera key" << std::endl;
+		return (false);
+	}
+	return (true);
+}
+
+bool		CameraPath::save(const std::string &path) const
+{
+	std::ofstream file(path);
+
+	if (!file.is_open())
+	{
+		std::cerr << "Failed to open camera path: " << path << std::endl;
+		return (false);
+	}
+
+	file << "# time  x y z  pitch yaw  aperture focus fov  bounce" << std::endl;
+	file << std::setprecision(7);
+	for (const CameraKey &key : _keys)
+	{
+		file << key.time << "\t"
+			<< key.position.x << " " << key.position.y << " " << key.position.z << "\t"
+			<< key.direction.x << " " << key.direction.y << "\t"
+			<< key.aperture << " " << key.focus << " " << key.fov << "\t"
+			<< key.bounce << std::endl;
+	}
+	return (file.good());
+}
+
+void		CameraPath::clear()
+{
+	_keys.clear();
+}
+
+void		CameraPath::addKey(const CameraKey &key)
+{
+	_keys.push_back(key);
+}
+
+// linear between the two keys around time, clamped to the ends of the path
+CameraKey	CameraPath::sample(float time) const
+{
+	if (_keys.empty())
+		return (CameraKey{});
+	if (time <= _keys.front().time)
+		return (_keys.front());
+	if (time >= _keys.back().time)
+		return (_keys.back());
+
+	auto next = std::upper_bound(_keys.begin(), _keys.end(), time,
+		[](float t, const CameraKey &key) { return (t < key.time); });
+	const CameraKey &b = *next;
+	const CameraKey &a = *(next - 1);
+
+	float t = (b.time > a.time) ? (time - a.time) / (b.time - a.time) : 1.0f;
+
+	CameraKey key = a;
+	key.time = time;
+	key.position = glm::mix(a.position, b.position, t);
+	key.direction = glm::mix(a.direction, b.direction, t);
+	key.aperture = glm::mix(a.aperture, b.aperture, t);
+	key.focus = glm::mix(a.focus, b.focus, t);
+	key.fov = glm::mix(a.fov, b.fov, t);
+
+	return (key);
+}
+
+float		CameraPath::getDuration() const
+{
+	if (_keys.empty())
+		return (0.0f);
+	return (_keys.back().time - _keys.front().time);
+}
+
+size_t		CameraPath::getKeyCount() const
+{
+	return (_keys.size());
+}
+
+CameraKey	CameraPath::capture(Camera &camera, float time)
+{
+	CameraKey key;
+
+	key.time = time;
+	key.position = camera.getPosition();
+	key.direction = camera.getDirection();
+	key.aperture = camera.getAperture();
+	key.focus = camera.getFocus();
+	key.fov = camera.getFov();
+	key.bounce = camera.getBounce();
+
+	return (key);
+}
+
+void		CameraPath::apply(Camera &camera, const CameraKey &key)
+{
+	camera.setPosition(key.position);
+	camera.setDirection(key.direction.x, key.direction.y);
+	camera.setDOV(key.aperture, key.focus);
+	camera.setFov(key.fov);
+	camera.setBounce(key.bounce);
+}
@@ -0,0 +1,269 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ChunkWorld.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 15:09:12 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 15:09:12 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ChunkWorld.hpp"
+
+// the (2 radius + 1)² chunks around the camera are built before the first
+// frame, all at once on the pool, later ones come in over the frames
+ChunkWorld::ChunkWorld(Scene &scene, int radius, ChunkSource source) : _scene(scene), _radius(radius), _source(source)
+{
+	RV_TRACE_SCOPE("Chunk world");
+
+	int side = radius * 2 + 1;
+	int capacity = CHUNK_DIM * CHUNK_DIM * CHUNK_SLOT_LAYERS;
+
+	_center = this->cameraChunk();
+	_built = 0;
+	_dropped = 0;
+	_changed = false;
+
+	for (int i = 0; i < side * side; i++)
+	{
+		ChunkSlot slot;
+		slot.chunk = _center + glm::ivec2(i % side, i / side) - radius;
+		slot.model = _scene.reserveModel(glm::ivec3(CHUNK_DIM), capacity, capacity);
+		slot.instance = _scene.addModelInstance(slot.model, this->chunkTransform(slot.chunk));
+		slot.ticket = 0;
+		slot.resident = false;
+		_chunk_slots[{slot.chunk.x, slot.chunk.y}] = _slots.size();
+		_slots.push_back(slot);
+	}
+
+	std::vector<ChunkBuild> builds(_slots.size());
+	ThreadPool::shared().parallelFor(_slots.size(), [this, &builds](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			builds[i].slot = i;
+			builds[i].ticket = 0;
+			this->build(builds[i], _slots[i].chunk);
+		}
+	});
+	for (ChunkBuild &build : builds)
+		this->write(build);
+
+	std::cout << "Chunk world: " << _slots.size() << " slots of " << CHUNK_DIM << "³ around chunk "
+		<< _center.x << "," << _center.y << ", " << static_cast<size_t>(capacity) * _slots.size() * (sizeof(FlatSVONode) + sizeof(GPUVoxel)) / (1024 * 1024) << " MB" << std::endl;
+}
+
+// builds still running point at this
+ChunkWorld::~ChunkWorld()
+{
+	ThreadPool::shared().wait();
+}
+
+glm::ivec2		ChunkWorld::cameraChunk() const
+{
+	glm::vec3 position = _scene.getCamera()->getPosition() / _scene.getVoxelSize();
+
+	return (glm::ivec2(glm::floor(glm::vec2(position.x, position.z) / static_cast<float>(CHUNK_DIM))));
+}
+
+glm::mat4		ChunkWorld::chunkTransform(glm::ivec2 chunk) const
+{
+	return (glm::translate(glm::mat4(1.0f), glm::vec3(chunk.x, 0, chunk.y) * static_cast<float>(CHUNK_DIM)));
+}
+
+// on a worker, the tree of one chunk in its own grid
+void			ChunkWorld::build(ChunkBuild &build, glm::ivec2 chunk)
+{
+	RV_TRACE_SCOPE("Build chunk");
+
+	std::vector<GPUVoxel> voxels;
+	_source(glm::ivec3(chunk.x, 0, chunk.y) * CHUNK_DIM, voxels);
+
+	SVO root(glm::ivec3(0), glm::ivec3(CHUNK_DIM));
+	for (GPUVoxel &voxel : voxels)
+		root.insert(voxel, 16);
+	root.flatten(build.nodes, build.voxels);
+}
+
+// the tree goes at the start of the slot ranges, what is left of the
+// previous chunk past it is not reachable anymore, a chunk that does not
+// fit stays empty
+bool			ChunkWorld::write(const ChunkBuild &build)
+{
+	ChunkSlot &slot = _slots[build.slot];
+	const SceneModel &model = _scene.getModels()[slot.model];
+
+	if (build.nodes.size() > static_cast<size_t>(model.node_count) || build.voxels.size() > static_cast<size_t>(model.voxel_count))
+	{
+		std::cerr << "Chunk " << slot.chunk.x << "," << slot.chunk.y << ": " << build.nodes.size() << " nodes and "
+			<< build.voxels.size() << " voxels do not fit a slot of " << model.node_count << std::endl;
+		_dropped++;
+		return (false);
+	}
+
+	for (size_t i = 0; i < build.nodes.size(); i++)
+	{
+		FlatSVONode node = build.nodes[i];
+		if (node.childOffset >= 0)
+			node.childOffset += model.first_node;
+		if (node.voxelIndex >= 0)
+			node.voxelIndex += model.first_voxel;
+		_scene.flatNodes[model.first_node + i] = node;
+	}
+	std::copy(build.voxels.begin(), build.voxels.end(), _scene.flatVoxels.begin() + model.first_voxel);
+
+	slot.resident = true;
+	_built++;
+	return (true);
+}
+
+// the slot is emptied right away and moved onto its new chunk, the tree
+// follows when the build is done, older builds for the slot are dropped
+void			ChunkWorld::request(int slot_index, glm::ivec2 chunk)
+{
+	ChunkSlot &slot = _slots[slot_index];
+	const SceneModel &model = _scene.getModels()[slot.model];
+
+	slot.chunk = chunk;
+	slot.ticket++;
+	slot.resident = false;
+	_chunk_slots[{chunk.x, chunk.y}] = slot_index;
+
+	FlatSVONode &root = _scene.flatNodes[model.root];
+	root.childOffset = -1;
+	root.voxelIndex = -1;
+	root.voxelCount = 0;
+	root.childMask = 0;
+	root.color = 0;
+	_scene.setInstanceTransform(slot.instance, this->chunkTransform(chunk), true);
+
+	int ticket = slot.ticket;
+	ThreadPool::shared().submit([this, slot_index, ticket, chunk]
+	{
+		ChunkBuild build;
+		build.slot = slot_index;
+		build.ticket = ticket;
+		this->build(build, chunk);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_ready.push_back(std::move(build));
+	});
+}
+
+// hands the slots of chunks out of range to the chunks coming in, nearest
+// first, and writes and uploads the builds that came back
+void			ChunkWorld::update(PagedBuffer &nodes, PagedBuffer &voxels)
+{
+	glm::ivec2 center = this->cameraChunk();
+
+	if (center != _center)
+	{
+		RV_TRACE_SCOPE("Move chunks");
+
+		_center = center;
+
+		std::vector<int> free_slots;
+		for (size_t i = 0; i < _slots.size(); i++)
+		{
+			glm::ivec2 offset = glm::abs(_slots[i].chunk - center);
+			if (std::max(offset.x, offset.y) > _radius)
+			{
+				_chunk_slots.erase({_slots[i].chunk.x, _slots[i].chunk.y});
+				free_slots.push_back(i);
+			}
+		}
+
+		std::vector<glm::ivec2> missing;
+		for (int z = -_radius; z <= _radius; z++)
+			for (int x = -_radius; x <= _radius; x++)
+				if (!_chunk_slots.count({center.x + x, center.y + z}))
+					missing.push_back(center + glm::ivec2(x, z));
+		std::sort(missing.begin(), missing.end(), [&center](glm::ivec2 a, glm::ivec2 b)
+		{
+			return (glm::length(glm::vec2(a - center)) < glm::length(glm::vec2(b - center)));
+		});
+
+		for (size_t i = 0; i < free_slots.size() && i < missing.size(); i++)
+		{
+			this->request(free_slots[i], missing[i]);
+
+			int root = _scene.getModels()[_slots[free_slots[i]].model].root;
+			nodes.updateRange(&_scene.flatNodes[root], root, 1);
+		}
+		_changed = true;
+	}
+
+	std::vector<ChunkBuild> ready;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		ready.swap(_ready);
+	}
+
+	for (const ChunkBuild &build : ready)
+	{
+		if (build.ticket != _slots[build.slot].ticket || !this->write(build))
+			continue ;
+
+		const SceneModel &model = _scene.getModels()[_slots[build.slot].model];
+		nodes.updateRange(&_scene.flatNodes[model.first_node], model.first_node, build.nodes.size());
+		if (!build.voxels.empty())
+			voxels.updateRange(&_scene.flatVoxels[model.first_voxel], model.first_voxel, build.voxels.size());
+		_changed = true;
+	}
+}
+
+// true once after chunks moved or came in, accumulated frames are stale then
+bool			ChunkWorld::consumeChanges()
+{
+	bool changed = _changed;
+
+	_changed = false;
+	return (changed);
+}
+
+void			ChunkWorld::imGuiRender()
+{
+	if (!ImGui::CollapsingHeader("Chunks"))
+		return ;
+
+	int resident = 0;
+	for (const ChunkSlot &slot : _slots)
+		resident += slot.resident;
+
+	ImGui::Text("Center %d,%d  Radius %d", _center.x, _center.y, _radius);
+	ImGui::Text("Resident %d / %zu slots", resident, _slots.size());
+	ImGui::Text("Built %d  Dropped %d", _built, _dropped);
+}
+
+// the floor of the world box carried on past it, columns inside the box
+// are left to the world tree
+ChunkSource		ChunkWorld::groundSource(int world_dim)
+{
+	return ([world_dim](glm::ivec3 origin, std::vector<GPUVoxel> &voxels)
+	{
+		std::minstd_rand random(static_cast<uint32_t>(origin.x * 73856093) ^ static_cast<uint32_t>(origin.z * 19349663));
+		auto filled = [](glm::ivec3 p) { return (p.y <= 2); };
+
+		for (int z = 0; z < CHUNK_DIM; ++z)
+		{
+			for (int x = 0; x < CHUNK_DIM; ++x)
+			{
+				glm::ivec3 column = origin + glm::ivec3(x, 0, z);
+				if (column.x >= 0 && column.x < world_dim && column.z >= 0 && column.z < world_dim)
+					continue ;
+
+				for (int y = 0; y <= 2; ++y)
+				{
+					GPUVoxel voxel;
+					voxel.position = glm::ivec3(x, y, z);
+					voxel.color = (20 << 24) | ((100 + static_cast<int>(random() % 25)) << 16) | (20 << 8) | 0xFF;
+					voxel.normal = voxelNormal(column + glm::ivec3(0, y, 0), filled);
+					voxel.light = 0;
+					voxels.push_back(voxel);
+				}
+			}
+		}
+	});
+}
@@ -0,0 +1,96 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Denoiser.cpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 14:05:37 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 14:05:37 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Denoiser.hpp"
+
+Denoiser::Denoiser()
+{
+	_variance_shader = new Shader(GL_COMPUTE_SHADER, "shaders/variance.glsl");
+	_atrous_shader = new Shader(GL_COMPUTE_SHADER, "shaders/atrous.glsl");
+
+	_variance_program = new ShaderProgram();
+	_variance_program->attachShader(_variance_shader);
+	_variance_program->link();
+
+	_atrous_program = new ShaderProgram();
+	_atrous_program->attachShader(_atrous_shader);
+	_atrous_program->link();
+}
+
+Denoiser::~Denoiser()
+{
+	delete (_variance_program);
+	delete (_atrous_program);
+	delete (_variance_shader);
+	delete (_atrous_shader);
+}
+
+void	Denoiser::process(std::vector<GLuint> &textures, GPUDenoise &settings, glm::vec2 resolution)
+{
+	GLuint	groups_x = (static_cast<GLuint>(resolution.x) + 15) / 16;
+	GLuint	groups_y = (static_cast<GLuint>(resolution.y) + 15) / 16;
+
+	_variance_program->use();
+	_variance_program->bindImageTexture(textures[DENOISE_PING_TEXTURE], 7, GL_WRITE_ONLY, GL_RGBA32F);
+	_variance_program->set_vec2("u_resolution", resolution);
+	_variance_program->dispathCompute(groups_x, groups_y, 1);
+
+	_atrous_program->use();
+	_atrous_program->set_vec2("u_resolution", resolution);
+
+	for (int i = 0; i < settings.iterations; i++)
+	{
+		GLuint src = textures[i % 2 == 0 ? DENOISE_PING_TEXTURE : DENOISE_PONG_TEXTURE];
+		GLuint dst = textures[i % 2 == 0 ? DENOISE_PONG_TEXTURE : DENOISE_PING_TEXTURE];
+
+		_atrous_program->bindImageTexture(src, 6, GL_READ_ONLY, GL_RGBA32F);
+		_atrous_program->bindImageTexture(dst, 7, GL_WRITE_ONLY, GL_RGBA32F);
+		_atrous_program->set_int("u_step", 1 << i);
+		_atrous_program->set_int("u_last", i == settings.iterations - 1);
+		_atrous_program->dispathCompute(groups_x, groups_y, 1);
+	}
+}
+
+// runs the gpu passes and the cpu reference on the same inputs, returns the biggest difference
+float	Denoiser::validate(std::vector<GLuint> &textures, GPUDenoise &settings, glm::vec2 resolution)
+{
+	DenoiseImages	images;
+	glm::ivec2		size = glm::ivec2(resolution);
+
+	readImages(textures, size, images);
+
+	this->process(textures, settings, resolution);
+
+	std::vector<glm::vec4> gpu_output;
+	readTexture(textures[OUTPUT_TEXTURE], size, gpu_output);
+
+	reference(images, settings);
+
+	float max_error = 0.0f;
+	for (size_t i = 0; i < gpu_output.size(); i++)
+	{
+		glm::vec3 error = glm::abs(glm::vec3(gpu_output[i]) - glm::vec3(images.color[i]));
+		max_error = std::max(max_error, std::max(error.x, std::max(error.y, error.z)));
+	}
+
+	std::cout << "Denoiser max error against cpu reference: " << max_error << std::endl;
+	return (max_error);
+}
+
+void	Denoiser::readImages(std::vector<GLuint> &textures, glm::ivec2 resolution, DenoiseImages &images)
+{
+	images.resolution = resolution;
+	readTexture(textures[OUTPUT_TEXTURE], resolution, images.color);
+	readTexture(textures[NORMAL_DEPTH_TEXTURE], resolution, images.normal_depth);
+	readTexture(textures[ALBEDO_TEXTURE], resolution, images.albedo);
+	readTexture(textures[MOMENTS_TEXTURE], resolution, images.moments);
+}
@@ -0,0 +1,179 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   DenoiserReference.cpp                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 14:31:02 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 14:31:02 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Denoiser.hpp"
+
+// cpu versions of shaders/variance.glsl and shaders/atrous.glsl, kept tap for tap
+// identical so a frame read back from the gpu can be checked against them
+
+static float		luminance(glm::vec3 color)
+{
+	return (glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f)));
+}
+
+static glm::vec3	demodulate(glm::vec3 color, glm::vec3 albedo)
+{
+	return (color / glm::max(albedo, glm::vec3(1e-3f)));
+}
+
+static glm::vec3	remodulate(glm::vec3 irradiance, glm::vec3 albedo)
+{
+	return (irradiance * glm::max(albedo, glm::vec3(1e-3f)));
+}
+
+static bool			insideImage(glm::ivec2 coords, glm::ivec2 resolution)
+{
+	return (coords.x >= 0 && coords.y >= 0 && coords.x < resolution.x && coords.y < resolution.y);
+}
+
+static float		spatialVariance(const DenoiseImages &images, glm::ivec2 pixel_coords)
+{
+	float sum = 0.0f;
+	float sum_squared = 0.0f;
+	float count = 0.0f;
+
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			glm::ivec2 coords = pixel_coords + glm::ivec2(x, y);
+			if (!insideImage(coords, images.resolution))
+				continue;
+
+			int index = coords.x + coords.y * images.resolution.x;
+			float lum = luminance(demodulate(glm::vec3(images.color[index]), glm::vec3(images.albedo[index])));
+
+			sum += lum;
+			sum_squared += lum * lum;
+			count += 1.0f;
+		}
+	}
+
+	float mean = sum / count;
+	return (std::max(sum_squared / count - mean * mean, 0.0f));
+}
+
+void	Denoiser::referenceVariance(const DenoiseImages &images, const GPUDenoise &settings, std::vector<glm::vec4> &dst)
+{
+	glm::ivec2 resolution = images.resolution;
+
+	dst.resize(images.color.size());
+
+	for (int y = 0; y < resolution.y; y++)
+	{
+		for (int x = 0; x < resolution.x; x++)
+		{
+			int index = x + y * resolution.x;
+
+			glm::vec3 irradiance = demodulate(glm::vec3(images.color[index]), glm::vec3(images.albedo[index]));
+
+			float variance = 1.0f;
+
+			if (settings.temporal != 0)
+			{
+				glm::vec4 moments = images.moments[index];
+
+				if (moments.z < 4.0f)
+					variance = spatialVariance(images, glm::ivec2(x, y));
+				else
+					variance = std::max(moments.y - moments.x * moments.x, 0.0f);
+			}
+
+			dst[index] = glm::vec4(irradiance, variance);
+		}
+	}
+}
+
+void	Denoiser::referenceAtrous(const DenoiseImages &images, const GPUDenoise &settings, int step, const std::vector<glm::vec4> &src, std::vector<glm::vec4> &dst)
+{
+	static const float kernel[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+
+	glm::ivec2 resolution = images.resolution;
+	dst.resize(src.size());
+
+	for (int py = 0; py < resolution.y; py++)
+	{
+		for (int px = 0; px < resolution.x; px++)
+		{
+			int			center_index = px + py * resolution.x;
+			glm::vec4	center = src[center_index];
+			glm::vec4	center_normal_depth = images.normal_depth[center_index];
+			glm::vec3	center_albedo = glm::vec3(images.albedo[center_index]);
+
+			if (center_normal_depth.w < 0.0f)
+			{
+				dst[center_index] = center;
+				continue;
+			}
+
+			float sigma_lum = settings.phi_color * std::sqrt(std::max(center.a, 0.0f)) + 1e-4f;
+			float center_lum = luminance(glm::vec3(center));
+
+			glm::vec3	sum_color(0.0f);
+			float		sum_variance = 0.0f;
+			float		sum_weight = 0.0f;
+
+			for (int y = -2; y <= 2; y++)
+			{
+				for (int x = -2; x <= 2; x++)
+				{
+					glm::ivec2 coords = glm::ivec2(px, py) + glm::ivec2(x, y) * step;
+					if (!insideImage(coords, resolution))
+						continue;
+
+					int index = coords.x + coords.y * resolution.x;
+
+					glm::vec4 normal_depth = images.normal_depth[index];
+					if (normal_depth.w < 0.0f)
+						continue;
+
+					glm::vec4 sample_color = src[index];
+					glm::vec3 albedo = glm::vec3(images.albedo[index]);
+
+					float w_normal = std::pow(std::max(glm::dot(glm::vec3(center_normal_depth), glm::vec3(normal_depth)), 0.0f), settings.phi_normal);
+					float w_depth = std::exp(-std::abs(center_normal_depth.w - normal_depth.w) / (settings.phi_depth * center_normal_depth.w * float(step) + 1e-4f));
+					float w_lum = std::exp(-std::abs(center_lum - luminance(glm::vec3(sample_color))) / sigma_lum);
+					float w_albedo = std::exp(-glm::length(center_albedo - albedo) / (settings.phi_albedo + 1e-4f));
+
+					float weight = kernel[std::abs(x)] * kernel[std::abs(y)] * w_normal * w_depth * w_lum * w_albedo;
+
+					sum_color += glm::vec3(sample_color) * weight;
+					sum_variance += sample_color.a * weight * weight;
+					sum_weight += weight;
+				}
+			}
+
+			dst[center_index] = glm::vec4(sum_color / sum_weight, sum_variance / (sum_weight * sum_weight));
+		}
+	}
+}
+
+// full denoise on the cpu, images.color holds the result afterwards
+void	Denoiser::reference(DenoiseImages &images, const GPUDenoise &settings)
+{
+	std::vector<glm::vec4> ping;
+	std::vector<glm::vec4> pong;
+
+	referenceVariance(images, settings, ping);
+
+	if (settings.iterations <= 0)
+		return ;
+
+	for (int i = 0; i < settings.iterations; i++)
+	{
+		referenceAtrous(images, settings, 1 << i, ping, pong);
+		std::swap(ping, pong);
+	}
+
+	for (size_t i = 0; i < ping.size(); i++)
+		images.color[i] = glm::vec4(remodulate(glm::vec3(ping[i]), glm::vec3(images.albedo[i])), 1.0f);
+}
@@ -0,0 +1,85 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   DynamicResolution.cpp                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 10:58:44 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 10:58:44 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "DynamicResolution.hpp"
+
+DynamicResolution::DynamicResolution(glm::ivec2 display)
+{
+	_display = display;
+	_previous_resolution = glm::vec2(display);
+}
+
+DynamicResolution::~DynamicResolution()
+{
+}
+
+// gpu_ms is what the resolution dependent passes took, as measured by the profiler
+void		DynamicResolution::update(float gpu_ms)
+{
+	_gpu_ms = gpu_ms;
+	if (_enabled && gpu_ms > 0.0f)
+		this->adjust(gpu_ms);
+}
+
+void		DynamicResolution::endFrame()
+{
+	_previous_resolution = this->getResolution();
+}
+
+// cost follows the pixel count so the scale moves with the square root of the ratio,
+// damped and with a dead zone so it does not chase the noise of the measurement
+void		DynamicResolution::adjust(float gpu_ms)
+{
+	float ratio = _target_ms / std::max(gpu_ms, 0.01f);
+	if (ratio > 0.95f && ratio < 1.05f)
+		return ;
+
+	float wanted = _scale * std::sqrt(ratio);
+	_scale = glm::clamp(glm::mix(_scale, wanted, 0.2f), _min_scale, _max_scale);
+}
+
+glm::vec2	DynamicResolution::getResolution() const
+{
+	glm::ivec2 resolution = glm::ivec2(glm::vec2(_display) * _scale);
+
+	return (glm::vec2(glm::max(resolution, glm::ivec2(1))));
+}
+
+glm::vec2	DynamicResolution::getPreviousResolution() const
+{
+	return (_previous_resolution);
+}
+
+glm::vec2	DynamicResolution::getDisplayResolution() const
+{
+	return (glm::vec2(_display));
+}
+
+bool		&DynamicResolution::getEnabled()
+{
+	return (_enabled);
+}
+
+float		&DynamicResolution::getScale()
+{
+	return (_scale);
+}
+
+float		&DynamicResolution::getTarget()
+{
+	return (_target_ms);
+}
+
+float		DynamicResolution::getGPUTime() const
+{
+	return (_gpu_ms);
+}
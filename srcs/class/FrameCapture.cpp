@@ -0,0 +1,297 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FrameCapture.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:12:44 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 17:12:44 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "FrameCapture.hpp"
+
+FrameCapture::FrameCapture(glm::ivec2 size) : _size(size)
+{
+	_directory = "captures";
+	_format = CAPTURE_PNG;
+
+	_screenshot = false;
+	_recording = false;
+	_frame = 0;
+	_screenshot_count = 0;
+
+	_next_slot = 0;
+	_dropped = 0;
+	_written = 0;
+
+	_stop = false;
+	_busy = false;
+
+	// big enough for either format, a float rgba copy of the output texture
+	GLsizeiptr bytes = static_cast<GLsizeiptr>(_size.x) * _size.y * 4 * sizeof(float);
+
+	for (CaptureSlot &slot : _slots)
+	{
+		glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+		slot.fence = nullptr;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	_thread = std::thread(&FrameCapture::worker, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	this->flush();
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+	_thread.join();
+
+	for (CaptureSlot &slot : _slots)
+		glDeleteBuffers(1, &slot.pbo);
+}
+
+// after the view was drawn and before imgui, so the ui is not in the image:
+// png takes the displayed framebuffer, exr the linear output texture
+void			FrameCapture::capture(GLuint output_texture, glm::vec2 render_size)
+{
+	this->poll(false);
+
+	if (!_screenshot && !_recording)
+		return ;
+
+	size_t queued;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		queued = _jobs.size();
+	}
+
+	CaptureSlot &slot = _slots[_next_slot];
+	if (slot.fence || queued >= CAPTURE_MAX_QUEUED)
+	{
+		_dropped++;
+		return ;
+	}
+
+	char name[64];
+	if (_screenshot)
+		snprintf(name, sizeof(name), "screenshot_%03d", _screenshot_count++);
+	else
+		snprintf(name, sizeof(name), "frame_%05d", _frame++);
+	_screenshot = false;
+
+	slot.format = static_cast<CaptureFormat>(_format);
+	slot.path = _directory + "/" + name + (slot.format == CAPTURE_PNG ? ".png" : ".exr");
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	if (slot.format == CAPTURE_PNG)
+	{
+		slot.size = _size;
+		slot.crop = _size;
+		glReadPixels(0, 0, _size.x, _size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+	else
+	{
+		slot.size = _size;
+		slot.crop = glm::ivec2(render_size);
+		glBindTexture(GL_TEXTURE_2D, output_texture);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, nullptr);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_next_slot = (_next_slot + 1) % CAPTURE_RING_SIZE;
+}
+
+// hands finished copies to the worker, oldest first, without waiting unless asked to
+void			FrameCapture::poll(bool wait)
+{
+	for (int i = 0; i < CAPTURE_RING_SIZE; i++)
+	{
+		CaptureSlot &slot = _slots[(_next_slot + i) % CAPTURE_RING_SIZE];
+		if (!slot.fence)
+			continue ;
+
+		GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000 : 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			if (wait)
+				continue ;
+			break ;
+		}
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+
+		CaptureJob job;
+		job.format = slot.format;
+		job.size = slot.size;
+		job.crop = slot.crop;
+		job.path = slot.path;
+
+		size_t bytes = static_cast<size_t>(slot.size.x) * slot.size.y * (slot.format == CAPTURE_PNG ? 4 : 4 * sizeof(float));
+		job.data.resize(bytes);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+		if (mapped)
+		{
+			memcpy(job.data.data(), mapped, bytes);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		if (!mapped)
+			continue ;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_jobs.push(std::move(job));
+		}
+		_condition.notify_all();
+	}
+}
+
+// blocks until every capture is on disk, for shutdown or the end of a run
+void			FrameCapture::flush()
+{
+	this->poll(true);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_condition.wait(lock, [this] { return (_jobs.empty() && !_busy); });
+}
+
+void			FrameCapture::worker()
+{
+	TraceRecorder::setThreadName("Capture");
+
+	while (true)
+	{
+		CaptureJob job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this] { return (_stop || !_jobs.empty()); });
+			if (_jobs.empty())
+				return ;
+
+			job = std::move(_jobs.front());
+			_jobs.pop();
+			_busy = true;
+		}
+
+		encode(job);
+		_written++;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_busy = false;
+		}
+		_condition.notify_all();
+	}
+}
+
+// gl rows start at the bottom, images are written top down
+void			FrameCapture::encode(CaptureJob &job)
+{
+	RV_TRACE_SCOPE("Encode capture");
+
+	std::filesystem::create_directories(std::filesystem::path(job.path).parent_path());
+
+	if (job.format == CAPTURE_PNG)
+	{
+		std::vector<uint8_t> rgb(static_cast<size_t>(job.crop.x) * job.crop.y * 3);
+		const uint8_t *rgba = reinterpret_cast<const uint8_t *>(job.data.data());
+
+		for (int y = 0; y < job.crop.y; y++)
+		{
+			const uint8_t *src = rgba + static_cast<size_t>(job.crop.y - 1 - y) * job.size.x * 4;
+			uint8_t *dst = rgb.data() + static_cast<size_t>(y) * job.crop.x * 3;
+
+			for (int x = 0; x < job.crop.x; x++)
+			{
+				dst[x * 3 + 0] = src[x * 4 + 0];
+				dst[x * 3 + 1] = src[x * 4 + 1];
+				dst[x * 3 + 2] = src[x * 4 + 2];
+			}
+		}
+		ImageWriter::writePNG(job.path, job.crop, 3, rgb.data());
+	}
+	else
+	{
+		std::vector<float> rgb(static_cast<size_t>(job.crop.x) * job.crop.y * 3);
+		const float *rgba = reinterpret_cast<const float *>(job.data.data());
+
+		for (int y = 0; y < job.crop.y; y++)
+		{
+			const float *src = rgba + static_cast<size_t>(job.crop.y - 1 - y) * job.size.x * 4;
+			float *dst = rgb.data() + static_cast<size_t>(y) * job.crop.x * 3;
+
+			for (int x = 0; x < job.crop.x; x++)
+			{
+				dst[x * 3 + 0] = src[x * 4 + 0];
+				dst[x * 3 + 1] = src[x * 4 + 1];
+				dst[x * 3 + 2] = src[x * 4 + 2];
+			}
+		}
+		ImageWriter::writeEXR(job.path, job.crop, rgb.data());
+	}
+}
+
+void			FrameCapture::requestScreenshot()
+{
+	_screenshot = true;
+}
+
+bool			&FrameCapture::getRecording()
+{
+	return (_recording);
+}
+
+void			FrameCapture::setDirectory(const std::string &directory)
+{
+	_directory = directory;
+}
+
+void			FrameCapture::setFormat(CaptureFormat format)
+{
+	_format = format;
+}
+
+void			FrameCapture::imGuiRender()
+{
+	if (!ImGui::CollapsingHeader("Capture"))
+		return ;
+
+	if (ImGui::Button("Screenshot"))
+		_screenshot = true;
+	ImGui::SameLine();
+	if (ImGui::Checkbox("Record sequence", &_recording) && _recording)
+		_frame = 0;
+
+	ImGui::RadioButton("PNG", &_format, CAPTURE_PNG);
+	ImGui::SameLine();
+	ImGui::RadioButton("EXR (linear)", &_format, CAPTURE_EXR);
+
+	int in_flight = 0;
+	for (CaptureSlot &slot : _slots)
+		in_flight += slot.fence != nullptr;
+
+	size_t queued;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		queued = _jobs.size();
+	}
+
+	ImGui::Text("Written %d  In flight %d  Queued %zu  Dropped %d", _written.load(), in_flight, queued, _dropped);
+	ImGui::TextDisabled("%s", _directory.c_str());
+}
@@ -0,0 +1,121 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Headless.cpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 15:44:57 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 15:44:57 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Headless.hpp"
+
+HeadlessContext::HeadlessContext(glm::ivec2 size) : _size(size)
+{
+	_display = EGL_NO_DISPLAY;
+
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (getPlatformDisplay)
+		_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (_display == EGL_NO_DISPLAY)
+		_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, &major, &minor))
+	{
+		fprintf(stderr, "Failed to initialize EGL\n");
+		exit(-1);
+	}
+	std::cout << "EGL " << major << "." << minor << " " << eglQueryString(_display, EGL_VENDOR) << std::endl;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		fprintf(stderr, "EGL has no desktop OpenGL\n");
+		exit(-1);
+	}
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, 0,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint config_count = 0;
+	if (!eglChooseConfig(_display, config_attribs, &config, 1, &config_count) || config_count == 0)
+	{
+		fprintf(stderr, "No EGL config for an OpenGL context\n");
+		exit(-1);
+	}
+
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 4,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	_context = eglCreateContext(_display, config, EGL_NO_CONTEXT, context_attribs);
+	if (_context == EGL_NO_CONTEXT || !eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context))
+	{
+		fprintf(stderr, "Failed to create an OpenGL 4.4 core context\n");
+		exit(-1);
+	}
+
+	gladLoadGL(reinterpret_cast<GLADloadfunc>(eglGetProcAddress));
+	std::cout << "OpenGL " << glGetString(GL_VERSION) << " on " << glGetString(GL_RENDERER) << std::endl;
+
+	glGenTextures(1, &_color);
+	glBindTexture(GL_TEXTURE_2D, _color);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, _size.x, _size.y);
+
+	glGenFramebuffers(1, &_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _color, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		fprintf(stderr, "Offscreen framebuffer is incomplete\n");
+		exit(-1);
+	}
+	glViewport(0, 0, _size.x, _size.y);
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	glDeleteFramebuffers(1, &_framebuffer);
+	glDeleteTextures(1, &_color);
+
+	eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(_display, _context);
+	eglTerminate(_display);
+}
+
+void		HeadlessContext::bindFramebuffer()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glViewport(0, 0, _size.x, _size.y);
+}
+
+// rgba8, first row is the top of the image
+void		HeadlessContext::readPixels(std::vector<uint8_t> &pixels)
+{
+	size_t row = static_cast<size_t>(_size.x) * 4;
+
+	pixels.resize(row * _size.y);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, _size.x, _size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	for (int y = 0; y < _size.y / 2; y++)
+		std::swap_ranges(pixels.begin() + y * row, pixels.begin() + (y + 1) * row, pixels.begin() + (_size.y - 1 - y) * row);
+}
+
+glm::ivec2	HeadlessContext::getSize() const
+{
+	return (_size);
+}
@@ -0,0 +1,243 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ImageImporter.cpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 10:42:18 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 10:42:18 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ImageImporter.hpp"
+#include "stb_image.h"
+
+bool		ImageImporter::isImage(const std::string &path)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (std::tolower(c)); });
+	for (const char *known : {".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".gif", ".hdr", ".pic", ".pgm", ".ppm"})
+		if (extension == known)
+			return (true);
+	return (false);
+}
+
+// the smallest whole step that fits every side of size in the world
+int			ImageImporter::sampleStep(glm::ivec3 size, int world_dim)
+{
+	int side = std::max(size.x, std::max(size.y, size.z));
+
+	return (std::max(1, (side + world_dim - 1) / world_dim));
+}
+
+// the image stays decoded, 2 bytes a pixel, the heights are read from it
+// as the rows go, a column keeps its cells down to its lowest neighbour
+SVO			*ImageImporter::heightmap(const std::string &path, int world_dim)
+{
+	RV_TRACE_SCOPE("Heightmap");
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	glm::ivec2 image;
+	int channels;
+	stbi_us *pixels = stbi_load_16(path.c_str(), &image.x, &image.y, &channels, 1);
+	if (!pixels)
+	{
+		std::cerr << "Failed to load heightmap " << path << ": " << stbi_failure_reason() << std::endl;
+		return (nullptr);
+	}
+
+	int step = ImageImporter::sampleStep(glm::ivec3(image.x, 1, image.y), world_dim);
+	glm::ivec2 size = (image + step - 1) / step;
+	glm::ivec2 offset = (glm::ivec2(world_dim) - size) / 2;
+	int top = std::max(2, static_cast<int>(world_dim * HEIGHTMAP_HEIGHT));
+
+	auto height = [&](int x, int z)
+	{
+		if (x < 0 || z < 0 || x >= size.x || z >= size.y)
+			return (0);
+		return (1 + pixels[static_cast<size_t>(z * step) * image.x + x * step] * (top - 1) / 65535);
+	};
+	auto filled = [&](glm::ivec3 p) { return (p.y < 0 || p.y < height(p.x, p.z)); };
+
+	int bands = (size.y + IMPORT_BAND - 1) / IMPORT_BAND;
+	std::vector<SVO *> trees(bands, nullptr);
+	std::atomic<size_t> count(0);
+
+	ThreadPool::shared().parallelFor(bands, [&](int begin, int end)
+	{
+		for (int band = begin; band < end; band++)
+		{
+			SVO *tree = new SVO(glm::ivec3(0), glm::ivec3(world_dim));
+			size_t inserted = 0;
+
+			for (int z = band * IMPORT_BAND; z < std::min(size.y, (band + 1) * IMPORT_BAND); z++)
+			{
+				for (int x = 0; x < size.x; x++)
+				{
+					int h = height(x, z);
+					int lowest = std::min(std::min(height(x - 1, z), height(x + 1, z)), std::min(height(x, z - 1), height(x, z + 1)));
+
+					for (int y = std::min(lowest, h - 1); y < h; y++)
+					{
+						// sand, grass, rock then snow with the height,
+						// rock on steep sides and below the surface
+						float t = static_cast<float>(y) / top;
+						glm::vec3 color(120, 118, 112);
+						if (y == h - 1 && h - lowest < 3)
+						{
+							if (t < 0.12f)
+								color = glm::vec3(205, 190, 135);
+							else if (t < 0.55f)
+								color = glm::mix(glm::vec3(85, 150, 60), glm::vec3(60, 110, 50), (t - 0.12f) / 0.43f);
+							else if (t > 0.8f)
+								color = glm::vec3(235, 240, 245);
+						}
+
+						GPUVoxel voxel;
+						voxel.position = glm::ivec3(offset.x + x, y, offset.y + z);
+						voxel.color = (static_cast<int>(color.r) << 24) | (static_cast<int>(color.g) << 16) | (static_cast<int>(color.b) << 8) | 0xFF;
+						voxel.normal = voxelNormal(glm::ivec3(x, y, z), filled);
+						voxel.light = 0;
+						tree->insert(voxel, 16);
+						inserted++;
+					}
+				}
+			}
+			trees[band] = tree;
+			count += inserted;
+		}
+	});
+	stbi_image_free(pixels);
+
+	SVO *root = SVO::mergeAll(trees);
+
+	std::cout << "Heightmap " << path << ": " << image.x << "x" << image.y << " step " << step << ", "
+		<< count << " voxels in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count()
+		<< "ms on " << ThreadPool::shared().getThreadCount() << " threads" << std::endl;
+	return (root);
+}
+
+// a band of layers goes up one slice at a time with the slices below and
+// above it, a layer is the sampled slice, a color where it is solid and 0
+// where it is not, solid cells with an empty side are kept
+SVO			*ImageImporter::stack(const std::string &path, int world_dim)
+{
+	RV_TRACE_SCOPE("Image stack");
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::string> slices;
+	std::error_code error;
+	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(path, error))
+		if (entry.is_regular_file() && ImageImporter::isImage(entry.path().string()))
+			slices.push_back(entry.path().string());
+	std::sort(slices.begin(), slices.end());
+
+	glm::ivec2 image;
+	int channels;
+	if (slices.empty() || !stbi_info(slices[0].c_str(), &image.x, &image.y, &channels))
+	{
+		std::cerr << "Failed to load image stack " << path << ": no slices" << std::endl;
+		return (nullptr);
+	}
+
+	int step = ImageImporter::sampleStep(glm::ivec3(image.x, slices.size(), image.y), world_dim);
+	glm::ivec3 size = (glm::ivec3(image.x, slices.size(), image.y) + step - 1) / step;
+	glm::ivec3 offset = glm::ivec3(world_dim - size.x, 0, world_dim - size.z) / 2;
+
+	auto load = [&](int y, std::vector<uint32_t> &layer)
+	{
+		layer.assign(static_cast<size_t>(size.x) * size.z, 0);
+		if (y < 0 || y >= size.y)
+			return ;
+
+		const std::string &slice = slices[y * step];
+		glm::ivec2 slice_size;
+		stbi_uc *pixels = stbi_load(slice.c_str(), &slice_size.x, &slice_size.y, &channels, 4);
+		if (!pixels || slice_size != image)
+		{
+			std::cerr << "Failed to load slice " << slice << (pixels ? ": size differs from the first slice" : "") << std::endl;
+			stbi_image_free(pixels);
+			return ;
+		}
+
+		for (int z = 0; z < size.z; z++)
+		{
+			for (int x = 0; x < size.x; x++)
+			{
+				const stbi_uc *pixel = pixels + (static_cast<size_t>(z * step) * image.x + x * step) * 4;
+				int luminance = (pixel[0] * 77 + pixel[1] * 150 + pixel[2] * 29) >> 8;
+
+				if (luminance >= STACK_THRESHOLD && pixel[3] >= 128)
+					layer[x + static_cast<size_t>(size.x) * z] = (pixel[0] << 24) | (pixel[1] << 16) | (pixel[2] << 8) | 0xFF;
+			}
+		}
+		stbi_image_free(pixels);
+	};
+
+	int bands = (size.y + IMPORT_BAND - 1) / IMPORT_BAND;
+	std::vector<SVO *> trees(bands, nullptr);
+	std::atomic<size_t> count(0);
+
+	ThreadPool::shared().parallelFor(bands, [&](int begin, int end)
+	{
+		std::vector<uint32_t> layers[3];
+
+		for (int band = begin; band < end; band++)
+		{
+			SVO *tree = new SVO(glm::ivec3(0), glm::ivec3(world_dim));
+			size_t inserted = 0;
+			int first = band * IMPORT_BAND;
+
+			load(first - 1, layers[0]);
+			load(first, layers[1]);
+			for (int y = first; y < std::min(size.y, first + IMPORT_BAND); y++)
+			{
+				load(y + 1, layers[2]);
+
+				auto cell = [&](glm::ivec3 p)
+				{
+					if (p.x < 0 || p.z < 0 || p.x >= size.x || p.z >= size.z)
+						return (0u);
+					return (layers[p.y - y + 1][p.x + static_cast<size_t>(size.x) * p.z]);
+				};
+				auto filled = [&](glm::ivec3 p) { return (cell(p) != 0); };
+
+				for (int z = 0; z < size.z; z++)
+				{
+					for (int x = 0; x < size.x; x++)
+					{
+						glm::ivec3 p(x, y, z);
+						uint32_t color = cell(p);
+						if (color == 0 || (filled(p + glm::ivec3(1, 0, 0)) && filled(p - glm::ivec3(1, 0, 0))
+							&& filled(p + glm::ivec3(0, 1, 0)) && filled(p - glm::ivec3(0, 1, 0))
+							&& filled(p + glm::ivec3(0, 0, 1)) && filled(p - glm::ivec3(0, 0, 1))))
+							continue ;
+
+						GPUVoxel voxel;
+						voxel.position = offset + p;
+						voxel.color = color;
+						voxel.normal = voxelNormal(p, filled);
+						voxel.light = 0;
+						tree->insert(voxel, 16);
+						inserted++;
+					}
+				}
+				std::swap(layers[0], layers[1]);
+				std::swap(layers[1], layers[2]);
+			}
+			trees[band] = tree;
+			count += inserted;
+		}
+	});
+
+	SVO *root = SVO::mergeAll(trees);
+
+	std::cout << "Image stack " << path << ": " << slices.size() << " slices of " << image.x << "x" << image.y << " step " << step << ", "
+		<< count << " voxels in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count()
+		<< "ms on " << ThreadPool::shared().getThreadCount() << " threads" << std::endl;
+	return (root);
+}
@@ -0,0 +1,231 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ImageWriter.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 15:58:03 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 15:58:03 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ImageWriter.hpp"
+
+static void	pushBigEndian(std::vector<uint8_t> &data, uint32_t value)
+{
+	data.push_back(value >> 24);
+	data.push_back(value >> 16);
+	data.push_back(value >> 8);
+	data.push_back(value);
+}
+
+template <typename T>
+static void	pushLittleEndian(std::vector<uint8_t> &data, T value)
+{
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+static void	pushAttribute(std::vector<uint8_t> &data, const char *name, const char *type, const std::vector<uint8_t> &value)
+{
+	data.insert(data.end(), name, name + strlen(name) + 1);
+	data.insert(data.end(), type, type + strlen(type) + 1);
+	pushLittleEndian<int32_t>(data, value.size());
+	data.insert(data.end(), value.begin(), value.end());
+}
+
+uint32_t	ImageWriter::crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+	static uint32_t	table[256];
+	static bool		table_ready = false;
+
+	if (!table_ready)
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		table_ready = true;
+	}
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return (~crc);
+}
+
+uint32_t	ImageWriter::adler32(uint32_t adler, const uint8_t *data, size_t size)
+{
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+
+	while (size > 0)
+	{
+		size_t block = std::min<size_t>(size, 5552);
+
+		for (size_t i = 0; i < block; i++)
+		{
+			a += data[i];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+
+		data += block;
+		size -= block;
+	}
+	return ((b << 16) | a);
+}
+
+void		ImageWriter::writeChunk(std::ofstream &file, const char *type, const std::vector<uint8_t> &data)
+{
+	std::vector<uint8_t> chunk;
+
+	pushBigEndian(chunk, data.size());
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	pushBigEndian(chunk, crc32(0, chunk.data() + 4, chunk.size() - 4));
+
+	file.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+}
+
+// channels is 3 (rgb) or 4 (rgba), rows go from the top of the image down
+bool		ImageWriter::writePNG(const std::string &path, glm::ivec2 size, int channels, const uint8_t *pixels)
+{
+	std::ofstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+	{
+		std::cerr << "Failed to open image file: " << path << std::endl;
+		return (false);
+	}
+
+	const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	file.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+	std::vector<uint8_t> header;
+	pushBigEndian(header, size.x);
+	pushBigEndian(header, size.y);
+	header.push_back(8);
+	header.push_back(channels == 4 ? 6 : 2);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	writeChunk(file, "IHDR", header);
+
+	// every row starts with its filter type, 0 is none
+	size_t row = static_cast<size_t>(size.x) * channels;
+	std::vector<uint8_t> raw;
+	raw.reserve((row + 1) * size.y);
+	for (int y = 0; y < size.y; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), pixels + y * row, pixels + (y + 1) * row);
+	}
+
+	std::vector<uint8_t> zlib;
+	zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+	for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535)
+	{
+		uint16_t length = std::min<size_t>(raw.size() - offset, 65535);
+		bool last = offset + length >= raw.size();
+
+		zlib.push_back(last);
+		zlib.push_back(length & 0xFF);
+		zlib.push_back(length >> 8);
+		zlib.push_back(~length & 0xFF);
+		zlib.push_back((~length >> 8) & 0xFF);
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+
+		if (last)
+			break ;
+	}
+	pushBigEndian(zlib, adler32(1, raw.data(), raw.size()));
+	writeChunk(file, "IDAT", zlib);
+
+	writeChunk(file, "IEND", {});
+
+	return (file.good());
+}
+
+// scanline exr, no compression, 32 bit float B G R channels (the format
+// wants them sorted by name), rows go from the top of the image down
+bool		ImageWriter::writeEXR(const std::string &path, glm::ivec2 size, const float *rgb)
+{
+	std::ofstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+	{
+		std::cerr << "Failed to open image file: " << path << std::endl;
+		return (false);
+	}
+
+	std::vector<uint8_t> header;
+	pushLittleEndian<uint32_t>(header, 20000630);
+	pushLittleEndian<uint32_t>(header, 2);
+
+	std::vector<uint8_t> channels;
+	for (const char *name : {"B", "G", "R"})
+	{
+		channels.insert(channels.end(), name, name + 2);
+		pushLittleEndian<int32_t>(channels, 2);
+		pushLittleEndian<uint8_t>(channels, 0);
+		channels.insert(channels.end(), 3, 0);
+		pushLittleEndian<int32_t>(channels, 1);
+		pushLittleEndian<int32_t>(channels, 1);
+	}
+	channels.push_back(0);
+
+	std::vector<uint8_t> window;
+	pushLittleEndian<int32_t>(window, 0);
+	pushLittleEndian<int32_t>(window, 0);
+	pushLittleEndian<int32_t>(window, size.x - 1);
+	pushLittleEndian<int32_t>(window, size.y - 1);
+
+	std::vector<uint8_t> one, center;
+	pushLittleEndian<float>(one, 1.0f);
+	pushLittleEndian<float>(center, 0.0f);
+	pushLittleEndian<float>(center, 0.0f);
+
+	pushAttribute(header, "channels", "chlist", channels);
+	pushAttribute(header, "compression", "compression", {0});
+	pushAttribute(header, "dataWindow", "box2i", window);
+	pushAttribute(header, "displayWindow", "box2i", window);
+	pushAttribute(header, "lineOrder", "lineOrder", {0});
+	pushAttribute(header, "pixelAspectRatio", "float", one);
+	pushAttribute(header, "screenWindowCenter", "v2f", center);
+	pushAttribute(header, "screenWindowWidth", "float", one);
+	header.push_back(0);
+
+	// offset table, then every line: y, byte count, one run of floats per channel
+	uint32_t line_bytes = size.x * 3 * sizeof(float);
+	uint64_t offset = header.size() + static_cast<uint64_t>(size.y) * sizeof(uint64_t);
+	for (int y = 0; y < size.y; y++)
+	{
+		pushLittleEndian<uint64_t>(header, offset);
+		offset += 2 * sizeof(int32_t) + line_bytes;
+	}
+	file.write(reinterpret_cast<const char *>(header.data()), header.size());
+
+	std::vector<float> line(size.x * 3);
+	for (int y = 0; y < size.y; y++)
+	{
+		const float *row = rgb + static_cast<size_t>(y) * size.x * 3;
+
+		for (int c = 0; c < 3; c++)
+			for (int x = 0; x < size.x; x++)
+				line[c * size.x + x] = row[x * 3 + 2 - c];
+
+		int32_t line_header[2] = {y, static_cast<int32_t>(line_bytes)};
+		file.write(reinterpret_cast<const char *>(line_header), sizeof(line_header));
+		file.write(reinterpret_cast<const char *>(line.data()), line_bytes);
+	}
+
+	return (file.good());
+}
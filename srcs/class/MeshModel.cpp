@@ -0,0 +1,651 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MeshModel.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 14:03:51 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 14:03:51 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "MeshModel.hpp"
+#include "stb_image.h"
+
+MeshModel::MeshModel(const std::string &path) : _min(std::numeric_limits<float>::max()), _max(-std::numeric_limits<float>::max())
+{
+	RV_TRACE_SCOPE("Load mesh");
+
+	std::string extension = std::filesystem::path(path).extension().string();
+
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (std::tolower(c)); });
+	if (extension == ".ply")
+		_parsed = this->parsePLY(path);
+	else
+		_parsed = this->parseOBJ(path);
+	_parsed = _parsed && !_triangles.empty();
+}
+
+bool		MeshModel::isMesh(const std::string &path)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (std::tolower(c)); });
+	return (extension == ".obj" || extension == ".ply");
+}
+
+const bool	&MeshModel::isParsed() const
+{
+	return (_parsed);
+}
+
+glm::vec3	MeshModel::getMin() const
+{
+	return (_min);
+}
+
+glm::vec3	MeshModel::getMax() const
+{
+	return (_max);
+}
+
+size_t		MeshModel::getTriangleCount() const
+{
+	return (_triangles.size());
+}
+
+void		MeshModel::addPolygon(const std::vector<glm::vec3> &positions, const std::vector<glm::vec2> &uvs, const std::vector<glm::vec3> &colors, int material)
+{
+	for (size_t i = 1; i + 1 < positions.size(); i++)
+	{
+		MeshTriangle triangle;
+		size_t corners[3] = {0, i, i + 1};
+
+		for (int c = 0; c < 3; c++)
+		{
+			triangle.position[c] = positions[corners[c]];
+			triangle.uv[c] = uvs[corners[c]];
+			triangle.color[c] = colors[corners[c]];
+			_min = glm::min(_min, triangle.position[c]);
+			_max = glm::max(_max, triangle.position[c]);
+		}
+		triangle.material = material;
+		_triangles.push_back(triangle);
+	}
+}
+
+// v x y z [r g b], vt u v, f v[/vt[/vn]]... with negative indices from
+// the end, mtllib and usemtl, normals and the rest are ignored
+bool		MeshModel::parseOBJ(const std::string &path)
+{
+	std::ifstream file(path);
+	std::string line;
+	int line_number = 0;
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+	if (!file.is_open())
+	{
+		std::cerr << "Failed to open mesh file: " << path << std::endl;
+		return (false);
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> colors;
+	std::vector<glm::vec2> uvs;
+	std::map<std::string, int> names;
+	int material = -1;
+
+	std::vector<glm::vec3> face_positions;
+	std::vector<glm::vec2> face_uvs;
+	std::vector<glm::vec3> face_colors;
+
+	while (std::getline(file, line))
+	{
+		line_number++;
+
+		std::istringstream stream(line);
+		std::string kind;
+		if (!(stream >> kind) || kind[0] == '#')
+			continue ;
+
+		bool valid = true;
+		if (kind == "v")
+		{
+			glm::vec3 position;
+			glm::vec3 color;
+
+			stream >> position.x >> position.y >> position.z;
+			valid = !stream.fail();
+			if (!(stream >> color.r >> color.g >> color.b))
+				color = glm::vec3(1.0f);
+			positions.push_back(position);
+			colors.push_back(color);
+		}
+		else if (kind == "vt")
+		{
+			glm::vec2 uv(0.0f);
+
+			stream >> uv.x >> uv.y;
+			valid = !stream.fail();
+			uvs.push_back(uv);
+		}
+		else if (kind == "f")
+		{
+			std::string corner;
+
+			face_positions.clear();
+			face_uvs.clear();
+			face_colors.clear();
+			while (valid && stream >> corner)
+			{
+				char *end = nullptr;
+				long index = strtol(corner.c_str(), &end, 10);
+				long uv = 0;
+				if (*end == '/' && end[1] != '/')
+					uv = strtol(end + 1, nullptr, 10);
+
+				index = index < 0 ? positions.size() + index : index - 1;
+				uv = uv < 0 ? uvs.size() + uv : uv - 1;
+				valid = index >= 0 && index < static_cast<long>(positions.size());
+
+				if (valid)
+				{
+					face_positions.push_back(positions[index]);
+					face_colors.push_back(colors[index]);
+					face_uvs.push_back(uv >= 0 && uv < static_cast<long>(uvs.size()) ? uvs[uv] : glm::vec2(0.0f));
+				}
+			}
+			if (valid)
+				this->addPolygon(face_positions, face_uvs, face_colors, material);
+		}
+		else if (kind == "mtllib")
+		{
+			std::string name;
+
+			stream >> name;
+			this->parseMTL((directory / name).string(), names);
+		}
+		else if (kind == "usemtl")
+		{
+			std::string name;
+
+			stream >> name;
+			material = names.count(name) ? names[name] : -1;
+		}
+
+		if (!valid)
+			std::cerr << path << ":" << line_number << ": invalid mesh line" << std::endl;
+	}
+	return (true);
+}
+
+// newmtl, Kd and map_Kd, the texture when there is one is the color
+void		MeshModel::parseMTL(const std::string &path, std::map<std::string, int> &names)
+{
+	std::ifstream file(path);
+	std::string line;
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	int current = -1;
+
+	if (!file.is_open())
+	{
+		std::cerr << "Failed to open material file: " << path << std::endl;
+		return ;
+	}
+
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		std::string kind;
+		if (!(stream >> kind) || kind[0] == '#')
+			continue ;
+
+		if (kind == "newmtl")
+		{
+			std::string name;
+
+			stream >> name;
+			names[name] = current = _materials.size();
+			_materials.push_back({glm::vec3(1.0f), glm::ivec2(0), {}});
+		}
+		else if (current >= 0 && kind == "Kd")
+			stream >> _materials[current].color.r >> _materials[current].color.g >> _materials[current].color.b;
+		else if (current >= 0 && kind == "map_Kd")
+		{
+			// the options come first, the file is the last word
+			std::string word;
+			std::string name;
+			while (stream >> word)
+				name = word;
+
+			MeshMaterial &material = _materials[current];
+			std::string texture = (directory / name).string();
+			int channels;
+			stbi_uc *pixels = stbi_load(texture.c_str(), &material.texture_size.x, &material.texture_size.y, &channels, 4);
+			if (!pixels)
+			{
+				std::cerr << "Failed to load texture " << texture << ": " << stbi_failure_reason() << std::endl;
+				continue ;
+			}
+			material.texture.assign(pixels, pixels + static_cast<size_t>(material.texture_size.x) * material.texture_size.y * 4);
+			stbi_image_free(pixels);
+		}
+	}
+}
+
+template <typename T>
+static double	readBinary(std::ifstream &file)
+{
+	T value;
+
+	file.read(reinterpret_cast<char *>(&value), sizeof(T));
+	return (static_cast<double>(value));
+}
+
+// one value of a ply property type, ascii or little endian
+static double	readPLYValue(std::ifstream &file, const std::string &type, bool ascii)
+{
+	if (ascii)
+	{
+		double value = 0.0;
+		file >> value;
+		return (value);
+	}
+	if (type == "char" || type == "int8")
+		return (readBinary<int8_t>(file));
+	if (type == "uchar" || type == "uint8")
+		return (readBinary<uint8_t>(file));
+	if (type == "short" || type == "int16")
+		return (readBinary<int16_t>(file));
+	if (type == "ushort" || type == "uint16")
+		return (readBinary<uint16_t>(file));
+	if (type == "int" || type == "int32")
+		return (readBinary<int32_t>(file));
+	if (type == "uint" || type == "uint32")
+		return (readBinary<uint32_t>(file));
+	if (type == "float" || type == "float32")
+		return (readBinary<float>(file));
+	return (readBinary<double>(file));
+}
+
+// vertex x y z [red green blue] and face vertex_indices, any other element
+// or property is read past
+bool		MeshModel::parsePLY(const std::string &path)
+{
+	struct PLYProperty
+	{
+		std::string	name;
+		std::string	type;
+		std::string	count_type;
+	};
+
+	struct PLYElement
+	{
+		std::string					name;
+		size_t						count;
+		std::vector<PLYProperty>	properties;
+	};
+
+	std::ifstream file(path, std::ios::binary);
+	std::string line;
+	std::vector<PLYElement> elements;
+	std::string format;
+
+	if (!std::getline(file, line) || line.rfind("ply", 0) != 0)
+	{
+		std::cerr << "Failed to open mesh file: " << path << std::endl;
+		return (false);
+	}
+
+	while (std::getline(file, line) && line.rfind("end_header", 0) != 0)
+	{
+		std::istringstream stream(line);
+		std::string kind;
+		stream >> kind;
+
+		if (kind == "format")
+			stream >> format;
+		else if (kind == "element")
+		{
+			PLYElement element;
+			stream >> element.name >> element.count;
+			elements.push_back(element);
+		}
+		else if (kind == "property" && !elements.empty())
+		{
+			PLYProperty property;
+			stream >> property.type;
+			if (property.type == "list")
+				stream >> property.count_type >> property.type;
+			stream >> property.name;
+			elements.back().properties.push_back(property);
+		}
+	}
+
+	bool ascii = format == "ascii";
+	if (!ascii && format != "binary_little_endian")
+	{
+		std::cerr << path << ": unsupported ply format " << format << std::endl;
+		return (false);
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> colors;
+	std::vector<glm::vec3> face_positions;
+	std::vector<glm::vec2> face_uvs;
+	std::vector<glm::vec3> face_colors;
+	std::vector<double> values;
+	std::vector<long> indices;
+
+	for (const PLYElement &element : elements)
+	{
+		for (size_t item = 0; item < element.count && file; item++)
+		{
+			values.clear();
+			indices.clear();
+			for (const PLYProperty &property : element.properties)
+			{
+				if (property.count_type.empty())
+				{
+					double value = readPLYValue(file, property.type, ascii);
+					values.push_back(property.type == "uchar" || property.type == "uint8" ? value / 255.0 : value);
+					continue ;
+				}
+
+				int count = static_cast<int>(readPLYValue(file, property.count_type, ascii));
+				for (int i = 0; i < count; i++)
+				{
+					long index = static_cast<long>(readPLYValue(file, property.type, ascii));
+					if (property.name == "vertex_indices" || property.name == "vertex_index")
+						indices.push_back(index);
+				}
+				values.push_back(0.0);
+			}
+
+			if (element.name == "vertex")
+			{
+				glm::vec3 position(0.0f);
+				glm::vec3 color(1.0f);
+
+				for (size_t i = 0; i < element.properties.size(); i++)
+				{
+					const std::string &name = element.properties[i].name;
+					if (name == "x" || name == "y" || name == "z")
+						position[name[0] - 'x'] = values[i];
+					else if (name == "red" || name == "green" || name == "blue")
+						color[name == "red" ? 0 : (name == "green" ? 1 : 2)] = values[i];
+				}
+				positions.push_back(position);
+				colors.push_back(color);
+			}
+			else if (element.name == "face")
+			{
+				face_positions.clear();
+				face_colors.clear();
+				for (long index : indices)
+				{
+					if (index < 0 || index >= static_cast<long>(positions.size()))
+						break ;
+					face_positions.push_back(positions[index]);
+					face_colors.push_back(colors[index]);
+				}
+				face_uvs.assign(face_positions.size(), glm::vec2(0.0f));
+				if (face_positions.size() == indices.size())
+					this->addPolygon(face_positions, face_uvs, face_colors, -1);
+			}
+		}
+	}
+
+	if (!file)
+		std::cerr << path << ": ply file ends early" << std::endl;
+	return (true);
+}
+
+// the color at the point of the triangle with these barycentric weights
+glm::vec3	MeshModel::sample(const MeshTriangle &triangle, glm::vec3 weights) const
+{
+	glm::vec3 color = triangle.color[0] * weights.x + triangle.color[1] * weights.y + triangle.color[2] * weights.z;
+	if (triangle.material < 0)
+		return (color);
+
+	const MeshMaterial &material = _materials[triangle.material];
+	if (material.texture.empty())
+		return (color * material.color);
+
+	glm::vec2 uv = triangle.uv[0] * weights.x + triangle.uv[1] * weights.y + triangle.uv[2] * weights.z;
+	uv -= glm::floor(uv);
+	glm::ivec2 pixel = glm::clamp(glm::ivec2(uv.x * material.texture_size.x, (1.0f - uv.y) * material.texture_size.y), glm::ivec2(0), material.texture_size - 1);
+	const uint8_t *texel = &material.texture[(static_cast<size_t>(pixel.y) * material.texture_size.x + pixel.x) * 4];
+	return (color * glm::vec3(texel[0], texel[1], texel[2]) / 255.0f);
+}
+
+// separating axis test of the triangle against the box at center of half
+// size half: the box axes, the triangle normal and the 9 edge crosses
+static bool	triangleBox(glm::vec3 center, glm::vec3 half, const glm::vec3 corners[3])
+{
+	glm::vec3 a = corners[0] - center;
+	glm::vec3 b = corners[1] - center;
+	glm::vec3 c = corners[2] - center;
+
+	if (glm::any(glm::greaterThan(glm::min(a, glm::min(b, c)), half)) || glm::any(glm::lessThan(glm::max(a, glm::max(b, c)), -half)))
+		return (false);
+
+	glm::vec3 edges[3] = {b - a, c - b, a - c};
+	glm::vec3 normal = glm::cross(edges[0], edges[1]);
+	if (std::abs(glm::dot(normal, a)) > glm::dot(half, glm::abs(normal)))
+		return (false);
+
+	for (const glm::vec3 &edge : edges)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			glm::vec3 unit(0.0f);
+			unit[k] = 1.0f;
+
+			glm::vec3 axis = glm::cross(unit, edge);
+			float pa = glm::dot(a, axis);
+			float pb = glm::dot(b, axis);
+			float pc = glm::dot(c, axis);
+			float radius = glm::dot(half, glm::abs(axis));
+			if (std::min(pa, std::min(pb, pc)) > radius || std::max(pa, std::max(pb, pc)) < -radius)
+				return (false);
+		}
+	}
+	return (true);
+}
+
+// barycentric weights of the point of the triangle closest to p, by the
+// region of the triangle p projects in
+static glm::vec3	closestWeights(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+	glm::vec3 ab = b - a;
+	glm::vec3 ac = c - a;
+	glm::vec3 ap = p - a;
+	float d1 = glm::dot(ab, ap);
+	float d2 = glm::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return (glm::vec3(1.0f, 0.0f, 0.0f));
+
+	glm::vec3 bp = p - b;
+	float d3 = glm::dot(ab, bp);
+	float d4 = glm::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3)
+		return (glm::vec3(0.0f, 1.0f, 0.0f));
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		float v = d1 / std::max(d1 - d3, 1e-12f);
+		return (glm::vec3(1.0f - v, v, 0.0f));
+	}
+
+	glm::vec3 cp = p - c;
+	float d5 = glm::dot(ab, cp);
+	float d6 = glm::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6)
+		return (glm::vec3(0.0f, 0.0f, 1.0f));
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		float w = d2 / std::max(d2 - d6, 1e-12f);
+		return (glm::vec3(1.0f - w, 0.0f, w));
+	}
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+	{
+		float w = (d4 - d3) / std::max((d4 - d3) + (d5 - d6), 1e-12f);
+		return (glm::vec3(0.0f, 1.0f - w, w));
+	}
+
+	float denominator = 1.0f / std::max(va + vb + vc, 1e-12f);
+	float v = vb * denominator;
+	float w = vc * denominator;
+	return (glm::vec3(1.0f - v - w, v, w));
+}
+
+// the triangles are binned by the MESH_TILE tiles their bounds cover, the
+// tiles with triangles are voxelized in parallel, each cell a triangle
+// overlaps at all is kept (conservative), its color and normal from the
+// triangle closest to the cell center, ranges of tiles go into their own
+// trees that are merged at the end, so no grid of the whole mesh is made
+SVO			*MeshModel::voxelize(const glm::mat4 &transform, int world_dim, glm::vec3 tint) const
+{
+	RV_TRACE_SCOPE("Voxelize");
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<glm::vec3> corners(_triangles.size() * 3);
+	glm::vec3 low(std::numeric_limits<float>::max());
+	glm::vec3 high(-std::numeric_limits<float>::max());
+	for (size_t i = 0; i < corners.size(); i++)
+	{
+		corners[i] = glm::vec3(transform * glm::vec4(_triangles[i / 3].position[i % 3], 1.0f));
+		low = glm::min(low, corners[i]);
+		high = glm::max(high, corners[i]);
+	}
+
+	glm::ivec3 lo = glm::max(glm::ivec3(glm::floor(low)), glm::ivec3(0));
+	glm::ivec3 hi = glm::min(glm::ivec3(glm::floor(high)), glm::ivec3(world_dim - 1));
+	if (_triangles.empty() || glm::any(glm::lessThan(hi, lo)))
+		return (new SVO(glm::ivec3(0), glm::ivec3(world_dim)));
+
+	glm::ivec3 tiles = (hi - lo) / MESH_TILE + 1;
+	std::vector<std::vector<int>> bins(static_cast<size_t>(tiles.x) * tiles.y * tiles.z);
+	auto bounds = [&](size_t triangle, glm::ivec3 &first, glm::ivec3 &last)
+	{
+		const glm::vec3 *c = &corners[triangle * 3];
+		first = glm::max(glm::ivec3(glm::floor(glm::min(c[0], glm::min(c[1], c[2])))), lo);
+		last = glm::min(glm::ivec3(glm::floor(glm::max(c[0], glm::max(c[1], c[2])))), hi);
+	};
+
+	{
+		RV_TRACE_SCOPE("Bin");
+
+		for (size_t t = 0; t < _triangles.size(); t++)
+		{
+			glm::ivec3 first;
+			glm::ivec3 last;
+			bounds(t, first, last);
+			if (glm::any(glm::lessThan(last, first)))
+				continue ;
+
+			glm::ivec3 tile_first = (first - lo) / MESH_TILE;
+			glm::ivec3 tile_last = (last - lo) / MESH_TILE;
+			for (int z = tile_first.z; z <= tile_last.z; z++)
+				for (int y = tile_first.y; y <= tile_last.y; y++)
+					for (int x = tile_first.x; x <= tile_last.x; x++)
+						bins[x + tiles.x * (y + static_cast<size_t>(tiles.y) * z)].push_back(t);
+		}
+	}
+
+	std::vector<int> busy;
+	for (size_t i = 0; i < bins.size(); i++)
+		if (!bins[i].empty())
+			busy.push_back(i);
+
+	std::vector<SVO *> trees;
+	std::mutex mutex;
+	std::atomic<size_t> count(0);
+
+	ThreadPool::shared().parallelFor(busy.size(), [&](int begin, int end)
+	{
+		const int cells = MESH_TILE * MESH_TILE * MESH_TILE;
+		std::vector<float> nearest(cells);
+		std::vector<uint32_t> colors(cells);
+		std::vector<glm::vec3> normals(cells);
+		SVO *tree = new SVO(glm::ivec3(0), glm::ivec3(world_dim));
+		size_t inserted = 0;
+
+		for (int k = begin; k < end; k++)
+		{
+			int index = busy[k];
+			glm::ivec3 origin = lo + glm::ivec3(index % tiles.x, (index / tiles.x) % tiles.y, index / (tiles.x * tiles.y)) * MESH_TILE;
+			glm::ivec3 tile_last = glm::min(origin + MESH_TILE - 1, hi);
+
+			std::fill(nearest.begin(), nearest.end(), std::numeric_limits<float>::max());
+			for (int t : bins[index])
+			{
+				const glm::vec3 *c = &corners[t * 3];
+				glm::vec3 normal = glm::cross(c[1] - c[0], c[2] - c[0]);
+				glm::ivec3 first;
+				glm::ivec3 last;
+				bounds(t, first, last);
+				first = glm::max(first, origin);
+				last = glm::min(last, tile_last);
+
+				for (int z = first.z; z <= last.z; z++)
+				{
+					for (int y = first.y; y <= last.y; y++)
+					{
+						for (int x = first.x; x <= last.x; x++)
+						{
+							glm::vec3 center = glm::vec3(x, y, z) + 0.5f;
+							if (!triangleBox(center, glm::vec3(0.5f), c))
+								continue ;
+
+							glm::vec3 weights = closestWeights(center, c[0], c[1], c[2]);
+							glm::vec3 point = c[0] * weights.x + c[1] * weights.y + c[2] * weights.z;
+							float distance = glm::dot(point - center, point - center);
+							int cell = (x - origin.x) + MESH_TILE * ((y - origin.y) + MESH_TILE * (z - origin.z));
+							if (distance >= nearest[cell])
+								continue ;
+
+							glm::ivec3 rgb = glm::clamp(glm::ivec3(this->sample(_triangles[t], weights) * tint * 255.0f + 0.5f), 0, 255);
+							nearest[cell] = distance;
+							colors[cell] = (rgb.r << 24) | (rgb.g << 16) | (rgb.b << 8) | 0xFF;
+							normals[cell] = normal;
+						}
+					}
+				}
+			}
+
+			for (int cell = 0; cell < cells; cell++)
+			{
+				if (nearest[cell] == std::numeric_limits<float>::max())
+					continue ;
+
+				GPUVoxel voxel;
+				voxel.position = origin + glm::ivec3(cell % MESH_TILE, (cell / MESH_TILE) % MESH_TILE, cell / (MESH_TILE * MESH_TILE));
+				voxel.color = colors[cell];
+				voxel.normal = glm::length(normals[cell]) > 1e-12f ? glm::normalize(normals[cell]) : glm::vec3(0.0f, 1.0f, 0.0f);
+				voxel.light = 0;
+				tree->insert(voxel, 16);
+				inserted++;
+			}
+		}
+
+		count += inserted;
+		std::lock_guard<std::mutex> lock(mutex);
+		trees.push_back(tree);
+	});
+
+	SVO *root = trees.empty() ? new SVO(glm::ivec3(0), glm::ivec3(world_dim)) : SVO::mergeAll(trees);
+
+	std::cout << "Voxelized " << _triangles.size() << " triangles in " << busy.size() << " tiles, " << count << " voxels in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count()
+		<< "ms on " << ThreadPool::shared().getThreadCount() << " threads" << std::endl;
+	return (root);
+}
@@ -0,0 +1,130 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   PagedBuffer.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:47:51 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 18:47:51 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "PagedBuffer.hpp"
+
+// max_page_bytes of 0 takes the driver limit, a smaller value forces paging
+PagedBuffer::PagedBuffer(GLuint first_binding, size_t element_size, size_t count, const void *data, size_t max_page_bytes)
+	: _first_binding(first_binding), _element_size(element_size), _count(count)
+{
+	RV_TRACE_SCOPE("Upload pages");
+
+	_shift = PagedBuffer::pageShift(_element_size, max_page_bytes);
+
+	size_t page_elements = static_cast<size_t>(1) << _shift;
+	size_t page_count = std::max<size_t>((_count + page_elements - 1) / page_elements, 1);
+
+	// a cut array would leave nodes pointing past its end, nothing is
+	// uploaded and the owner has to give up on the scene
+	_complete = page_count <= PAGE_COUNT;
+	if (!_complete)
+	{
+		std::cerr << "Paged buffer: " << _count << " elements need " << page_count << " pages of "
+			<< page_elements << ", only " << PAGE_COUNT << " are bound" << std::endl;
+		page_count = 1;
+		_count = 0;
+	}
+
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	for (size_t i = 0; i < page_count; i++)
+	{
+		size_t first = i * page_elements;
+		size_t elements = std::min(page_elements, _count - std::min(first, _count));
+
+		// an empty array still gets one element so the binding is valid
+		std::vector<uint8_t> empty;
+		const void *page_data = bytes ? bytes + first * _element_size : nullptr;
+		if (elements == 0)
+		{
+			empty.resize(_element_size, 0);
+			page_data = empty.data();
+			elements = 1;
+		}
+
+		_pages.push_back(new Buffer(Buffer::Type::SSBO, _first_binding + i, elements * _element_size, page_data));
+
+		if (glGetError() == GL_OUT_OF_MEMORY)
+			std::cerr << "Paged buffer: out of video memory on page " << i << std::endl;
+	}
+
+	for (size_t i = page_count; i < PAGE_COUNT; i++)
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, _first_binding + i, _pages[0]->getID());
+
+	std::cout << "Paged buffer: " << _count << " elements in " << page_count << " page(s) of " << page_elements << std::endl;
+}
+
+// log2 of the elements in a page, the largest power of two that fits
+int			PagedBuffer::pageShift(size_t element_size, size_t max_page_bytes)
+{
+	GLint64 max_block_size = 0;
+	glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_block_size);
+	if (max_page_bytes == 0 || max_page_bytes > static_cast<size_t>(max_block_size))
+		max_page_bytes = max_block_size;
+
+	int shift = 0;
+	while ((static_cast<size_t>(2) << shift) * element_size <= max_page_bytes && shift < 30)
+		shift++;
+	return (shift);
+}
+
+// the most elements the bound pages can hold with the driver limit
+size_t		PagedBuffer::capacity(size_t element_size)
+{
+	return ((static_cast<size_t>(1) << PagedBuffer::pageShift(element_size, 0)) * PAGE_COUNT);
+}
+
+PagedBuffer::~PagedBuffer()
+{
+	for (Buffer *page : _pages)
+		delete (page);
+}
+
+// splits the range at page boundaries, each piece goes through Buffer::updateRange
+void		PagedBuffer::updateRange(const void *data, size_t first, size_t count)
+{
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	size_t page_elements = static_cast<size_t>(1) << _shift;
+
+	count = std::min(count, _count - std::min(first, _count));
+	while (count > 0)
+	{
+		size_t page = first >> _shift;
+		size_t local = first & (page_elements - 1);
+		size_t elements = std::min(count, page_elements - local);
+
+		_pages[page]->updateRange(bytes, local * _element_size, elements * _element_size);
+
+		bytes += elements * _element_size;
+		first += elements;
+		count -= elements;
+	}
+}
+
+int			PagedBuffer::getPageShift() const
+{
+	return (_shift);
+}
+
+int			PagedBuffer::getPageCount() const
+{
+	return (_pages.size());
+}
+
+size_t		PagedBuffer::getCount() const
+{
+	return (_count);
+}
+
+bool		PagedBuffer::isComplete() const
+{
+	return (_complete);
+}
@@ -0,0 +1,208 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Profiler.cpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 11:24:50 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 11:24:50 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Profiler.hpp"
+
+Profiler::Profiler()
+{
+	_frame = 0;
+}
+
+Profiler::~Profiler()
+{
+	for (ProfileSection *section : _sections)
+	{
+		delete (section->gpu);
+		delete (section);
+	}
+}
+
+ProfileSection	*Profiler::getSection(const std::string &name, bool gpu)
+{
+	auto it = _by_name.find(name);
+	if (it != _by_name.end())
+		return (it->second);
+
+	ProfileSection *section = new ProfileSection();
+
+	section->name = name;
+	section->trace_name = TraceRecorder::intern(name);
+	section->gpu = gpu ? new GPUTimer() : nullptr;
+	section->gpu_count = 0;
+	section->cpu_count = 0;
+	section->used_frame = -1;
+
+	_sections.push_back(section);
+	_by_name[name] = section;
+
+	return (section);
+}
+
+// picks up the gpu results that came back since the last frame
+void			Profiler::newFrame()
+{
+	for (ProfileSection *section : _sections)
+	{
+		float ms;
+
+		if (section->gpu && section->gpu->poll(ms))
+			section->gpu_history[section->gpu_count++ % PROFILER_HISTORY] = ms;
+	}
+	_frame++;
+}
+
+void			Profiler::begin(const std::string &name, bool gpu)
+{
+	ProfileSection *section = getSection(name, gpu);
+
+	if (section->gpu)
+		section->gpu->begin();
+	section->used_frame = _frame;
+	section->cpu_start = std::chrono::steady_clock::now();
+}
+
+void			Profiler::end(const std::string &name)
+{
+	ProfileSection *section = getSection(name, false);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::chrono::duration<float, std::milli> elapsed = now - section->cpu_start;
+	section->cpu_history[section->cpu_count++ % PROFILER_HISTORY] = elapsed.count();
+
+	if (section->gpu)
+		section->gpu->end();
+
+	TraceRecorder::record(section->trace_name, section->cpu_start, now);
+}
+
+ProfileStats	Profiler::computeStats(const float *history, int count) const
+{
+	ProfileStats stats = {0.0f, 0.0f, 0.0f, 0.0f};
+
+	int size = std::min(count, PROFILER_HISTORY);
+	if (size == 0)
+		return (stats);
+
+	std::vector<float> samples(history, history + size);
+
+	stats.last = history[(count - 1) % PROFILER_HISTORY];
+	stats.min = *std::min_element(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (float sample : samples)
+		sum += sample;
+	stats.avg = static_cast<float>(sum / size);
+
+	size_t p99 = std::min(samples.size() - 1, static_cast<size_t>(samples.size() * 0.99f));
+	std::nth_element(samples.begin(), samples.begin() + p99, samples.end());
+	stats.p99 = samples[p99];
+
+	return (stats);
+}
+
+ProfileStats	Profiler::getGPUStats(const std::string &name) const
+{
+	auto it = _by_name.find(name);
+	if (it == _by_name.end())
+		return (ProfileStats{0.0f, 0.0f, 0.0f, 0.0f});
+	return (computeStats(it->second->gpu_history, it->second->gpu_count));
+}
+
+ProfileStats	Profiler::getCPUStats(const std::string &name) const
+{
+	auto it = _by_name.find(name);
+	if (it == _by_name.end())
+		return (ProfileStats{0.0f, 0.0f, 0.0f, 0.0f});
+	return (computeStats(it->second->cpu_history, it->second->cpu_count));
+}
+
+// 0 for a pass that did not run lately, its last sample would be stale
+float			Profiler::getLatestGPUTime(const std::string &name) const
+{
+	auto it = _by_name.find(name);
+	if (it == _by_name.end() || it->second->gpu_count == 0 || it->second->used_frame < _frame - 2)
+		return (0.0f);
+	return (it->second->gpu_history[(it->second->gpu_count - 1) % PROFILER_HISTORY]);
+}
+
+void			Profiler::imGuiRender()
+{
+	if (!ImGui::CollapsingHeader("Profiler"))
+		return ;
+
+	if (ImGui::BeginTable("Passes", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit))
+	{
+		ImGui::TableSetupColumn("Pass");
+		ImGui::TableSetupColumn("GPU min");
+		ImGui::TableSetupColumn("GPU avg");
+		ImGui::TableSetupColumn("GPU p99");
+		ImGui::TableSetupColumn("CPU min");
+		ImGui::TableSetupColumn("CPU avg");
+		ImGui::TableSetupColumn("CPU p99");
+		ImGui::TableHeadersRow();
+
+		for (ProfileSection *section : _sections)
+		{
+			ProfileStats gpu = computeStats(section->gpu_history, section->gpu_count);
+			ProfileStats cpu = computeStats(section->cpu_history, section->cpu_count);
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(section->name.c_str());
+			if (section->gpu)
+			{
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", gpu.min);
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", gpu.avg);
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", gpu.p99);
+			}
+			else
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					ImGui::TableNextColumn();
+					ImGui::TextDisabled("-");
+				}
+			}
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", cpu.min);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", cpu.avg);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", cpu.p99);
+		}
+		ImGui::EndTable();
+	}
+
+	for (ProfileSection *section : _sections)
+	{
+		bool		gpu = section->gpu != nullptr;
+		const float	*history = gpu ? section->gpu_history : section->cpu_history;
+		int			count = gpu ? section->gpu_count : section->cpu_count;
+		int			size = std::min(count, PROFILER_HISTORY);
+
+		std::string label = section->name + (gpu ? " (GPU ms)" : " (CPU ms)");
+		ProfileStats stats = computeStats(history, count);
+
+		ImGui::PlotHistogram(label.c_str(), history, size, size < PROFILER_HISTORY ? 0 : count % PROFILER_HISTORY,
+			nullptr, 0.0f, std::max(stats.p99 * 1.5f, 0.1f), ImVec2(0, 40));
+	}
+}
+
+// csv, one line per section over the frames still in the history
+void			Profiler::writeStats(std::ostream &out) const
+{
+	out << "pass,gpu_min,gpu_avg,gpu_p99,cpu_min,cpu_avg,cpu_p99" << std::endl;
+	for (ProfileSection *section : _sections)
+	{
+		ProfileStats gpu = computeStats(section->gpu_history, section->gpu_count);
+		ProfileStats cpu = computeStats(section->cpu_history, section->cpu_count);
+
+		out << section->name << "," << gpu.min << "," << gpu.avg << "," << gpu.p99
+			<< "," << cpu.min << "," << cpu.avg << "," << cpu.p99 << std::endl;
+	}
+}
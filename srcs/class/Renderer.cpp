@@ -0,0 +1,323 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Renderer.cpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 15:18:02 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 15:18:02 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Renderer.hpp"
+
+void					setupScreenTriangle(GLuint *VAO);
+void					drawScreenTriangle(GLuint VAO, GLuint output_texture, GLuint program);
+
+std::vector<GLuint>		generateTextures(unsigned int textures_count);
+
+std::vector<Buffer *>	createDataOnGPU(Scene &scene, std::vector<PagedBuffer *> &paged_buffers);
+bool					createSceneBuffers(Scene &scene, std::vector<PagedBuffer *> &paged_buffers);
+void					uploadWholeScene(Scene &scene, std::vector<PagedBuffer *> &paged_buffers);
+void					updateDataOnGPU(Scene &scene, const std::vector<Buffer *> &buffers);
+void					printAovStats(std::vector<GLuint> &textures, AovView view, int raw_texture, glm::vec2 resolution);
+
+// stream_slots above 0 moves the svo out of core with a pool of that many
+// slots, the scene arrays are replaced by the top tree before the upload,
+// chunk_radius above 0 carries the world on in chunks around the camera,
+// with a loader (owned from here on) the scene fills in over the frames and
+// everything that needs the whole scene waits for it
+Renderer::Renderer(Scene &scene, glm::ivec2 display, int stream_slots, int chunk_radius, SceneLoader *loader) : _scene(scene)
+{
+	setupScreenTriangle(&_vao);
+
+	_textures = generateTextures(TEXTURE_COUNT);
+
+	_compute_shader = new Shader(GL_COMPUTE_SHADER, "shaders/compute.glsl");
+	_raytracing_program = new ShaderProgram();
+	_raytracing_program->attachShader(_compute_shader);
+
+	// the traversal stack grows by 3 a level, one level per halving of the world
+	int depth = 0;
+	while ((1 << depth) < scene.getWorldDim())
+		depth++;
+	_raytracing_program->setDefine("SVO_STACK", std::to_string(3 * depth + 2));
+	_raytracing_program->reloadShaders();
+
+	_vertex_shader = new Shader(GL_VERTEX_SHADER, "shaders/vertex.vert");
+	_fragment_shader = new Shader(GL_FRAGMENT_SHADER, "shaders/frag.frag");
+	_render_program = new ShaderProgram();
+	_render_program->attachShader(_vertex_shader);
+	_render_program->attachShader(_fragment_shader);
+	_render_program->link();
+
+	_reprojection = new Reprojection();
+	_denoiser = new Denoiser();
+	_resolution = new DynamicResolution(display);
+	_profiler = new Profiler();
+	_capture = new FrameCapture(display);
+	_streamer = nullptr;
+	_editor = nullptr;
+	_tlas = nullptr;
+	_chunks = nullptr;
+	_loader = loader;
+	_stream_slots = stream_slots;
+	_chunk_radius = chunk_radius;
+	_denoise_error = -1.0f;
+
+	if (!_loader)
+		this->attachScene();
+
+	_buffers = createDataOnGPU(scene, _paged_buffers);
+}
+
+// the streamer, the chunks, the editor and the top level, all of them
+// need the whole scene in the flat arrays
+void					Renderer::attachScene()
+{
+	GLint max_blocks = 0;
+	glGetIntegerv(GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, &max_blocks);
+	if (_stream_slots > 0 && max_blocks <= STREAM_TABLE_BINDING)
+		std::cerr << "Streaming: needs " << STREAM_TABLE_BINDING + 1 << " storage blocks, the driver has " << max_blocks << std::endl;
+	else if (_stream_slots > 0)
+	{
+		_streamer = new SVOStreamer(_scene, _stream_slots, (std::filesystem::temp_directory_path() / "redvox_stream.cache").string());
+		_raytracing_program->setDefine("STREAMING", "1");
+		_raytracing_program->reloadShaders();
+	}
+
+	// instances are only traced when there are some, it costs two more blocks
+	int needed_blocks = INSTANCE_BINDING + 1 - (_streamer ? 0 : 1);
+
+	// chunk slots are instances, they go before the editor so its headroom
+	// comes after them
+	if (_chunk_radius > 0 && max_blocks < needed_blocks)
+		std::cerr << "Chunks: need " << needed_blocks << " storage blocks, the driver has " << max_blocks << std::endl;
+	else if (_chunk_radius > 0)
+		_chunks = new ChunkWorld(_scene, _chunk_radius, _scene.getChunkSource() ? _scene.getChunkSource() : ChunkWorld::groundSource(_scene.getWorldDim()));
+
+	// bricks on disk can not be edited, the editor only runs on a resident tree
+	if (!_streamer)
+		_editor = new VoxelEditor(_scene);
+
+	if (!_scene.getInstances().empty() && max_blocks < needed_blocks)
+		std::cerr << "Instancing: needs " << needed_blocks << " storage blocks, the driver has " << max_blocks << std::endl;
+	else if (!_scene.getInstances().empty())
+	{
+		_tlas = new TLAS();
+		_raytracing_program->setDefine("INSTANCING", "1");
+		_raytracing_program->reloadShaders();
+	}
+}
+
+Renderer::~Renderer()
+{
+	for (Buffer *buffer : _buffers)
+		delete (buffer);
+	for (PagedBuffer *buffer : _paged_buffers)
+		delete (buffer);
+	delete (_streamer);
+	delete (_editor);
+	delete (_tlas);
+	delete (_chunks);
+	delete (_loader);
+	Buffer::releaseStaging();
+
+	delete (_capture);
+	delete (_profiler);
+	delete (_resolution);
+	delete (_denoiser);
+	delete (_reprojection);
+
+	delete (_render_program);
+	delete (_raytracing_program);
+	delete (_fragment_shader);
+	delete (_vertex_shader);
+	delete (_compute_shader);
+
+	glDeleteTextures(_textures.size(), _textures.data());
+	glDeleteVertexArrays(1, &_vao);
+}
+
+void					Renderer::beginFrame()
+{
+	_profiler->newFrame();
+	_profiler->begin("Frame", false);
+
+	Buffer::nextFrame();
+
+	_resolution->update(_profiler->getLatestGPUTime("Trace") + _profiler->getLatestGPUTime("Reprojection") + _profiler->getLatestGPUTime("Denoise"));
+}
+
+void					Renderer::render(const FrameSettings &settings)
+{
+	glm::vec2 render_size = _resolution->getResolution();
+	
+	{
+		ProfileScope scope(*_profiler, "Uploads");
+		updateDataOnGPU(_scene, _buffers);
+		if (_loader && !_loader->update(*_paged_buffers[0], *_paged_buffers[1]) && !createSceneBuffers(_scene, _paged_buffers))
+			_loader->stop();
+		if (_loader && _loader->isDone())
+		{
+			delete (_loader);
+			_loader = nullptr;
+			// the finished scene goes up whole for the first time
+			this->attachScene();
+			uploadWholeScene(_scene, _paged_buffers);
+		}
+		if (_streamer)
+			_streamer->update(*_paged_buffers[0], *_paged_buffers[1]);
+		// the editor never grows the arrays past the pages, see VoxelEditor::reserve
+		if (_editor && !_editor->upload(*_paged_buffers[0], *_paged_buffers[1]))
+			createSceneBuffers(_scene, _paged_buffers);
+		if (_chunks)
+			_chunks->update(*_paged_buffers[0], *_paged_buffers[1]);
+		if (_tlas)
+		{
+			_tlas->update(_scene);
+			_tlas->animate(_scene, settings.time);
+		}
+	}
+	
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	bool debug = _scene.getDebug().enabled;
+	bool temporal = !debug && (settings.accumulate || _scene.getDenoise().enabled);
+
+	int aov_mask = settings.aov_mask | aov_views[settings.view].mask;
+	if (temporal)
+		aov_mask |= AOV_NORMAL_DEPTH | AOV_ALBEDO;
+	
+	{
+		ProfileScope scope(*_profiler, "Trace");
+
+		_raytracing_program->use();
+		_raytracing_program->bindImageTexture(_textures[TRAVERSAL_TEXTURE], 4, GL_WRITE_ONLY, GL_RGBA32F);
+		_raytracing_program->set_int("u_aovMask", aov_mask);
+		_raytracing_program->set_int("u_frameCount", settings.frame_count);
+		_raytracing_program->set_int("u_voxelDim", _scene.getWorldDim());
+		_raytracing_program->set_float("u_voxelSize", _scene.getVoxelSize());
+		_raytracing_program->set_float("u_time", settings.time);
+		_raytracing_program->set_vec2("u_resolution", render_size);
+		_raytracing_program->set_float("u_lodBias", settings.lod_bias);
+		_raytracing_program->set_int("u_nodePageShift", _paged_buffers[0]->getPageShift());
+		_raytracing_program->set_int("u_voxelPageShift", _paged_buffers[1]->getPageShift());
+		if (_streamer)
+			_streamer->setUniforms(*_raytracing_program);
+		if (_tlas)
+			_tlas->setUniforms(*_raytracing_program);
+		
+		_raytracing_program->dispathCompute((static_cast<GLuint>(render_size.x) + 15) / 16, (static_cast<GLuint>(render_size.y) + 15) / 16, 1);
+	}
+
+	if (temporal)
+	{
+		ProfileScope scope(*_profiler, "Reprojection");
+
+		_reprojection->process(_textures, render_size, _resolution->getPreviousResolution(), settings.frame_count, settings.max_history, _scene.getVoxelSize());
+	}
+
+	if (_scene.getDenoise().enabled && !debug)
+	{
+		ProfileScope scope(*_profiler, "Denoise");
+
+		if (settings.validate_denoise)
+			_denoise_error = _denoiser->validate(_textures, _scene.getDenoise(), render_size);
+		else
+			_denoiser->process(_textures, _scene.getDenoise(), render_size);
+	}
+
+	_resolution->endFrame();
+}
+
+// display shader into whatever framebuffer is bound
+void					Renderer::present(const FrameSettings &settings)
+{
+	glm::vec2 render_size = _resolution->getResolution();
+
+	AovView view = _scene.getDebug().enabled ? VIEW_RAW : settings.view;
+	GLuint view_texture = _textures[view == VIEW_RAW ? settings.output_texture : aov_views[view].texture];
+
+	if (settings.readback_aov)
+		printAovStats(_textures, view, settings.output_texture, render_size);
+
+	{
+		ProfileScope scope(*_profiler, "Blit");
+
+		_render_program->use();
+		_render_program->set_int("u_view", view);
+		_render_program->set_float("u_nodeTreshold", _scene.getDebug().box_treshold);
+		_render_program->set_float("u_voxelTreshold", _scene.getDebug().triangle_treshold);
+		_render_program->set_vec2("u_renderResolution", render_size);
+		drawScreenTriangle(_vao, view_texture, _render_program->getProgram());
+	}
+
+	ProfileScope scope(*_profiler, "Capture", false);
+	_capture->capture(_textures[OUTPUT_TEXTURE], render_size);
+}
+
+void					Renderer::endFrame()
+{
+	_scene.getCamera()->storeGPUData();
+
+	_profiler->end("Frame");
+}
+
+ShaderProgram			&Renderer::getRaytracingProgram()
+{
+	return (*_raytracing_program);
+}
+
+DynamicResolution		&Renderer::getResolution()
+{
+	return (*_resolution);
+}
+
+Profiler				&Renderer::getProfiler()
+{
+	return (*_profiler);
+}
+
+FrameCapture			&Renderer::getCapture()
+{
+	return (*_capture);
+}
+
+SVOStreamer				*Renderer::getStreamer()
+{
+	return (_streamer);
+}
+
+VoxelEditor				*Renderer::getEditor()
+{
+	return (_editor);
+}
+
+ChunkWorld				*Renderer::getChunks()
+{
+	return (_chunks);
+}
+
+SceneLoader				*Renderer::getLoader()
+{
+	return (_loader);
+}
+
+TLAS					*Renderer::getTLAS()
+{
+	return (_tlas);
+}
+
+// max error of the last validated denoise against the cpu reference, -1
+// while no frame was validated
+float					Renderer::getDenoiseError() const
+{
+	return (_denoise_error);
+}
+
+std::vector<GLuint>		&Renderer::getTextures()
+{
+	return (_textures);
+}
@@ -0,0 +1,68 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Reprojection.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 16:14:02 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 16:14:02 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Reprojection.hpp"
+
+Reprojection::Reprojection()
+{
+	_temporal_shader = new Shader(GL_COMPUTE_SHADER, "shaders/temporal.glsl");
+
+	_temporal_program = new ShaderProgram();
+	_temporal_program->attachShader(_temporal_shader);
+	_temporal_program->link();
+}
+
+Reprojection::~Reprojection()
+{
+	delete (_temporal_program);
+	delete (_temporal_shader);
+}
+
+// blends the traced frame with the previous accumulation, found back through the previous camera
+void	Reprojection::process(std::vector<GLuint> &textures, glm::vec2 resolution, glm::vec2 previous_resolution, int frame_count, int max_history, float voxel_size)
+{
+	GLuint	groups_x = (static_cast<GLuint>(resolution.x) + 15) / 16;
+	GLuint	groups_y = (static_cast<GLuint>(resolution.y) + 15) / 16;
+
+	_temporal_program->use();
+	_temporal_program->bindImageTexture(textures[HISTORY_COLOR_TEXTURE], 4, GL_READ_ONLY, GL_RGBA32F);
+	_temporal_program->bindImageTexture(textures[HISTORY_NORMAL_DEPTH_TEXTURE], 5, GL_READ_ONLY, GL_RGBA32F);
+	_temporal_program->bindImageTexture(textures[HISTORY_MOMENTS_TEXTURE], 6, GL_READ_ONLY, GL_RGBA32F);
+	_temporal_program->bindImageTexture(textures[MOTION_TEXTURE], 7, GL_WRITE_ONLY, GL_RGBA32F);
+	_temporal_program->set_vec2("u_resolution", resolution);
+	_temporal_program->set_vec2("u_prevResolution", previous_resolution);
+	_temporal_program->set_int("u_frameCount", frame_count);
+	_temporal_program->set_int("u_maxHistory", max_history);
+	_temporal_program->set_float("u_voxelSize", voxel_size);
+	_temporal_program->dispathCompute(groups_x, groups_y, 1);
+
+	this->storeHistory(textures, resolution);
+}
+
+// keeps the undenoised accumulation and the features it was made with for the next frame
+void	Reprojection::storeHistory(std::vector<GLuint> &textures, glm::vec2 resolution)
+{
+	static const std::pair<TextureIndex, TextureIndex> copies[] = {
+		{OUTPUT_TEXTURE, HISTORY_COLOR_TEXTURE},
+		{NORMAL_DEPTH_TEXTURE, HISTORY_NORMAL_DEPTH_TEXTURE},
+		{MOMENTS_TEXTURE, HISTORY_MOMENTS_TEXTURE}
+	};
+
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	for (const auto &[src, dst] : copies)
+	{
+		glCopyImageSubData(textures[src], GL_TEXTURE_2D, 0, 0, 0, 0,
+			textures[dst], GL_TEXTURE_2D, 0, 0, 0, 0,
+			static_cast<GLsizei>(resolution.x), static_cast<GLsizei>(resolution.y), 1);
+	}
+}
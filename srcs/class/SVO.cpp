@@ -12,6 +12,8 @@
 
 #include "SVO.hpp"
 
+#include "glm/gtc/packing.hpp"
+
 SVO::SVO(glm::ivec3 min, glm::ivec3 max)
 {
 	_min = min;
@@ -63,6 +65,97 @@ bool SVO::insert(GPUVoxel &voxel, int depth)
 	return (false);
 }
 
+// Moves the voxels of other, a tree built over the same box, into this one.
+// Where both have a voxel at the same position the one of other wins, other
+// is left with what was not moved and can be deleted.
+void SVO::merge(SVO *other, int depth)
+{
+	if (other->_empty)
+		return ;
+
+	if (_empty)
+		this->swapContent(other);
+	else if (other->_leaf)
+	{
+		for (GPUVoxel &voxel : other->_voxels)
+			this->place(voxel, depth, true);
+	}
+	else if (_leaf)
+	{
+		this->swapContent(other);
+		for (GPUVoxel &voxel : other->_voxels)
+			this->place(voxel, depth, false);
+	}
+	else
+	{
+		for (int i = 0; i < 8; i++)
+			_children[i]->merge(other->_children[i], depth - 1);
+	}
+}
+
+// trees over the same box merged pairwise on the shared ThreadPool, the
+// right tree goes into the left so later trees win where they overlap,
+// the others are deleted and null entries are skipped, safe to call from
+// a pool job as the caller merges pairs too
+SVO *SVO::mergeAll(std::vector<SVO *> &trees)
+{
+	RV_TRACE_SCOPE("Merge");
+
+	for (size_t step = 1; step < trees.size(); step *= 2)
+	{
+		int pairs = (trees.size() - step + step * 2 - 1) / (step * 2);
+
+		ThreadPool::shared().parallelFor(pairs, [&trees, step](int begin, int end)
+		{
+			for (size_t i = begin * step * 2; i < end * step * 2; i += step * 2)
+			{
+				if (!trees[i])
+					std::swap(trees[i], trees[i + step]);
+				else if (trees[i + step])
+					trees[i]->merge(trees[i + step], 16);
+				delete (trees[i + step]);
+				trees[i + step] = nullptr;
+			}
+		});
+	}
+	return (trees.empty() ? nullptr : trees[0]);
+}
+
+// insert that looks for a voxel at the same position first, replace says
+// which of the two is kept
+bool SVO::place(GPUVoxel &voxel, int depth, bool replace)
+{
+	if (!this->contains(voxel))
+		return (false);
+
+	if (!_leaf)
+	{
+		for (int i = 0; i < 8; i++)
+			if (_children[i]->place(voxel, depth - 1, replace))
+				return (true);
+		return (false);
+	}
+
+	for (GPUVoxel &existing : _voxels)
+	{
+		if (existing.position == voxel.position)
+		{
+			if (replace)
+				existing = voxel;
+			return (true);
+		}
+	}
+	return (this->insert(voxel, depth));
+}
+
+void SVO::swapContent(SVO *other)
+{
+	std::swap(_children, other->_children);
+	std::swap(_voxels, other->_voxels);
+	std::swap(_leaf, other->_leaf);
+	std::swap(_empty, other->_empty);
+}
+
 void SVO::subdivide()
 {
 	glm::ivec3 mid = (_min + _max) / 2;
@@ -99,6 +192,62 @@ bool SVO::contains(GPUVoxel &voxel)
 		voxel.position.z >= _min.z && voxel.position.z < _max.z);
 }
 
+static int	packColor(glm::vec3 color, float coverage)
+{
+	glm::uvec4 bytes(glm::clamp(glm::vec4(color, coverage), 0.0f, 1.0f) * 255.0f + 0.5f);
+
+	return (static_cast<int>((bytes.r << 24) | (bytes.g << 16) | (bytes.b << 8) | bytes.a));
+}
+
+// Color and normal of one node from its voxels or its children, which must
+// be up to date. Coverage is how much of one face of the node its voxels
+// would hide: a leaf is its voxel count over the face area, a parent a
+// quarter of its children.
+void SVO::aggregate(std::vector<FlatSVONode> &flatNodes, const std::vector<GPUVoxel> &flatVoxels, int index)
+{
+	FlatSVONode &node = flatNodes[index];
+	glm::vec3 color(0.0f);
+	glm::vec3 normal(0.0f);
+	float weight = 0.0f;
+	float coverage = 0.0f;
+
+	if (node.childOffset < 0)
+	{
+		for (int v = 0; v < node.voxelCount; v++)
+		{
+			const GPUVoxel &voxel = flatVoxels[node.voxelIndex + v];
+			uint32_t packed = static_cast<uint32_t>(voxel.color);
+
+			color += glm::vec3((packed >> 24) & 0xFF, (packed >> 16) & 0xFF, (packed >> 8) & 0xFF) / 255.0f;
+			if (glm::length(voxel.normal) > 1e-6f)
+				normal += voxel.normal;
+			weight += 1.0f;
+		}
+		float side = static_cast<float>(node.max.x - node.min.x);
+		coverage = std::min(weight / std::max(side * side, 1.0f), 1.0f);
+	}
+	else
+	{
+		for (int c = 0; c < 8; c++)
+		{
+			const FlatSVONode &child = flatNodes[node.childOffset + c];
+			uint32_t packed = static_cast<uint32_t>(child.color);
+			float child_coverage = (packed & 0xFF) / 255.0f;
+
+			color += glm::vec3((packed >> 24) & 0xFF, (packed >> 16) & 0xFF, (packed >> 8) & 0xFF) / 255.0f * child_coverage;
+			normal += glm::vec3(glm::unpackSnorm4x8(static_cast<uint32_t>(child.normal))) * child_coverage;
+			weight += child_coverage;
+		}
+		coverage = std::min(weight / 4.0f, 1.0f);
+	}
+
+	color = weight > 0.0f ? color / weight : glm::vec3(0.0f);
+	normal = glm::length(normal) > 1e-6f ? glm::normalize(normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+	node.color = packColor(color, coverage);
+	node.normal = static_cast<int>(glm::packSnorm4x8(glm::vec4(normal, 0.0f)));
+}
+
 void SVO::flatten(std::vector<FlatSVONode> &flatNodes, std::vector<GPUVoxel> &flatVoxels)
 {
 	flatNodes.push_back(FlatSVONode{});
@@ -175,6 +324,15 @@ void SVO::flatten(std::vector<FlatSVONode> &flatNodes, std::vector<GPUVoxel> &fl
 			}
 		}
 	}
+
+	// children always come after their parent so a reverse walk sees them first
+	for (int i = static_cast<int>(flatNodes.size()) - 1; i >= 0; i--)
+		SVO::aggregate(flatNodes, flatVoxels, i);
+}
+
+SVO *SVO::getChild(int index)
+{
+	return (_children[index]);
 }
 
 int SVO::getNodeCount()
@@ -0,0 +1,736 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SVOStreamer.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 10:12:40 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 10:12:40 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "SVOStreamer.hpp"
+
+#ifndef _WIN32
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+// smaller subtrees stay in the top tree, a slot would be mostly empty
+#define STREAM_MIN_VOXELS (STREAM_SLOT_VOXELS / 16)
+
+// bfs copy of the subtree at root keeping children in groups of 8, a node
+// for which cut() returns true is copied without what is below it
+template <typename Cut>
+static void	copySubtree(const std::vector<FlatSVONode> &src_nodes, const std::vector<GPUVoxel> &src_voxels, int root,
+	std::vector<FlatSVONode> &nodes, std::vector<GPUVoxel> &voxels, Cut cut)
+{
+	std::queue<std::pair<int, int>> queue;
+
+	nodes.push_back(src_nodes[root]);
+	queue.push({root, static_cast<int>(nodes.size()) - 1});
+
+	while (!queue.empty())
+	{
+		auto [src, dst] = queue.front();
+		queue.pop();
+
+		const FlatSVONode &node = src_nodes[src];
+		if (cut(src, nodes[dst]))
+			continue ;
+
+		if (node.childOffset >= 0)
+		{
+			int offset = nodes.size();
+			nodes[dst].childOffset = offset;
+			for (int i = 0; i < 8; i++)
+			{
+				nodes.push_back(src_nodes[node.childOffset + i]);
+				queue.push({node.childOffset + i, offset + i});
+			}
+		}
+		else if (node.voxelCount > 0)
+		{
+			nodes[dst].voxelIndex = voxels.size();
+			voxels.insert(voxels.end(), src_voxels.begin() + node.voxelIndex, src_voxels.begin() + node.voxelIndex + node.voxelCount);
+		}
+	}
+}
+
+// a box of the top tree the bricks hang from, min and side
+typedef std::array<int, 4>	StreamBox;
+
+// what a box under the top levels became: a brick with its root node, or
+// a subtree too small for a slot that stays resident
+struct StreamCut
+{
+	int							brick;
+	std::vector<FlatSVONode>	nodes;
+	std::vector<GPUVoxel>		voxels;
+};
+
+struct StreamBuild
+{
+	std::ofstream						file;
+	uint64_t							offset;
+	std::vector<StreamBrick>			&bricks;
+	std::map<StreamBox, StreamCut>		cuts;
+	std::mutex							mutex;
+};
+
+// the tree of the voxels in the cube at min, written to the cache as soon
+// as it fits a slot, cut in 8 when it does not
+static void	cutCube(glm::ivec3 min, int side, std::vector<GPUVoxel> &voxels, StreamBuild &build)
+{
+	if (voxels.empty())
+		return ;
+
+	std::vector<FlatSVONode> nodes;
+	std::vector<GPUVoxel> flat;
+	{
+		SVO tree(min, min + side);
+		for (GPUVoxel &voxel : voxels)
+			tree.insert(voxel, 16);
+		tree.flatten(nodes, flat);
+	}
+
+	if (side > 1 && (nodes.size() > STREAM_SLOT_NODES || flat.size() > STREAM_SLOT_VOXELS))
+	{
+		int half = side / 2;
+		std::vector<GPUVoxel> octants[8];
+		for (const GPUVoxel &voxel : voxels)
+		{
+			glm::ivec3 octant = glm::ivec3(glm::greaterThanEqual(voxel.position, min + half));
+			octants[octant.x | (octant.y << 1) | (octant.z << 2)].push_back(voxel);
+		}
+		std::vector<GPUVoxel>().swap(voxels);
+
+		for (int i = 0; i < 8; i++)
+			cutCube(min + half * glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1), half, octants[i], build);
+		return ;
+	}
+
+	StreamCut cut;
+	std::lock_guard<std::mutex> lock(build.mutex);
+
+	// too few voxels for a slot, the subtree stays with the top tree
+	if (flat.size() >= STREAM_MIN_VOXELS && build.file.is_open())
+	{
+		cut.brick = build.bricks.size();
+		cut.nodes.push_back(nodes[0]);
+
+		build.bricks.push_back(StreamBrick{build.offset, static_cast<int>(nodes.size()), static_cast<int>(flat.size())});
+		build.file.write(reinterpret_cast<const char *>(nodes.data()), nodes.size() * sizeof(FlatSVONode));
+		build.file.write(reinterpret_cast<const char *>(flat.data()), flat.size() * sizeof(GPUVoxel));
+		build.offset += nodes.size() * sizeof(FlatSVONode) + flat.size() * sizeof(GPUVoxel);
+	}
+	else
+	{
+		cut.brick = -1;
+		cut.nodes.swap(nodes);
+		cut.voxels.swap(flat);
+	}
+	build.cuts[StreamBox{min.x, min.y, min.z, side}] = std::move(cut);
+}
+
+// a brick becomes a proxy in place of the box node, shaded from the color
+// and normal its root aggregated until it is loaded, a resident subtree
+// has its root there and the rest after the top tree built so far
+static void	placeCut(const StreamCut &cut, int index, std::vector<FlatSVONode> &nodes, std::vector<GPUVoxel> &voxels)
+{
+	if (cut.brick >= 0)
+	{
+		nodes[index] = cut.nodes[0];
+		nodes[index].childOffset = STREAM_PROXY;
+		nodes[index].voxelIndex = -1;
+		nodes[index].voxelCount = cut.brick;
+		return ;
+	}
+
+	int node_delta = static_cast<int>(nodes.size()) - 1;
+	int voxel_delta = voxels.size();
+	for (size_t i = 0; i < cut.nodes.size(); i++)
+	{
+		FlatSVONode node = cut.nodes[i];
+		if (node.childOffset >= 0)
+			node.childOffset += node_delta;
+		if (node.voxelIndex >= 0)
+			node.voxelIndex += voxel_delta;
+
+		if (i == 0)
+			nodes[index] = node;
+		else
+			nodes.push_back(node);
+	}
+	voxels.insert(voxels.end(), cut.voxels.begin(), cut.voxels.end());
+}
+
+// the world comes from the stream source of the scene when it has one,
+// else the whole tree in the flat arrays is split
+SVOStreamer::SVOStreamer(Scene &scene, int slots, const std::string &cache_path)
+	: _cache_path(cache_path), _fd(-1), _mapped(nullptr), _mapped_size(0), _slot_count(slots)
+{
+	std::vector<FlatSVONode> top_nodes;
+	std::vector<GPUVoxel> top_voxels;
+
+	if (scene.getStreamSource())
+		this->build(scene, top_nodes, top_voxels);
+	else
+		this->split(scene, top_nodes, top_voxels);
+	this->attach(scene, top_nodes, top_voxels);
+	if (!this->mapCache())
+		std::cerr << "Streaming: could not map " << _cache_path << ", bricks are read from the file" << std::endl;
+
+	size_t brick_count = _bricks.size();
+
+	_resident.assign(brick_count, -1);
+	_last_used.assign(brick_count, -1);
+	_pending.assign(brick_count, false);
+	_slot_brick.assign(_slot_count, -1);
+
+	// one entry at least so the binding is valid on a scene without bricks
+	std::vector<StreamEntry> table(std::max<size_t>(brick_count, 1), StreamEntry{-1, -1});
+	GLsizeiptr table_size = table.size() * sizeof(StreamEntry);
+	_table = new Buffer(Buffer::Type::SSBO, STREAM_TABLE_BINDING, table_size, table.data());
+
+	glGenBuffers(STREAM_FEEDBACK_FRAMES, _readback);
+	for (int i = 0; i < STREAM_FEEDBACK_FRAMES; i++)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _readback[i]);
+		glBufferData(GL_COPY_WRITE_BUFFER, table_size, nullptr, GL_STREAM_READ);
+		_fences[i] = nullptr;
+		_readback_frame[i] = -1;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	_frame = 0;
+	_seen_frame = -1;
+	_loads = 0;
+	_evictions = 0;
+	_stop = false;
+
+	_thread = std::thread(&SVOStreamer::worker, this);
+
+	std::cout << "Streaming: " << brick_count << " bricks, top tree of " << _top_nodes << " nodes and "
+		<< _top_voxels << " voxels, pool of " << _slot_count << " slots" << std::endl;
+}
+
+SVOStreamer::~SVOStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+	_thread.join();
+
+	for (GLsync fence : _fences)
+		if (fence)
+			glDeleteSync(fence);
+	glDeleteBuffers(STREAM_FEEDBACK_FRAMES, _readback);
+	delete (_table);
+
+#ifndef _WIN32
+	if (_mapped)
+		munmap(const_cast<uint8_t *>(_mapped), _mapped_size);
+	if (_fd >= 0)
+		close(_fd);
+#endif
+
+	std::error_code error;
+	std::filesystem::remove(_cache_path, error);
+}
+
+// picks the highest subtrees that fit a slot in the flat arrays and writes
+// them to the cache file, what is left above them is the top tree
+void			SVOStreamer::split(Scene &scene, std::vector<FlatSVONode> &top_nodes, std::vector<GPUVoxel> &top_voxels)
+{
+	RV_TRACE_SCOPE("Stream split");
+
+	const std::vector<FlatSVONode> &nodes = scene.flatNodes;
+	const std::vector<GPUVoxel> &voxels = scene.flatVoxels;
+
+	// children always come after their parent in the bfs order
+	std::vector<int> subtree_nodes(nodes.size(), 1);
+	std::vector<int> subtree_voxels(nodes.size(), 0);
+	for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; i--)
+	{
+		if (nodes[i].childOffset < 0)
+		{
+			subtree_voxels[i] = nodes[i].voxelCount;
+			continue ;
+		}
+		for (int c = 0; c < 8; c++)
+		{
+			subtree_nodes[i] += subtree_nodes[nodes[i].childOffset + c];
+			subtree_voxels[i] += subtree_voxels[nodes[i].childOffset + c];
+		}
+	}
+
+	std::vector<int> brick_id(nodes.size(), -1);
+	std::vector<int> brick_roots;
+	std::queue<int> queue;
+	if (!nodes.empty())
+		queue.push(0);
+
+	while (!queue.empty())
+	{
+		int index = queue.front();
+		queue.pop();
+
+		if (index != 0 && subtree_nodes[index] <= STREAM_SLOT_NODES && subtree_voxels[index] <= STREAM_SLOT_VOXELS)
+		{
+			if (subtree_voxels[index] >= STREAM_MIN_VOXELS)
+			{
+				brick_id[index] = brick_roots.size();
+				brick_roots.push_back(index);
+			}
+			continue ;
+		}
+		if (nodes[index].childOffset >= 0)
+			for (int c = 0; c < 8; c++)
+				queue.push(nodes[index].childOffset + c);
+	}
+
+	std::ofstream file(_cache_path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "Streaming: could not create " << _cache_path << ", nothing is streamed" << std::endl;
+		brick_roots.clear();
+		std::fill(brick_id.begin(), brick_id.end(), -1);
+	}
+
+	uint64_t offset = 0;
+	for (int root : brick_roots)
+	{
+		std::vector<FlatSVONode> brick_nodes;
+		std::vector<GPUVoxel> brick_voxels;
+		copySubtree(nodes, voxels, root, brick_nodes, brick_voxels,
+			[](int, FlatSVONode &) { return (false); });
+
+
+		_bricks.push_back(StreamBrick{offset, static_cast<int>(brick_nodes.size()), static_cast<int>(brick_voxels.size())});
+		file.write(reinterpret_cast<const char *>(brick_nodes.data()), brick_nodes.size() * sizeof(FlatSVONode));
+		file.write(reinterpret_cast<const char *>(brick_voxels.data()), brick_voxels.size() * sizeof(GPUVoxel));
+		offset += brick_nodes.size() * sizeof(FlatSVONode) + brick_voxels.size() * sizeof(GPUVoxel);
+	}
+	file.close();
+
+	// a proxy keeps its box, child mask and averages, voxelCount holds the brick id
+	if (!nodes.empty())
+		copySubtree(nodes, voxels, 0, top_nodes, top_voxels,
+			[&](int src, FlatSVONode &node)
+			{
+				if (brick_id[src] < 0)
+					return (false);
+				node.childOffset = STREAM_PROXY;
+				node.voxelIndex = -1;
+				node.voxelCount = brick_id[src];
+				return (true);
+			});
+
+	std::cout << "Streaming: " << nodes.size() << " nodes and " << voxels.size() << " voxels, "
+		<< offset / (1024 * 1024) << " MB written to " << _cache_path << std::endl;
+}
+
+// the world from the stream source of the scene without ever holding all
+// of it: every column of chunks is cut into cubes of CHUNK_DIM that become
+// bricks on their own, the top tree is then built over the boxes that got
+// something, columns are filled and cut on the shared ThreadPool
+void			SVOStreamer::build(Scene &scene, std::vector<FlatSVONode> &top_nodes, std::vector<GPUVoxel> &top_voxels)
+{
+	RV_TRACE_SCOPE("Stream build");
+
+	const ChunkSource &source = scene.getStreamSource();
+	int world_dim = scene.getWorldDim();
+	int side = std::min(CHUNK_DIM, world_dim);
+	int columns = world_dim / side;
+
+	StreamBuild build{std::ofstream(_cache_path, std::ios::binary | std::ios::trunc), 0, _bricks, {}, {}};
+	if (!build.file.is_open())
+		std::cerr << "Streaming: could not create " << _cache_path << ", nothing is streamed" << std::endl;
+
+	ThreadPool::shared().parallelFor(columns * columns, [&](int begin, int end)
+	{
+		for (int c = begin; c < end; c++)
+		{
+			glm::ivec3 origin((c % columns) * side, 0, (c / columns) * side);
+			std::vector<GPUVoxel> column;
+			source(origin, column);
+
+			std::vector<std::vector<GPUVoxel>> cubes(columns);
+			for (GPUVoxel voxel : column)
+			{
+				if (glm::any(glm::lessThan(voxel.position, glm::ivec3(0))) || voxel.position.x >= side || voxel.position.z >= side
+					|| voxel.position.y >= world_dim)
+					continue ;
+				voxel.position += origin;
+				cubes[voxel.position.y / side].push_back(voxel);
+			}
+			std::vector<GPUVoxel>().swap(column);
+
+			for (int y = 0; y < columns; y++)
+				cutCube(origin + glm::ivec3(0, y * side, 0), side, cubes[y], build);
+		}
+	});
+	build.file.close();
+
+	// every box above a cut has something in it
+	std::set<StreamBox> inner;
+	for (const auto &[box, cut] : build.cuts)
+		for (int size = box[3] * 2; size <= world_dim; size *= 2)
+			inner.insert(StreamBox{box[0] / size * size, box[1] / size * size, box[2] / size * size, size});
+
+	// parents before children like SVO::flatten, the nodes made here are
+	// aggregated at the end, the cuts come with theirs
+	FlatSVONode empty{};
+	empty.childOffset = -1;
+	empty.voxelIndex = -1;
+
+	std::vector<int> made;
+	std::queue<std::pair<StreamBox, int>> queue;
+	top_nodes.push_back(empty);
+	top_nodes[0].max = glm::ivec3(world_dim);
+	queue.push({StreamBox{0, 0, 0, world_dim}, 0});
+	made.push_back(0);
+
+	while (!queue.empty())
+	{
+		auto [box, index] = queue.front();
+		queue.pop();
+
+		auto found = build.cuts.find(box);
+		if (found != build.cuts.end())
+		{
+			placeCut(found->second, index, top_nodes, top_voxels);
+			build.cuts.erase(found);
+			continue ;
+		}
+		if (!inner.count(box))
+			continue ;
+
+		int half = box[3] / 2;
+		int offset = top_nodes.size();
+		top_nodes[index].childOffset = offset;
+		for (int i = 0; i < 8; i++)
+		{
+			StreamBox child = {box[0] + half * (i & 1), box[1] + half * ((i >> 1) & 1), box[2] + half * ((i >> 2) & 1), half};
+
+			top_nodes.push_back(empty);
+			top_nodes.back().min = glm::ivec3(child[0], child[1], child[2]);
+			top_nodes.back().max = top_nodes.back().min + half;
+			made.push_back(offset + i);
+
+			if (build.cuts.count(child) || inner.count(child))
+			{
+				top_nodes[index].childMask |= 1 << i;
+				queue.push({child, offset + i});
+			}
+		}
+	}
+
+	for (int i = static_cast<int>(made.size()) - 1; i >= 0; i--)
+		if (top_nodes[made[i]].childOffset != STREAM_PROXY)
+			SVO::aggregate(top_nodes, top_voxels, made[i]);
+
+	std::cout << "Streaming: " << _bricks.size() << " bricks from the stream source, "
+		<< build.offset / (1024 * 1024) << " MB written to " << _cache_path << std::endl;
+}
+
+// leaves the scene with the top tree, the instanced models and the empty
+// pool, the world part of the flat arrays is dropped
+void			SVOStreamer::attach(Scene &scene, std::vector<FlatSVONode> &top_nodes, std::vector<GPUVoxel> &top_voxels)
+{
+	const std::vector<FlatSVONode> &nodes = scene.flatNodes;
+	const std::vector<GPUVoxel> &voxels = scene.flatVoxels;
+
+	// instanced models stay resident, moved down right after the top tree
+	for (SceneModel &model : scene.getModels())
+	{
+		int node_delta = static_cast<int>(top_nodes.size()) - model.first_node;
+		int voxel_delta = static_cast<int>(top_voxels.size()) - model.first_voxel;
+
+		for (int i = 0; i < model.node_count; i++)
+		{
+			FlatSVONode node = nodes[model.first_node + i];
+			if (node.childOffset >= 0)
+				node.childOffset += node_delta;
+			if (node.voxelIndex >= 0)
+				node.voxelIndex += voxel_delta;
+			top_nodes.push_back(node);
+		}
+		top_voxels.insert(top_voxels.end(), voxels.begin() + model.first_voxel, voxels.begin() + model.first_voxel + model.voxel_count);
+
+		model.first_node += node_delta;
+		model.first_voxel += voxel_delta;
+		model.root += node_delta;
+		for (int &root : model.frame_roots)
+			root += node_delta;
+	}
+
+	_top_nodes = top_nodes.size();
+	_top_voxels = top_voxels.size();
+
+	FlatSVONode empty{};
+	empty.childOffset = -1;
+	empty.voxelIndex = -1;
+	top_nodes.resize(top_nodes.size() + static_cast<size_t>(_slot_count) * STREAM_SLOT_NODES, empty);
+	top_voxels.resize(top_voxels.size() + static_cast<size_t>(_slot_count) * STREAM_SLOT_VOXELS, GPUVoxel{});
+
+	scene.flatNodes.swap(top_nodes);
+	scene.flatVoxels.swap(top_voxels);
+}
+
+bool			SVOStreamer::mapCache()
+{
+#ifndef _WIN32
+	_fd = open(_cache_path.c_str(), O_RDONLY);
+	if (_fd < 0)
+		return (false);
+
+	_mapped_size = lseek(_fd, 0, SEEK_END);
+	if (_mapped_size == 0)
+		return (true);
+
+	void *mapped = mmap(nullptr, _mapped_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+	if (mapped == MAP_FAILED)
+		return (false);
+	_mapped = static_cast<const uint8_t *>(mapped);
+	return (true);
+#else
+	return (false);
+#endif
+}
+
+// before the trace: takes in the feedback that arrived, asks for the
+// bricks rays reached, uploads what the worker finished and queues a copy
+// of the table for a later frame to read
+void			SVOStreamer::update(PagedBuffer &nodes, PagedBuffer &voxels)
+{
+	RV_TRACE_SCOPE("Streaming");
+
+	_frame++;
+
+	this->readFeedback();
+	this->request();
+	this->upload(nodes, voxels);
+
+	int region = _frame % STREAM_FEEDBACK_FRAMES;
+	if (_fences[region] || _bricks.empty())
+		return ;
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_COPY_READ_BUFFER, _table->getID());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _readback[region]);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, _bricks.size() * sizeof(StreamEntry));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	_fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_readback_frame[region] = _frame - 1;
+}
+
+void			SVOStreamer::setUniforms(ShaderProgram &program) const
+{
+	program.set_int("u_streamFrame", _frame);
+	program.set_int("u_streamNodeBase", _top_nodes);
+}
+
+void			SVOStreamer::readFeedback()
+{
+	for (int i = 0; i < STREAM_FEEDBACK_FRAMES; i++)
+	{
+		if (!_fences[i])
+			continue ;
+
+		GLenum status = glClientWaitSync(_fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			continue ;
+		glDeleteSync(_fences[i]);
+		_fences[i] = nullptr;
+
+		GLsizeiptr size = _bricks.size() * sizeof(StreamEntry);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _readback[i]);
+		const StreamEntry *entries = static_cast<const StreamEntry *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, GL_MAP_READ_BIT));
+		if (entries)
+		{
+			for (size_t brick = 0; brick < _bricks.size(); brick++)
+				_last_used[brick] = std::max(_last_used[brick], entries[brick].last_used);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			_seen_frame = std::max(_seen_frame, _readback_frame[i]);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+}
+
+// bricks that rays reached in the newest feedback and that are not in
+// the pool yet, a few per frame so uploads stay small
+void			SVOStreamer::request()
+{
+	if (_seen_frame < 0)
+		return ;
+
+	int requested = 0;
+	for (size_t brick = 0; brick < _bricks.size() && requested < STREAM_LOADS_PER_FRAME; brick++)
+	{
+		if (_resident[brick] >= 0 || _pending[brick] || _last_used[brick] < _seen_frame)
+			continue ;
+
+		int slot = this->findSlot();
+		if (slot < 0)
+			break ;
+
+		_pending[brick] = true;
+		_slot_brick[slot] = brick;
+		requested++;
+
+		StreamLoad job;
+		job.brick = brick;
+		job.slot = slot;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_jobs.push(std::move(job));
+		}
+		_condition.notify_all();
+	}
+}
+
+// a free slot, or the one of the least recently used brick that was not
+// seen in the newest feedback, -1 when every slot is on screen
+int				SVOStreamer::findSlot()
+{
+	int victim = -1;
+
+	for (int slot = 0; slot < _slot_count; slot++)
+	{
+		int brick = _slot_brick[slot];
+		if (brick < 0)
+			return (slot);
+		if (_pending[brick] || _last_used[brick] >= _seen_frame)
+			continue ;
+		if (victim < 0 || _last_used[brick] < _last_used[_slot_brick[victim]])
+			victim = slot;
+	}
+
+	if (victim < 0)
+		return (-1);
+
+	// frames already queued still read the old brick, the gpu runs them
+	// before this write so the slot can be refilled right away
+	int evicted = _slot_brick[victim];
+	int none = -1;
+	_table->updateRange(&none, evicted * sizeof(StreamEntry), sizeof(int));
+	_resident[evicted] = -1;
+	_slot_brick[victim] = -1;
+	_evictions++;
+
+	return (victim);
+}
+
+// pool data first, then the table entry that makes the brick visible
+void			SVOStreamer::upload(PagedBuffer &nodes, PagedBuffer &voxels)
+{
+	std::queue<StreamLoad> done;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::swap(done, _done);
+	}
+
+	while (!done.empty())
+	{
+		StreamLoad &load = done.front();
+
+		nodes.updateRange(load.nodes.data(), _top_nodes + static_cast<size_t>(load.slot) * STREAM_SLOT_NODES, load.nodes.size());
+		voxels.updateRange(load.voxels.data(), _top_voxels + static_cast<size_t>(load.slot) * STREAM_SLOT_VOXELS, load.voxels.size());
+		_table->updateRange(&load.slot, load.brick * sizeof(StreamEntry), sizeof(int));
+
+		_resident[load.brick] = load.slot;
+		_pending[load.brick] = false;
+		_loads++;
+
+		done.pop();
+	}
+}
+
+void			SVOStreamer::worker()
+{
+	TraceRecorder::setThreadName("Streaming");
+
+	while (true)
+	{
+		StreamLoad job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this] { return (_stop || !_jobs.empty()); });
+			if (_stop)
+				return ;
+
+			job = std::move(_jobs.front());
+			_jobs.pop();
+		}
+
+		this->load(job);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_done.push(std::move(job));
+		}
+	}
+}
+
+// reads the brick from the mapping, or the file where there is none, and
+// moves its brick local indices to where its slot is in the pool
+void			SVOStreamer::load(StreamLoad &load)
+{
+	RV_TRACE_SCOPE("Load brick");
+
+	const StreamBrick &brick = _bricks[load.brick];
+	size_t node_bytes = brick.node_count * sizeof(FlatSVONode);
+	size_t voxel_bytes = brick.voxel_count * sizeof(GPUVoxel);
+
+	load.nodes.resize(brick.node_count);
+	load.voxels.resize(brick.voxel_count);
+
+	if (_mapped)
+	{
+		memcpy(load.nodes.data(), _mapped + brick.offset, node_bytes);
+		memcpy(load.voxels.data(), _mapped + brick.offset + node_bytes, voxel_bytes);
+	}
+	else
+	{
+		std::ifstream file(_cache_path, std::ios::binary);
+		file.seekg(brick.offset);
+		file.read(reinterpret_cast<char *>(load.nodes.data()), node_bytes);
+		file.read(reinterpret_cast<char *>(load.voxels.data()), voxel_bytes);
+	}
+
+	int node_base = _top_nodes + load.slot * STREAM_SLOT_NODES;
+	int voxel_base = _top_voxels + load.slot * STREAM_SLOT_VOXELS;
+	for (FlatSVONode &node : load.nodes)
+	{
+		if (node.childOffset >= 0)
+			node.childOffset += node_base;
+		else if (node.voxelCount > 0)
+			node.voxelIndex += voxel_base;
+	}
+}
+
+void			SVOStreamer::imGuiRender()
+{
+	if (!ImGui::CollapsingHeader("Streaming"))
+		return ;
+
+	int resident = 0;
+	int pending = 0;
+	for (size_t brick = 0; brick < _bricks.size(); brick++)
+	{
+		resident += _resident[brick] >= 0;
+		pending += _pending[brick];
+	}
+
+	ImGui::Text("Bricks %zu  Resident %d / %d slots", _bricks.size(), resident, _slot_count);
+	ImGui::Text("Loads %d  Evictions %d  Pending %d", _loads, _evictions, pending);
+	ImGui::TextDisabled("%s", _cache_path.c_str());
+}
@@ -15,14 +15,28 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-Scene::Scene()
+// world_dim is the side of the world box in voxels, a power of two,
+// voxel_size the side of a voxel in world units
+Scene::Scene(int world_dim, float voxel_size) : _world_dim(world_dim), _voxel_size(voxel_size)
 {
-	_camera = new Camera(glm::vec3(static_cast<float>((VOXEL_DIM / 2.0) * VOXEL_SIZE)), glm::vec3(0.0f, 1.0f, 0.0f), 90.0f, 0.0f);
+	_camera = new Camera(glm::vec3((world_dim / 2.0f) * voxel_size), glm::vec3(0.0f, 1.0f, 0.0f), 90.0f, 0.0f);
 
 	_gpu_debug.enabled = 0;
 	_gpu_debug.mode = 0;
 	_gpu_debug.triangle_treshold = 1;
 	_gpu_debug.box_treshold = 1;
+
+	_gpu_denoise.enabled = 1;
+	_gpu_denoise.temporal = 1;
+	_gpu_denoise.iterations = 4;
+	_gpu_denoise.phi_color = 4.0f;
+	_gpu_denoise.phi_normal = 128.0f;
+	_gpu_denoise.phi_depth = 0.05f;
+	_gpu_denoise.phi_albedo = 0.25f;
+	_gpu_denoise.alpha = 0.2f;
+
+	_instances_added = false;
+	_instances_moved = false;
 }
 
 Scene::~Scene()
@@ -30,182 +44,621 @@ Scene::~Scene()
 	delete (_camera);
 }
 
-void	Scene::placeModel(VoxModel &model, glm::ivec3 position, std::vector<GPUVoxel> &voxel_data)
+// a vox model baked in a grid of its own size, transform takes a cell of
+// the grid (its min corner at the model min) into the world and only turns
+// by quarter turns so the cells stay on the grid
+struct ModelGrid
+{
+	glm::ivec3				size;
+	std::vector<uint32_t>	cells;
+	glm::mat4				transform;
+};
+
+static bool	gridFilled(const ModelGrid &grid, glm::ivec3 p)
 {
-	for (VoxChunk &chunk : model.getChunks())
+	if (glm::any(glm::lessThan(p, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(p, grid.size)))
+		return (false);
+	return (grid.cells[p.x + grid.size.x * static_cast<size_t>(p.y + grid.size.y * p.z)] != 0);
+}
+
+// every placed shape of the model, colors scaled by tint
+static ModelGrid	gridModel(VoxModel &model, glm::vec3 tint, const glm::mat4 &transform)
+{
+	ModelGrid grid;
+	grid.size = glm::max(model.getSize(), glm::ivec3(1));
+	grid.cells.assign(static_cast<size_t>(grid.size.x) * grid.size.y * grid.size.z, 0);
+	grid.transform = transform;
+
+	for (VoxInstance &instance : model.getInstances())
 	{
-		std::cout << "New voxel chunk " << chunk.width << "x" << chunk.height << "x" << chunk.depth << std::endl;
-		std::cout << "Offset " << chunk.offset_x << " " << chunk.offset_y << " " << chunk.offset_z << std::endl;
+		VoxChunk &chunk = model.getChunks()[instance.chunk];
 
-		glm::ivec3 offset = position + glm::ivec3(chunk.offset_x, chunk.offset_y, chunk.offset_z);
-		
 		for (int z = 0; z < chunk.depth; ++z)
-		{
 			for (int y = 0; y < chunk.height; ++y)
-			{
 				for (int x = 0; x < chunk.width; ++x)
 				{
-					int index_data = ((x + offset.x) + VOXEL_DIM * ((y + offset.y) + VOXEL_DIM * (z + offset.z)));						
-					
-					if (index_data < 0 || index_data >= VOXEL_DIM * VOXEL_DIM * VOXEL_DIM)
+					if (!chunk.voxels[z][y][x].active)
 						continue;
 
-					Voxel voxel = chunk.voxels[z][y][x];
-					if (voxel.active)
-					{
-						uint32_t color = model.getPalette()[voxel.paletteIndex];
-						voxel_data[index_data].color = color;
-					}
+					glm::vec4 center = instance.transform * glm::vec4(x + 0.5f, y + 0.5f, z + 0.5f, 1.0f);
+					glm::ivec3 p = glm::ivec3(glm::floor(glm::vec3(center))) - model.getMin();
+					if (glm::any(glm::lessThan(p, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(p, grid.size)))
+						continue;
+
+					uint32_t color = model.getPalette()[chunk.voxels[z][y][x].paletteIndex];
+					glm::uvec3 rgb = glm::uvec3(glm::vec3((color >> 24) & 0xFF, (color >> 16) & 0xFF, (color >> 8) & 0xFF) * glm::clamp(tint, 0.0f, 1.0f));
+					grid.cells[p.x + grid.size.x * static_cast<size_t>(p.y + grid.size.y * p.z)] = (rgb.r << 24) | (rgb.g << 16) | (rgb.b << 8) | 0xFF;
+				}
+	}
+	return (grid);
+}
+
+// the world voxel of the filled cell p, normals only see this grid
+static GPUVoxel	gridVoxel(const ModelGrid &grid, glm::ivec3 p)
+{
+	GPUVoxel voxel;
+	voxel.position = glm::ivec3(glm::floor(glm::vec3(grid.transform * glm::vec4(glm::vec3(p) + 0.5f, 1.0f))));
+	voxel.color = grid.cells[p.x + grid.size.x * static_cast<size_t>(p.y + grid.size.y * p.z)];
+	voxel.normal = glm::mat3(grid.transform) * voxelNormal(p, [&grid](glm::ivec3 q) { return (gridFilled(grid, q)); });
+	voxel.light = 0;
+	return (voxel);
+}
+
+// only the voxels of the grid go in a tree over the world box
+static SVO	*bakeGrid(const ModelGrid &grid, int world_dim)
+{
+	std::vector<GPUVoxel> voxels;
+	{
+		RV_TRACE_SCOPE("Normals");
+
+		for (int z = 0; z < grid.size.z; ++z)
+		{
+			for (int y = 0; y < grid.size.y; ++y)
+			{
+				for (int x = 0; x < grid.size.x; ++x)
+				{
+					glm::ivec3 p(x, y, z);
+					if (gridFilled(grid, p))
+						voxels.push_back(gridVoxel(grid, p));
 				}
 			}
 		}
 	}
+
+	SVO *root = new SVO(glm::ivec3(0), glm::ivec3(world_dim));
+	{
+		RV_TRACE_SCOPE("Insert");
+
+		for (GPUVoxel &voxel : voxels)
+			root->insert(voxel, 16);
+	}
+	return (root);
+}
+
+// position is where the origin of the vox file goes, cells outside the
+// world are left out
+SVO	*Scene::placeModel(VoxModel &model, glm::ivec3 position, int world_dim)
+{
+	RV_TRACE_SCOPE("Place model");
+
+	return (bakeGrid(gridModel(model, glm::vec3(1.0f), glm::translate(glm::mat4(1.0f), glm::vec3(position + model.getMin()))), world_dim));
 }
 
 void Scene::parseScene(std::string &name)
 {
-	SVO *root = new SVO(glm::ivec3(0), glm::ivec3(VOXEL_DIM));
+	RV_TRACE_SCOPE("Parse scene");
 
-	std::vector<GPUVoxel> voxel_data;
-	voxel_data.resize(VOXEL_DIM * VOXEL_DIM * VOXEL_DIM);
-	memset(voxel_data.data(), 0, voxel_data.size());
+	SceneSetup setup;
+	SVO *root = this->buildWorld(name, setup);
 
-	VoxModel model = VoxModel(name);
-	if (model.isParsed())
 	{
-		this->placeModel(model, glm::ivec3(VOXEL_DIM / 2), voxel_data);
+		RV_TRACE_SCOPE("Flatten");
+
+		root->flatten(flatNodes, flatVoxels);
+		delete (root);
 	}
-	else
-		std::cout << "Failed to parse vox model" << std::endl;
-	
-	// int index_data = (120 + VOXEL_DIM * (120 + VOXEL_DIM * 120));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (10 + VOXEL_DIM * (120 + VOXEL_DIM * 120));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (120 + VOXEL_DIM * (10 + VOXEL_DIM * 120));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (120 + VOXEL_DIM * (120 + VOXEL_DIM * 10));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (10 + VOXEL_DIM * (10 + VOXEL_DIM * 10));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (10 + VOXEL_DIM * (120 + VOXEL_DIM * 10));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (120 + VOXEL_DIM * (10 + VOXEL_DIM * 10));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (10 + VOXEL_DIM * (10 + VOXEL_DIM * 120));
-	// voxel_data[index_data].color = 0x00FF00FF;
-
-	// index_data = (30 + VOXEL_DIM * (30 + VOXEL_DIM * 30));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (5 + VOXEL_DIM * (30 + VOXEL_DIM * 30));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (30 + VOXEL_DIM * (5 + VOXEL_DIM * 30));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (30 + VOXEL_DIM * (30 + VOXEL_DIM * 5));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (5 + VOXEL_DIM * (5 + VOXEL_DIM * 5));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (5 + VOXEL_DIM * (30 + VOXEL_DIM * 5));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (30 + VOXEL_DIM * (5 + VOXEL_DIM * 5));
-	// voxel_data[index_data].color = 0x00FF00FF;
-	// index_data = (5 + VOXEL_DIM * (5 + VOXEL_DIM * 30));
-	// voxel_data[index_data].color = 0x00FF00FF;
-
-	// for (int x = 0; x < 30; x++)
+
+	// for (int i = 0; i < flatNodes.size(); i++)
 	// {
-	// 	index_data = (x + VOXEL_DIM * (30 + VOXEL_DIM * 30));
-	// 	voxel_data[index_data].color = 0xFF0000FF;
+	// 	std::cout << "Node: " << i << std::endl;
+	// 	std::cout << "Min: " << flatNodes[i].min.x << " " << flatNodes[i].min.y << " " << flatNodes[i].min.z << std::endl;
+	// 	std::cout << "Max: " << flatNodes[i].max.x << " " << flatNodes[i].max.y << " " << flatNodes[i].max.z << std::endl;
+	// 	std::cout << "Child offset: " << flatNodes[i].childOffset << std::endl;
+	// 	std::cout << "Voxel index: " << flatNodes[i].voxelIndex << std::endl;
+	// 	std::cout << "Voxel count: " << flatNodes[i].voxelCount << std::endl;
+	// 	std::cout << "Child mask: " << (int)flatNodes[i].childMask << std::endl;
+	// 	for (int j = 0; j < flatNodes[i].voxelCount; j++)
+	// 	{
+	// 		std::cout << "Voxel: " << flatVoxels[flatNodes[i].voxelIndex + j].position.x << " " << flatVoxels[flatNodes[i].voxelIndex + j].position.y << " " << flatVoxels[flatNodes[i].voxelIndex + j].position.z << std::endl;
+	// 	}
+	// 	std::cout << std::endl;
 	// }
-	for (int z = 0; z < VOXEL_DIM; ++z)
+
+	this->applySetup(setup);
+}
+
+static SVO	*readSceneFile(const std::string &path, int world_dim, float voxel_size, SceneSetup &setup);
+static SVO	*buildGround(int world_dim);
+static SVO	*bakeMesh(const MeshModel &mesh, const SceneFileEntry &entry, int world_dim, float voxel_size);
+
+// the world tree of a vox file or a scene file, before it is flattened, it
+// only reads the files and the world size so it can run off the main
+// thread, what a scene file sets besides voxels is left in setup for applySetup
+SVO	*Scene::buildWorld(const std::string &name, SceneSetup &setup) const
+{
+	int world_dim = _world_dim;
+
+	if (name.ends_with(".scene"))
+		return (readSceneFile(name, world_dim, _voxel_size, setup));
+
+	// images take the place of the ground, an empty world when they fail
+	if (ImageImporter::isImage(name) || (!name.empty() && std::filesystem::is_directory(name)))
 	{
-		for (int y = 0; y < VOXEL_DIM; ++y)
+		SVO *imported = ImageImporter::isImage(name) ? ImageImporter::heightmap(name, world_dim) : ImageImporter::stack(name, world_dim);
+		return (imported ? imported : new SVO(glm::ivec3(0), glm::ivec3(world_dim)));
+	}
+
+	// qb and binvox models on the ground, vxl maps bring their own
+	if (VoxelImporter::isVoxelFile(name))
+	{
+		std::vector<SVO *> trees = {VoxelImporter::isMap(name) ? nullptr : buildGround(world_dim), VoxelImporter::load(name, world_dim)};
+		SVO *root = SVO::mergeAll(trees);
+		return (root ? root : new SVO(glm::ivec3(0), glm::ivec3(world_dim)));
+	}
+
+	// a mesh half the world wide standing on the ground in the middle
+	if (MeshModel::isMesh(name))
+	{
+		MeshModel mesh(name);
+		SceneFileEntry entry = {name, glm::vec3(0.0f), 0.0f, 1.0f, glm::vec3(1.0f), world_dim / 2};
+		glm::vec3 extent = mesh.getMax() - mesh.getMin();
+		float height = extent.y * entry.resolution / std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+
+		entry.position = glm::vec3(world_dim / 2.0f, 3.0f + height / 2.0f, world_dim / 2.0f) * _voxel_size;
+		std::vector<SVO *> trees = {buildGround(world_dim), nullptr};
+		if (mesh.isParsed())
+			trees[1] = bakeMesh(mesh, entry, world_dim, _voxel_size);
+		else
+			std::cerr << "Failed to parse mesh " << name << std::endl;
+		return (SVO::mergeAll(trees));
+	}
+
+	RV_TRACE_SCOPE("Build world");
+
+	// the vox file with its origin in the middle of the world
+	std::vector<SVO *> trees = {buildGround(world_dim), nullptr};
+	std::string path = name;
+	VoxModel model = VoxModel(path);
+	if (model.isParsed())
+		trees[1] = Scene::placeModel(model, glm::ivec3(world_dim / 2), world_dim);
+	else
+		std::cout << "Failed to parse vox model" << std::endl;
+	return (SVO::mergeAll(trees));
+}
+
+// the grass floor of parseScene, the layers at y 0 to 2
+static SVO	*buildGround(int world_dim)
+{
+	RV_TRACE_SCOPE("Ground");
+
+	std::minstd_rand random(world_dim);
+	auto filled = [world_dim](glm::ivec3 p)
+	{
+		return (p.y <= 2 || glm::any(glm::lessThan(p, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(p, glm::ivec3(world_dim))));
+	};
+
+	std::vector<GPUVoxel> voxels;
+	{
+		RV_TRACE_SCOPE("Normals");
+
+		voxels.reserve(static_cast<size_t>(world_dim) * world_dim * 3);
+		for (int z = 0; z < world_dim; ++z)
 		{
-			for (int x = 0; x < VOXEL_DIM; ++x)
+			for (int y = 0; y <= 2; ++y)
 			{
-				int index_data = (x + VOXEL_DIM * (y + VOXEL_DIM * z));
-			
-				if (y <= 2)
+				for (int x = 0; x < world_dim; ++x)
 				{
-					int r = 20;
-					int g = 100 + rand() % 25;
-					int b = 20;
-					
-					voxel_data[index_data].color = (r << 24) | (g << 16) | (b << 8) | 0xFF;
+					GPUVoxel voxel;
+					voxel.position = glm::ivec3(x, y, z);
+					voxel.color = (20 << 24) | ((100 + static_cast<int>(random() % 25)) << 16) | (20 << 8) | 0xFF;
+					voxel.normal = voxelNormal(voxel.position, filled);
+					voxel.light = 0;
+					voxels.push_back(voxel);
 				}
+			}
+		}
+	}
+
+	SVO *root = new SVO(glm::ivec3(0), glm::ivec3(world_dim));
+	{
+		RV_TRACE_SCOPE("Insert");
+
+		for (GPUVoxel &voxel : voxels)
+			root->insert(voxel, 16);
+	}
+	return (root);
+}
+
+// the vox file of a model line in its grid, centered on the line position
+// and turned by quarter turns, false when it does not parse
+static bool	gridEntry(const SceneFileEntry &entry, float voxel_size, ModelGrid &grid)
+{
+	std::string name = entry.path;
+	VoxModel model = VoxModel(name);
+	if (!model.isParsed() || model.getInstances().empty())
+		return (false);
+
+	glm::ivec3 size = glm::max(model.getSize(), glm::ivec3(1));
+	int turns = ((static_cast<int>(std::round(entry.yaw / 90.0f)) % 4) + 4) % 4;
+	grid = gridModel(model, entry.tint, Scene::instanceTransform(size, entry.position / voxel_size, turns * 90.0f, 1.0f));
+	return (true);
+}
+
+// a whole vox file in its own tree over the world box, normals only see
+// the voxels of this file
+static SVO	*bakeModel(const SceneFileEntry &entry, int world_dim, float voxel_size)
+{
+	RV_TRACE_SCOPE("Bake model");
+
+	ModelGrid grid;
+	if (!gridEntry(entry, voxel_size, grid))
+		return (nullptr);
+	return (bakeGrid(grid, world_dim));
+}
+
+// the mesh centered on the entry position and scaled so its longest side
+// is entry.resolution voxels, turned by any yaw, the cells are taken
+// from the turned triangles
+static SVO	*bakeMesh(const MeshModel &mesh, const SceneFileEntry &entry, int world_dim, float voxel_size)
+{
+	glm::vec3 extent = mesh.getMax() - mesh.getMin();
+	float scale = entry.resolution / std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
 
+	glm::mat4 transform = glm::translate(glm::mat4(1.0f), entry.position / voxel_size);
+	transform = glm::rotate(transform, glm::radians(entry.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+	transform = glm::scale(transform, glm::vec3(scale));
+	transform = glm::translate(transform, -(mesh.getMin() + mesh.getMax()) * 0.5f);
+	return (mesh.voxelize(transform, world_dim, glm::clamp(entry.tint, 0.0f, 1.0f)));
+}
+
+// a text file of lines, # starts a comment, positions in world units:
+//   model path x y z [yaw [material]]       baked into the world tree
+//   mesh path x y z size [yaw [material]]   obj or ply, size voxels long
+//   instance path x y z [yaw [scale]]       shared model, see --instance
+//   material name r g b [emission [roughness [metallic]]]
+//   camera name x y z pitch yaw             the first one is applied
+// paths are relative to the scene file, models and meshes go in models
+static void	parseSceneFile(const std::string &path, std::vector<SceneFileEntry> &models, SceneSetup &setup)
+{
+	std::ifstream file(path);
+	std::string line;
+	int line_number = 0;
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+	std::map<std::string, glm::vec3> tints;
+	bool valid = file.is_open();
+
+	if (!valid)
+		std::cerr << "Failed to open scene file: " << path << std::endl;
+
+	while (valid && std::getline(file, line))
+	{
+		line_number++;
+
+		std::istringstream stream(line);
+		std::string kind;
+		if (!(stream >> kind) || kind[0] == '#')
+			continue ;
+
+		if (kind == "model" || kind == "mesh" || kind == "instance")
+		{
+			SceneFileEntry entry;
+			std::string material;
+
+			entry.yaw = 0.0f;
+			entry.scale = 1.0f;
+			entry.tint = glm::vec3(1.0f);
+			entry.resolution = 0;
+			stream >> entry.path >> entry.position.x >> entry.position.y >> entry.position.z;
+			if (kind == "mesh")
+				stream >> entry.resolution;
+			valid = !stream.fail() && (kind != "mesh" || entry.resolution > 0);
+			entry.path = (directory / entry.path).string();
+
+			if (valid && stream >> entry.yaw)
+			{
+				if (kind == "instance")
+					stream >> entry.scale;
+				else if (stream >> material)
+				{
+					valid = tints.count(material);
+					entry.tint = valid ? tints[material] : glm::vec3(1.0f);
+				}
 			}
+
+			if (kind != "instance")
+				models.push_back(entry);
+			else
+				setup.instances.push_back(entry);
+		}
+		else if (kind == "material")
+		{
+			std::string name;
+			GPUMaterial material = {};
+			material.roughness = 1.0f;
+			material.texture_index = -1;
+			material.emission_texture_index = -1;
+
+			stream >> name >> material.color.r >> material.color.g >> material.color.b;
+			valid = !stream.fail();
+			stream >> material.emission >> material.roughness >> material.metallic;
+
+			tints[name] = material.color;
+			setup.materials.push_back(material);
 		}
+		else if (kind == "camera")
+		{
+			CameraPreset preset;
+			stream >> preset.name >> preset.position.x >> preset.position.y >> preset.position.z >> preset.pitch >> preset.yaw;
+			valid = !stream.fail();
+			setup.cameras.push_back(preset);
+		}
+		else
+			valid = false;
+
+		if (!valid)
+			std::cerr << path << ":" << line_number << ": invalid scene line" << std::endl;
+	}
+
+	if (!valid)
+	{
+		models.clear();
+		setup.instances.clear();
 	}
+}
+
+// the models of a scene file parse and bake on the shared ThreadPool, each
+// into its own tree, merged pairwise at the end
+static SVO	*readSceneFile(const std::string &path, int world_dim, float voxel_size, SceneSetup &setup)
+{
+	RV_TRACE_SCOPE("Load scene file");
 
-	//count time to insert voxels in ms
 	auto start = std::chrono::high_resolution_clock::now();
 
-	int count = 0;
-	for (int z = 0; z < VOXEL_DIM; ++z)
+	std::vector<SceneFileEntry> models;
+	parseSceneFile(path, models, setup);
+
+	ThreadPool &pool = ThreadPool::shared();
+	std::vector<SVO *> trees(models.size() + 1, nullptr);
+
+	// tree 0 is the ground, waits for these trees only
+	pool.parallelFor(trees.size(), [&trees, &models, world_dim, voxel_size](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (i == 0)
+				trees[0] = buildGround(world_dim);
+			else if (models[i - 1].resolution == 0)
+				trees[i] = bakeModel(models[i - 1], world_dim, voxel_size);
+			else
+			{
+				MeshModel mesh(models[i - 1].path);
+				if (mesh.isParsed())
+					trees[i] = bakeMesh(mesh, models[i - 1], world_dim, voxel_size);
+			}
+		}
+	});
+
+	for (size_t i = 0; i < models.size(); i++)
+		if (!trees[i + 1])
+			std::cerr << "Failed to parse model " << models[i].path << std::endl;
+
+	// later lines win where models overlap
+	SVO *root = SVO::mergeAll(trees);
+
+	std::cout << "Scene " << path << ": " << models.size() << " models in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count()
+		<< "ms on " << pool.getThreadCount() << " threads" << std::endl;
+
+	return (root);
+}
+
+// the ground of buildGround under the model grids as chunk columns for the
+// streamer, a column is CHUNK_DIM wide and as high as the world, later
+// grids win where they overlap, the grids are only read so columns can be
+// filled on the pool workers
+static ChunkSource	streamColumns(int world_dim, std::shared_ptr<const std::vector<ModelGrid>> grids)
+{
+	return ([world_dim, grids](glm::ivec3 origin, std::vector<GPUVoxel> &voxels)
 	{
-		for (int y = 0; y < VOXEL_DIM; ++y)
+		glm::ivec3 low = glm::max(origin, glm::ivec3(0));
+		glm::ivec3 high = glm::min(origin + glm::ivec3(CHUNK_DIM, world_dim, CHUNK_DIM), glm::ivec3(world_dim));
+		if (glm::any(glm::greaterThanEqual(low, high)))
+			return ;
+
+		std::minstd_rand random(static_cast<uint32_t>(origin.x * 73856093) ^ static_cast<uint32_t>(origin.z * 19349663));
+		auto ground = [world_dim](glm::ivec3 p)
+		{
+			return (p.y <= 2 || glm::any(glm::lessThan(p, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(p, glm::ivec3(world_dim))));
+		};
+
+		for (int z = low.z; z < high.z; ++z)
 		{
-			for (int x = 0; x < VOXEL_DIM; ++x)
+			for (int y = low.y; y <= std::min(2, high.y - 1); ++y)
 			{
-				int index_data = (x + VOXEL_DIM * (y + VOXEL_DIM * z));
-			
-				if (voxel_data[index_data].color != 0)
+				for (int x = low.x; x < high.x; ++x)
 				{
-					count++;
 					GPUVoxel voxel;
-					voxel.position = glm::ivec3(x, y, z);
-					voxel.color = voxel_data[index_data].color;
-					voxel.normal = glm::vec3(0.);
+					voxel.position = glm::ivec3(x, y, z) - origin;
+					voxel.color = (20 << 24) | ((100 + static_cast<int>(random() % 25)) << 16) | (20 << 8) | 0xFF;
+					voxel.normal = voxelNormal(glm::ivec3(x, y, z), ground);
+					voxel.light = 0;
+					voxels.push_back(voxel);
+				}
+			}
+		}
 
-					for (int xo = -1; xo <= 1; xo++)
+		size_t ground_count = voxels.size();
+		for (const ModelGrid &grid : *grids)
+		{
+			// the world box of the grid cut to the column, its cells are
+			// found back through the inverse turn
+			glm::vec3 box_min = glm::vec3(grid.transform * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+			glm::vec3 box_max = box_min;
+			for (int c = 1; c < 8; c++)
+			{
+				glm::vec3 corner = glm::vec3(grid.transform * glm::vec4(glm::vec3(glm::ivec3(c & 1, (c >> 1) & 1, (c >> 2) & 1) * grid.size), 1.0f));
+				box_min = glm::min(box_min, corner);
+				box_max = glm::max(box_max, corner);
+			}
+			glm::ivec3 first = glm::max(low, glm::ivec3(glm::floor(box_min)));
+			glm::ivec3 last = glm::min(high, glm::ivec3(glm::ceil(box_max)));
+			glm::mat4 inverse = glm::inverse(grid.transform);
+
+			for (int z = first.z; z < last.z; ++z)
+			{
+				for (int y = first.y; y < last.y; ++y)
+				{
+					for (int x = first.x; x < last.x; ++x)
 					{
-						for (int yo = -1; yo <= 1; yo++)
-						{
-							for (int zo = -1; zo <= 1; zo++)
-							{
-								glm::ivec3 offset = glm::ivec3(xo, yo, zo);
-
-								int new_index_data = (x + xo + VOXEL_DIM * ((y + yo) + VOXEL_DIM * (z + zo)));
-								if (new_index_data < 0 || new_index_data >= VOXEL_DIM * VOXEL_DIM * VOXEL_DIM)
-									continue;
-
-								if (voxel_data[new_index_data].color == 0)
-									voxel.normal += glm::vec3(offset);
-							}
-						}
+						glm::ivec3 p = glm::ivec3(glm::floor(glm::vec3(inverse * glm::vec4(x + 0.5f, y + 0.5f, z + 0.5f, 1.0f))));
+						if (!gridFilled(grid, p))
+							continue;
+
+						GPUVoxel voxel = gridVoxel(grid, p);
+						voxel.position = glm::ivec3(x, y, z) - origin;
+						voxels.push_back(voxel);
 					}
+				}
+			}
+		}
 
-					voxel.normal = glm::normalize(voxel.normal);
+		if (voxels.size() == ground_count)
+			return ;
 
-					root->insert(voxel, 16);
-				}
+		// the sort keeps equal positions in order, the last one is kept
+		std::stable_sort(voxels.begin(), voxels.end(), [](const GPUVoxel &a, const GPUVoxel &b)
+		{
+			return (std::tie(a.position.z, a.position.y, a.position.x) < std::tie(b.position.z, b.position.y, b.position.x));
+		});
+		size_t kept = 0;
+		for (size_t i = 0; i < voxels.size(); i++)
+			if (i + 1 == voxels.size() || voxels[i + 1].position != voxels[i].position)
+				voxels[kept++] = voxels[i];
+		voxels.resize(kept);
+	});
+}
+
+// the world as chunk columns the streamer cuts into bricks one at a time
+// instead of a tree of the whole world, for vox files, scene files of vox
+// models and the bare ground, false for what only buildWorld reads, the
+// flat arrays get an empty world root so instance models still follow it
+bool	Scene::streamScene(std::string &name)
+{
+	RV_TRACE_SCOPE("Stream scene");
+
+	if (ImageImporter::isImage(name) || (!name.empty() && std::filesystem::is_directory(name))
+		|| VoxelImporter::isVoxelFile(name) || MeshModel::isMesh(name))
+		return (false);
+
+	SceneSetup setup;
+	std::shared_ptr<std::vector<ModelGrid>> grids = std::make_shared<std::vector<ModelGrid>>();
+
+	if (name.ends_with(".scene"))
+	{
+		std::vector<SceneFileEntry> models;
+		parseSceneFile(name, models, setup);
+		for (const SceneFileEntry &entry : models)
+		{
+			if (entry.resolution != 0)
+			{
+				std::cerr << "Streaming: " << name << " has meshes, the world is built whole" << std::endl;
+				return (false);
 			}
 		}
+
+		std::vector<ModelGrid> parsed(models.size());
+		std::vector<char> valid(models.size(), 0);
+		ThreadPool::shared().parallelFor(models.size(), [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				valid[i] = gridEntry(models[i], _voxel_size, parsed[i]);
+		});
+
+		for (size_t i = 0; i < models.size(); i++)
+		{
+			if (valid[i])
+				grids->push_back(std::move(parsed[i]));
+			else
+				std::cerr << "Failed to parse model " << models[i].path << std::endl;
+		}
+	}
+	else
+	{
+		std::string path = name;
+		VoxModel model = VoxModel(path);
+		if (model.isParsed())
+			grids->push_back(gridModel(model, glm::vec3(1.0f), glm::translate(glm::mat4(1.0f), glm::vec3(glm::ivec3(_world_dim / 2) + model.getMin()))));
+		else
+			std::cout << "Failed to parse vox model" << std::endl;
 	}
-	
-	root->flatten(flatNodes, flatVoxels);
 
-	std::cout << "Voxels inserted: " << count << " in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count() << "ms" << std::endl;
+	SVO root(glm::ivec3(0), glm::ivec3(_world_dim));
+	root.flatten(flatNodes, flatVoxels);
+	_stream_source = streamColumns(_world_dim, grids);
 
-	// for (int i = 0; i < flatNodes.size(); i++)
-	// {
-	// 	std::cout << "Node: " << i << std::endl;
-	// 	std::cout << "Min: " << flatNodes[i].min.x << " " << flatNodes[i].min.y << " " << flatNodes[i].min.z << std::endl;
-	// 	std::cout << "Max: " << flatNodes[i].max.x << " " << flatNodes[i].max.y << " " << flatNodes[i].max.z << std::endl;
-	// 	std::cout << "Child offset: " << flatNodes[i].childOffset << std::endl;
-	// 	std::cout << "Voxel index: " << flatNodes[i].voxelIndex << std::endl;
-	// 	std::cout << "Voxel count: " << flatNodes[i].voxelCount << std::endl;
-	// 	std::cout << "Child mask: " << (int)flatNodes[i].childMask << std::endl;
-	// 	for (int j = 0; j < flatNodes[i].voxelCount; j++)
-	// 	{
-	// 		std::cout << "Voxel: " << flatVoxels[flatNodes[i].voxelIndex + j].position.x << " " << flatVoxels[flatNodes[i].voxelIndex + j].position.y << " " << flatVoxels[flatNodes[i].voxelIndex + j].position.z << std::endl;
-	// 	}
-	// 	std::cout << std::endl;
-	// }
+	this->applySetup(setup);
+	return (true);
+}
+
+// on the main thread once the world is in flatNodes, instance models go
+// after it and the first camera preset is applied
+void		Scene::applySetup(const SceneSetup &setup)
+{
+	for (const GPUMaterial &material : setup.materials)
+		this->addMaterial(material);
+
+	for (const SceneFileEntry &entry : setup.instances)
+	{
+		int model_file = this->loadModel(entry.path);
+		if (model_file < 0)
+			continue ;
+		this->addInstance(model_file, Scene::instanceTransform(_model_files[model_file].size, entry.position / _voxel_size, entry.yaw, entry.scale));
+	}
 
-	// root->print(0);
-	voxel_data.clear();
+	_camera_presets.insert(_camera_presets.end(), setup.cameras.begin(), setup.cameras.end());
+	if (!setup.cameras.empty())
+		this->applyCameraPreset(_camera_presets.size() - setup.cameras.size());
+}
+
+// what --chunks carries the world on with, the ground when none is set
+void		Scene::setChunkSource(const ChunkSource &source)
+{
+	_chunk_source = source;
+}
+
+const ChunkSource	&Scene::getChunkSource(void) const
+{
+	return (_chunk_source);
+}
+
+const ChunkSource	&Scene::getStreamSource(void) const
+{
+	return (_stream_source);
+}
+
+const std::vector<CameraPreset>	&Scene::getCameraPresets(void) const
+{
+	return (_camera_presets);
+}
+
+void		Scene::applyCameraPreset(int index)
+{
+	const CameraPreset &preset = _camera_presets[index];
+
+	_camera->setPosition(preset.position);
+	_camera->setDirection(preset.pitch, preset.yaw);
+	_camera->storeGPUData();
 }
 
 void		Scene::addMaterial(GPUMaterial material)
@@ -223,14 +676,292 @@ GPUDebug	&Scene::getDebug(void)
 	return (_gpu_debug);
 }
 
+GPUDenoise	&Scene::getDenoise(void)
+{
+	return (_gpu_denoise);
+}
+
 Camera							*Scene::getCamera(void) const
 {
 	return (_camera);
 }
 
+int			Scene::getWorldDim(void) const
+{
+	return (_world_dim);
+}
+
+float		Scene::getVoxelSize(void) const
+{
+	return (_voxel_size);
+}
+
 GPUMaterial	Scene::getMaterial(int material_index)
 {
 	if (material_index < 0 || material_index >= (int)_gpu_materials.size())
 		throw std::runtime_error("Incorrect material index");
 	return (_gpu_materials[material_index]);
 }
+
+// every shape of the file gets its tree once, shapes the scene graph places
+// several times are shared, has to run after parseScene since the trees go
+// after the world in flatNodes/flatVoxels
+int		Scene::loadModel(const std::string &path)
+{
+	RV_TRACE_SCOPE("Load model");
+
+	for (size_t i = 0; i < _model_files.size(); i++)
+		if (_model_files[i].path == path)
+			return (i);
+
+	if (flatNodes.empty())
+	{
+		std::cerr << "Models need the world tree, parse the scene first" << std::endl;
+		return (-1);
+	}
+
+	std::string name = path;
+	VoxModel model = VoxModel(name);
+	if (!model.isParsed() || model.getInstances().empty())
+	{
+		std::cerr << "Failed to parse vox model " << path << std::endl;
+		return (-1);
+	}
+
+	SceneModelFile file;
+	file.path = path;
+	file.size = model.getSize();
+
+	std::map<std::vector<int>, int> built;
+	glm::mat4 to_origin = glm::translate(glm::mat4(1.0f), -glm::vec3(model.getMin()));
+	for (VoxInstance &instance : model.getInstances())
+	{
+		std::vector<int> chunks = instance.frames.empty() ? std::vector<int>{instance.chunk} : instance.frames;
+		if (!built.count(chunks))
+			built[chunks] = this->buildModel(model, path, chunks);
+
+		file.models.push_back(built[chunks]);
+		file.transforms.push_back(to_origin * instance.transform);
+	}
+
+	std::cout << "Model " << path << ": " << built.size() << " shapes placed " << file.models.size() << " times" << std::endl;
+
+	_model_files.push_back(file);
+	return (_model_files.size() - 1);
+}
+
+static void	appendKey(std::string &key, const void *data, size_t size)
+{
+	key.append(reinterpret_cast<const char *>(data), size);
+}
+
+// the fields only, the padding of the gpu structs is not initialized
+static void	appendKey(std::string &key, const FlatSVONode &node)
+{
+	int fields[] = {node.min.x, node.min.y, node.min.z, node.max.x, node.max.y, node.max.z, node.color,
+		node.childOffset, node.voxelIndex, node.voxelCount, node.childMask, node.normal};
+	appendKey(key, fields, sizeof(fields));
+}
+
+static void	appendKey(std::string &key, const GPUVoxel &voxel)
+{
+	appendKey(key, &voxel.normal[0], sizeof(glm::vec3));
+	appendKey(key, &voxel.position[0], sizeof(glm::ivec3));
+	appendKey(key, &voxel.color, sizeof(int));
+	appendKey(key, &voxel.light, sizeof(int));
+}
+
+// trees of one shape, a tree per frame, in its own grid and appended after
+// what is already in flatNodes/flatVoxels, children groups and leaf voxels
+// a previous frame already has are pointed to instead of copied
+int		Scene::buildModel(VoxModel &model, const std::string &path, const std::vector<int> &chunks)
+{
+	SceneModel entry;
+	entry.path = path;
+	entry.chunks = chunks;
+	entry.size = glm::ivec3(0);
+	entry.first_node = flatNodes.size();
+	entry.first_voxel = flatVoxels.size();
+
+	std::map<std::string, int> groups;
+	std::map<std::string, int> runs;
+	size_t unshared = 0;
+
+	for (int chunk_index : chunks)
+	{
+		VoxChunk &chunk = model.getChunks()[chunk_index];
+		glm::ivec3 size(chunk.width, chunk.height, chunk.depth);
+		entry.size = glm::max(entry.size, size);
+
+		auto filled = [&](glm::ivec3 p)
+		{
+			if (glm::any(glm::lessThan(p, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(p, size)))
+				return (false);
+			return (chunk.voxels[p.z][p.y][p.x].active);
+		};
+
+		int extent = 1;
+		while (extent < glm::max(size.x, glm::max(size.y, size.z)))
+			extent *= 2;
+
+		SVO *root = new SVO(glm::ivec3(0), glm::ivec3(extent));
+		for (int z = 0; z < size.z; ++z)
+		{
+			for (int y = 0; y < size.y; ++y)
+			{
+				for (int x = 0; x < size.x; ++x)
+				{
+					Voxel &cell = chunk.voxels[z][y][x];
+					if (!cell.active)
+						continue;
+
+					GPUVoxel voxel;
+					voxel.position = glm::ivec3(x, y, z);
+					voxel.color = model.getPalette()[cell.paletteIndex];
+					voxel.normal = voxelNormal(voxel.position, filled);
+					voxel.light = 0;
+					root->insert(voxel, 16);
+				}
+			}
+		}
+
+		std::vector<FlatSVONode> nodes;
+		std::vector<GPUVoxel> voxels;
+		root->flatten(nodes, voxels);
+		delete (root);
+		unshared += nodes.size();
+
+		// children come after their parent, so going backwards a group is
+		// always resolved to its final place before its parent looks it up
+		for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; i--)
+		{
+			FlatSVONode &node = nodes[i];
+			std::string key;
+
+			if (node.childOffset < 0)
+			{
+				if (node.voxelCount == 0)
+					continue ;
+
+				for (int v = 0; v < node.voxelCount; v++)
+					appendKey(key, voxels[node.voxelIndex + v]);
+
+				auto [it, added] = runs.try_emplace(key, flatVoxels.size());
+				if (added)
+					flatVoxels.insert(flatVoxels.end(), voxels.begin() + node.voxelIndex, voxels.begin() + node.voxelIndex + node.voxelCount);
+				node.voxelIndex = it->second;
+				continue ;
+			}
+
+			for (int c = 0; c < 8; c++)
+				appendKey(key, nodes[node.childOffset + c]);
+
+			auto [it, added] = groups.try_emplace(key, flatNodes.size());
+			if (added)
+				flatNodes.insert(flatNodes.end(), nodes.begin() + node.childOffset, nodes.begin() + node.childOffset + 8);
+			node.childOffset = it->second;
+		}
+
+		entry.frame_roots.push_back(flatNodes.size());
+		flatNodes.push_back(nodes[0]);
+	}
+
+	entry.root = entry.frame_roots[0];
+	entry.node_count = flatNodes.size() - entry.first_node;
+	entry.voxel_count = flatVoxels.size() - entry.first_voxel;
+
+	if (chunks.size() > 1)
+		std::cout << "Animated shape: " << chunks.size() << " frames in " << entry.node_count << " nodes, "
+			<< unshared << " without sharing" << std::endl;
+
+	_models.push_back(entry);
+	return (_models.size() - 1);
+}
+
+// one instance per placed shape of the file, returns the first of them
+int		Scene::addInstance(int file, const glm::mat4 &transform)
+{
+	int first = _instances.size();
+
+	for (size_t i = 0; i < _model_files[file].models.size(); i++)
+		_instances.push_back(SceneInstance{_model_files[file].models[i], transform * _model_files[file].transforms[i]});
+	_instances_added = true;
+	return (first);
+}
+
+// an empty model with room for node_count nodes and voxel_count voxels
+// after the arrays, for trees that are written later in place
+int		Scene::reserveModel(glm::ivec3 size, int node_count, int voxel_count)
+{
+	SceneModel entry;
+	entry.size = size;
+	entry.first_node = flatNodes.size();
+	entry.first_voxel = flatVoxels.size();
+	entry.node_count = node_count;
+	entry.voxel_count = voxel_count;
+	entry.root = entry.first_node;
+	entry.frame_roots.push_back(entry.root);
+
+	flatNodes.resize(flatNodes.size() + node_count, FlatSVONode{});
+	flatVoxels.resize(flatVoxels.size() + voxel_count, GPUVoxel{});
+
+	FlatSVONode &root = flatNodes[entry.root];
+	root.max = size;
+	root.childOffset = -1;
+	root.voxelIndex = -1;
+
+	_models.push_back(entry);
+	return (_models.size() - 1);
+}
+
+int		Scene::addModelInstance(int model, const glm::mat4 &transform)
+{
+	_instances.push_back(SceneInstance{model, transform});
+	_instances_added = true;
+	return (_instances.size() - 1);
+}
+
+// only the top level has to follow, the model tree is untouched, rebuild
+// is for jumps far enough that refitting the old top level would be poor
+void	Scene::setInstanceTransform(int instance, const glm::mat4 &transform, bool rebuild)
+{
+	_instances[instance].transform = transform;
+	_instances_moved = true;
+	_instances_added |= rebuild;
+}
+
+// true when something changed since the last call, added tells if the top
+// level has to be rebuilt rather than refitted
+bool	Scene::consumeInstanceChanges(bool &added)
+{
+	bool changed = _instances_added || _instances_moved;
+
+	added = _instances_added;
+	_instances_added = false;
+	_instances_moved = false;
+	return (changed);
+}
+
+std::vector<SceneModel>		&Scene::getModels(void)
+{
+	return (_models);
+}
+
+const std::vector<SceneModelFile>	&Scene::getModelFiles(void) const
+{
+	return (_model_files);
+}
+
+const std::vector<SceneInstance>	&Scene::getInstances(void) const
+{
+	return (_instances);
+}
+
+// position is where the model center lands in world voxels, yaw in degrees
+glm::mat4	Scene::instanceTransform(glm::ivec3 size, glm::vec3 position, float yaw, float scale)
+{
+	glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+	transform = glm::rotate(transform, glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+	transform = glm::scale(transform, glm::vec3(scale));
+	return (glm::translate(transform, -glm::vec3(size) * 0.5f));
+}
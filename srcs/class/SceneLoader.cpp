@@ -0,0 +1,260 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SceneLoader.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 14:06:42 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 14:06:42 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "SceneLoader.hpp"
+
+// the skeleton is the tree of an empty world cut two levels down, the
+// bricks are its nodes LOADER_FIRST_BRICK onward in the order of SVO::subdivide
+SceneLoader::SceneLoader(Scene &scene, const std::string &name, const std::vector<std::string> &instances)
+	: _scene(scene), _name(name), _instances(instances), _built(false), _cancel(false)
+{
+	_setup = new SceneSetup();
+
+	SVO skeleton(glm::ivec3(0), glm::ivec3(_scene.getWorldDim()));
+	skeleton.subdivide();
+	for (int i = 0; i < 8; i++)
+		skeleton.getChild(i)->subdivide();
+
+	_scene.flatNodes.clear();
+	_scene.flatVoxels.clear();
+	skeleton.flatten(_scene.flatNodes, _scene.flatVoxels);
+
+	_node_end = _scene.flatNodes.size();
+	_voxel_end = 0;
+	_scene.flatNodes.resize(LOADER_FRAME_NODES);
+	_scene.flatVoxels.resize(LOADER_FRAME_NODES);
+
+	glm::vec3 focus = _scene.getCamera()->getPosition() / _scene.getVoxelSize();
+	for (int i = 0; i < LOADER_BRICKS; i++)
+		_order.push_back(LOADER_FIRST_BRICK + i);
+	std::sort(_order.begin(), _order.end(), [this, &focus](int a, int b)
+	{
+		const FlatSVONode &node_a = _scene.flatNodes[a];
+		const FlatSVONode &node_b = _scene.flatNodes[b];
+		return (glm::distance(glm::vec3(node_a.min + node_a.max) * 0.5f, focus) < glm::distance(glm::vec3(node_b.min + node_b.max) * 0.5f, focus));
+	});
+
+	_spliced = 0;
+	_changed = false;
+	_done = false;
+	_stopped = false;
+	_first_brick_ms = 0.0f;
+	_load_ms = 0.0f;
+	_start = std::chrono::high_resolution_clock::now();
+
+	_thread = std::thread(&SceneLoader::build, this);
+}
+
+SceneLoader::~SceneLoader()
+{
+	_cancel = true;
+	if (_thread.joinable())
+		_thread.join();
+	delete (_setup);
+}
+
+// loader thread, only touches the tree and the ready queue
+void			SceneLoader::build()
+{
+	TraceRecorder::setThreadName("Scene loader");
+
+	SVO *root = _scene.buildWorld(_name, *_setup);
+	if (root->isLeaf())
+		root->subdivide();
+	for (int i = 0; i < 8; i++)
+	{
+		if (root->getChild(i)->isLeaf())
+			root->getChild(i)->subdivide();
+	}
+
+	// ranges are taken in order so the nearest bricks still come first,
+	// this thread flattens too and only waits for these bricks
+	ThreadPool::shared().parallelFor(_order.size(), [this, root](int begin, int end)
+	{
+		for (int i = begin; i < end && !_cancel; i++)
+		{
+			RV_TRACE_SCOPE("Flatten brick");
+
+			int brick_index = _order[i] - LOADER_FIRST_BRICK;
+			LoaderBrick brick;
+			brick.slot = _order[i];
+			root->getChild(brick_index / 8)->getChild(brick_index % 8)->flatten(brick.nodes, brick.voxels);
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			_ready.push(std::move(brick));
+		}
+	});
+
+	delete (root);
+	_built = true;
+}
+
+// brick nodes after the first go behind the arrays, its root replaces the
+// empty brick node, the arrays double when they are full so the number of
+// full uploads stays logarithmic, returns true when they grew
+bool			SceneLoader::splice(const LoaderBrick &brick)
+{
+	std::vector<FlatSVONode> &nodes = _scene.flatNodes;
+	std::vector<GPUVoxel> &voxels = _scene.flatVoxels;
+	size_t node_count = brick.nodes.size() - 1;
+	bool grown = false;
+
+	if (_node_end + node_count > nodes.size())
+	{
+		nodes.resize(std::max(_node_end + node_count, nodes.size() * 2));
+		grown = true;
+	}
+	if (_voxel_end + brick.voxels.size() > voxels.size())
+	{
+		voxels.resize(std::max(_voxel_end + brick.voxels.size(), voxels.size() * 2));
+		grown = true;
+	}
+
+	int node_shift = static_cast<int>(_node_end) - 1;
+	int voxel_shift = static_cast<int>(_voxel_end);
+	auto relocate = [node_shift, voxel_shift](FlatSVONode node)
+	{
+		if (node.childOffset >= 0)
+			node.childOffset += node_shift;
+		if (node.voxelIndex >= 0)
+			node.voxelIndex += voxel_shift;
+		return (node);
+	};
+
+	nodes[brick.slot] = relocate(brick.nodes[0]);
+	for (size_t i = 1; i < brick.nodes.size(); i++)
+		nodes[_node_end + i - 1] = relocate(brick.nodes[i]);
+	std::copy(brick.voxels.begin(), brick.voxels.end(), voxels.begin() + _voxel_end);
+
+	_node_end += node_count;
+	_voxel_end += brick.voxels.size();
+
+	int brick_index = brick.slot - LOADER_FIRST_BRICK;
+	int parent = brick_index / 8 + 1;
+	if (brick.nodes[0].childMask != 0 || brick.nodes[0].voxelCount > 0)
+	{
+		nodes[parent].childMask |= 1 << (brick_index % 8);
+		nodes[0].childMask |= 1 << (parent - 1);
+	}
+	SVO::aggregate(nodes, voxels, parent);
+	SVO::aggregate(nodes, voxels, 0);
+
+	_spliced++;
+	return (grown);
+}
+
+// on the main thread every frame, returns false when the arrays grew and
+// have to be uploaded whole, once isDone() they are final and the caller
+// uploads them whole anyway
+bool			SceneLoader::update(PagedBuffer &nodes, PagedBuffer &voxels)
+{
+	if (_done || _stopped)
+		return (true);
+
+	RV_TRACE_SCOPE("Splice bricks");
+
+	std::vector<LoaderBrick> bricks;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		size_t budget = 0;
+		while (!_ready.empty() && (bricks.empty() || budget + _ready.front().nodes.size() <= LOADER_FRAME_NODES))
+		{
+			budget += _ready.front().nodes.size();
+			bricks.push_back(std::move(_ready.front()));
+			_ready.pop();
+		}
+	}
+
+	size_t first_node = _node_end;
+	size_t first_voxel = _voxel_end;
+	bool grown = false;
+
+	for (const LoaderBrick &brick : bricks)
+		grown |= this->splice(brick);
+
+	if (!bricks.empty())
+	{
+		_changed = true;
+		if (_spliced == static_cast<int>(bricks.size()))
+			_first_brick_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - _start).count();
+	}
+
+	if (_spliced == LOADER_BRICKS && _built)
+	{
+		this->finish();
+		return (true);
+	}
+	if (grown)
+		return (false);
+	if (bricks.empty())
+		return (true);
+
+	nodes.updateRange(_scene.flatNodes.data(), 0, LOADER_FIRST_BRICK + LOADER_BRICKS);
+	if (_node_end > first_node)
+		nodes.updateRange(&_scene.flatNodes[first_node], first_node, _node_end - first_node);
+	if (_voxel_end > first_voxel)
+		voxels.updateRange(&_scene.flatVoxels[first_voxel], first_voxel, _voxel_end - first_voxel);
+	return (true);
+}
+
+void			SceneLoader::finish()
+{
+	_thread.join();
+
+	_scene.flatNodes.resize(_node_end);
+	_scene.flatVoxels.resize(_voxel_end);
+	_scene.applySetup(*_setup);
+	addInstances(_scene, _instances);
+
+	_load_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - _start).count();
+	std::cout << "Loaded " << _name << ": first brick after " << _first_brick_ms << "ms, all "
+		<< LOADER_BRICKS << " after " << _load_ms << "ms" << std::endl;
+	_done = true;
+}
+
+// true once after bricks came in, accumulated frames are stale then
+bool			SceneLoader::consumeChanges()
+{
+	bool changed = _changed;
+
+	_changed = false;
+	return (changed);
+}
+
+bool			SceneLoader::isDone() const
+{
+	return (_done);
+}
+
+// the arrays outgrew the gpu pages, the frames keep what was uploaded
+// before and no more bricks come in
+void			SceneLoader::stop()
+{
+	_stopped = true;
+	_cancel = true;
+}
+
+void			SceneLoader::imGuiRender()
+{
+	if (!ImGui::CollapsingHeader("Loading", ImGuiTreeNodeFlags_DefaultOpen))
+		return ;
+
+	if (_stopped)
+		ImGui::Text("Stopped, the scene does not fit in the GPU pages");
+	else
+		ImGui::Text("%s", _built ? "Uploading bricks" : "Building the world tree");
+	ImGui::ProgressBar(static_cast<float>(_spliced) / LOADER_BRICKS);
+	if (_spliced > 0)
+		ImGui::Text("First brick after %.0f ms", _first_brick_ms);
+	ImGui::TextDisabled("%s", _name.c_str());
+}
@@ -0,0 +1,382 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TLAS.cpp                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 13:18:49 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 13:18:49 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "TLAS.hpp"
+
+// world box of the model grid [0, size] under the instance transform
+static void	instanceBounds(const SceneModel &model, const SceneInstance &instance, glm::vec3 &min, glm::vec3 &max)
+{
+	min = glm::vec3(1e30f);
+	max = glm::vec3(-1e30f);
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 local = glm::vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * glm::vec3(model.size);
+		glm::vec3 world = glm::vec3(instance.transform * glm::vec4(local, 1.0f));
+		min = glm::min(min, world);
+		max = glm::max(max, world);
+	}
+}
+
+TLAS::TLAS()
+{
+	_node_buffer = nullptr;
+	_instance_buffer = nullptr;
+	_node_capacity = 0;
+	_instance_capacity = 0;
+	_build_time = 0.0f;
+	_frame = 0;
+}
+
+TLAS::~TLAS()
+{
+	delete (_node_buffer);
+	delete (_instance_buffer);
+}
+
+// rebuilt when instances were added, refitted when they only moved
+void		TLAS::update(Scene &scene)
+{
+	bool added;
+	if (!scene.consumeInstanceChanges(added) && _node_buffer)
+		return ;
+
+	RV_TRACE_SCOPE("TLAS update");
+
+	const std::vector<SceneInstance> &instances = scene.getInstances();
+	std::vector<glm::vec3> mins(instances.size());
+	std::vector<glm::vec3> maxs(instances.size());
+
+	for (size_t i = 0; i < instances.size(); i++)
+		instanceBounds(scene.getModels()[instances[i].model], instances[i], mins[i], maxs[i]);
+
+	if (added || _order.size() != instances.size())
+		this->build(mins, maxs);
+	else
+		this->refit(mins, maxs);
+
+	this->upload(scene);
+}
+
+// (slot, root) of every animated instance, only the roots that change move
+void		TLAS::animate(Scene &scene, float time)
+{
+	int frame = std::max(0, static_cast<int>(time * ANIMATION_FPS));
+	if (frame == _frame || _animated.empty())
+		return ;
+	_frame = frame;
+
+	const std::vector<SceneInstance> &instances = scene.getInstances();
+	for (std::pair<int, int> &animated : _animated)
+	{
+		const std::vector<int> &roots = scene.getModels()[instances[_order[animated.first]].model].frame_roots;
+		int root = roots[frame % roots.size()];
+		if (root == animated.second)
+			continue ;
+
+		animated.second = root;
+		_instance_buffer->updateRange(&root, animated.first * sizeof(GPUInstance) + offsetof(GPUInstance, root), sizeof(int));
+	}
+}
+
+void		TLAS::setUniforms(ShaderProgram &program) const
+{
+	program.set_int("u_instanceCount", _order.size());
+}
+
+static float	halfArea(glm::vec3 min, glm::vec3 max)
+{
+	glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+
+	return (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// sets the node bounds and splits its range in two children pushed as a
+// pair, false when it stays a leaf, only touches its own part of order
+static bool	splitNode(std::vector<GPUTLASNode> &nodes, int index, int depth, std::vector<int> &order,
+	const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs, const std::vector<glm::vec3> &centroids)
+{
+	int first = nodes[index].left_first;
+	int count = nodes[index].count;
+
+	glm::vec3 box_min(1e30f);
+	glm::vec3 box_max(-1e30f);
+	glm::vec3 low(1e30f);
+	glm::vec3 high(-1e30f);
+	for (int i = first; i < first + count; i++)
+	{
+		box_min = glm::min(box_min, mins[order[i]]);
+		box_max = glm::max(box_max, maxs[order[i]]);
+		low = glm::min(low, centroids[order[i]]);
+		high = glm::max(high, centroids[order[i]]);
+	}
+	nodes[index].min = box_min;
+	nodes[index].max = box_max;
+
+	if (count <= TLAS_LEAF_SIZE || depth >= TLAS_MAX_DEPTH)
+		return (false);
+
+	glm::vec3 extent = high - low;
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	int half = count / 2;
+
+	if (extent[axis] > 0.0f)
+	{
+		int bin_count[TLAS_BINS] = {};
+		glm::vec3 bin_min[TLAS_BINS];
+		glm::vec3 bin_max[TLAS_BINS];
+		std::fill(bin_min, bin_min + TLAS_BINS, glm::vec3(1e30f));
+		std::fill(bin_max, bin_max + TLAS_BINS, glm::vec3(-1e30f));
+
+		float scale = TLAS_BINS / extent[axis];
+		auto binOf = [&](int instance)
+		{
+			return (std::min(TLAS_BINS - 1, static_cast<int>((centroids[instance][axis] - low[axis]) * scale)));
+		};
+
+		for (int i = first; i < first + count; i++)
+		{
+			int bin = binOf(order[i]);
+			bin_count[bin]++;
+			bin_min[bin] = glm::min(bin_min[bin], mins[order[i]]);
+			bin_max[bin] = glm::max(bin_max[bin], maxs[order[i]]);
+		}
+
+		// right side costs swept from the end, then the left side from the start
+		float right_cost[TLAS_BINS];
+		glm::vec3 sweep_min(1e30f);
+		glm::vec3 sweep_max(-1e30f);
+		int sweep_count = 0;
+		for (int bin = TLAS_BINS - 1; bin > 0; bin--)
+		{
+			sweep_min = glm::min(sweep_min, bin_min[bin]);
+			sweep_max = glm::max(sweep_max, bin_max[bin]);
+			sweep_count += bin_count[bin];
+			right_cost[bin] = sweep_count ? sweep_count * halfArea(sweep_min, sweep_max) : 0.0f;
+		}
+
+		float best_cost = 1e30f;
+		int best_split = -1;
+		sweep_min = glm::vec3(1e30f);
+		sweep_max = glm::vec3(-1e30f);
+		sweep_count = 0;
+		for (int bin = 0; bin < TLAS_BINS - 1; bin++)
+		{
+			sweep_min = glm::min(sweep_min, bin_min[bin]);
+			sweep_max = glm::max(sweep_max, bin_max[bin]);
+			sweep_count += bin_count[bin];
+			if (sweep_count == 0 || sweep_count == count)
+				continue ;
+
+			float cost = sweep_count * halfArea(sweep_min, sweep_max) + right_cost[bin + 1];
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				best_split = bin;
+			}
+		}
+
+		if (best_split < 0 || (best_cost >= count * halfArea(box_min, box_max) && count <= TLAS_MAX_LEAF))
+			return (false);
+
+		half = std::partition(order.begin() + first, order.begin() + first + count,
+			[&](int instance) { return (binOf(instance) <= best_split); }) - (order.begin() + first);
+	}
+	else
+	{
+		// every centroid in one point, halves only keep the leaves small
+		std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count);
+	}
+
+	int left = nodes.size();
+	nodes.push_back(GPUTLASNode{glm::vec3(0.0f), first, glm::vec3(0.0f), half});
+	nodes.push_back(GPUTLASNode{glm::vec3(0.0f), first + half, glm::vec3(0.0f), count - half});
+
+	nodes[index].left_first = left;
+	nodes[index].count = 0;
+	return (true);
+}
+
+// children are pushed as a pair so a node only needs the index of the left
+// one, ranges small enough become tasks built in a local array and spliced
+// back after the nodes of this thread, so children still follow parents
+void		TLAS::build(const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	_order.resize(mins.size());
+	for (size_t i = 0; i < _order.size(); i++)
+		_order[i] = i;
+
+	_nodes.clear();
+	if (_order.empty())
+		return ;
+
+	ThreadPool &pool = ThreadPool::shared();
+	std::vector<glm::vec3> centroids(mins.size());
+	pool.parallelFor(mins.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			centroids[i] = (mins[i] + maxs[i]) * 0.5f;
+	});
+
+	int task_size = std::max(TLAS_TASK_MIN, static_cast<int>(_order.size()) / (pool.getThreadCount() * 4));
+	std::vector<std::pair<int, int>> tasks;
+
+	_nodes.push_back(GPUTLASNode{glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<int>(_order.size())});
+
+	std::vector<std::pair<int, int>> stack = {{0, 0}};
+	while (!stack.empty())
+	{
+		auto [index, depth] = stack.back();
+		stack.pop_back();
+
+		if (_nodes[index].count <= task_size)
+		{
+			tasks.push_back({index, depth});
+			continue ;
+		}
+		if (splitNode(_nodes, index, depth, _order, mins, maxs, centroids))
+		{
+			stack.push_back({_nodes[index].left_first, depth + 1});
+			stack.push_back({_nodes[index].left_first + 1, depth + 1});
+		}
+	}
+
+	std::vector<std::vector<GPUTLASNode>> subtrees(tasks.size());
+	pool.parallelFor(tasks.size(), [&](int begin, int end)
+	{
+		for (int t = begin; t < end; t++)
+		{
+			std::vector<GPUTLASNode> &local = subtrees[t];
+			local.push_back(_nodes[tasks[t].first]);
+
+			std::vector<std::pair<int, int>> local_stack = {{0, tasks[t].second}};
+			while (!local_stack.empty())
+			{
+				auto [index, depth] = local_stack.back();
+				local_stack.pop_back();
+
+				if (splitNode(local, index, depth, _order, mins, maxs, centroids))
+				{
+					local_stack.push_back({local[index].left_first, depth + 1});
+					local_stack.push_back({local[index].left_first + 1, depth + 1});
+				}
+			}
+		}
+	});
+
+	// local 0 takes the place of the task node, the rest is appended
+	for (size_t t = 0; t < tasks.size(); t++)
+	{
+		std::vector<GPUTLASNode> &local = subtrees[t];
+		int base = static_cast<int>(_nodes.size()) - 1;
+
+		for (GPUTLASNode &node : local)
+			if (node.count == 0)
+				node.left_first += base;
+
+		_nodes[tasks[t].first] = local[0];
+		_nodes.insert(_nodes.end(), local.begin() + 1, local.end());
+	}
+
+	_build_time = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// children always come after their parent, so one reverse pass is enough
+void		TLAS::refit(const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs)
+{
+	for (int i = static_cast<int>(_nodes.size()) - 1; i >= 0; i--)
+	{
+		GPUTLASNode &node = _nodes[i];
+
+		if (node.count > 0)
+		{
+			node.min = glm::vec3(1e30f);
+			node.max = glm::vec3(-1e30f);
+			for (int j = node.left_first; j < node.left_first + node.count; j++)
+			{
+				node.min = glm::min(node.min, mins[_order[j]]);
+				node.max = glm::max(node.max, maxs[_order[j]]);
+			}
+			continue ;
+		}
+
+		node.min = glm::min(_nodes[node.left_first].min, _nodes[node.left_first + 1].min);
+		node.max = glm::max(_nodes[node.left_first].max, _nodes[node.left_first + 1].max);
+	}
+}
+
+// instances go up in leaf order so a leaf reads a contiguous range, the
+// buffers are only recreated when they have to grow
+void		TLAS::upload(Scene &scene)
+{
+	const std::vector<SceneInstance> &instances = scene.getInstances();
+
+	std::vector<GPUInstance> gpu_instances(_order.size());
+	ThreadPool::shared().parallelFor(_order.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			const SceneInstance &instance = instances[_order[i]];
+
+			gpu_instances[i].model_to_world = instance.transform;
+			gpu_instances[i].world_to_model = glm::inverse(instance.transform);
+			const std::vector<int> &roots = scene.getModels()[instance.model].frame_roots;
+			gpu_instances[i].root = roots[_frame % roots.size()];
+		}
+	});
+
+	_animated.clear();
+	for (size_t i = 0; i < gpu_instances.size(); i++)
+		if (scene.getModels()[instances[_order[i]].model].frame_roots.size() > 1)
+			_animated.push_back({i, gpu_instances[i].root});
+
+	std::vector<GPUTLASNode> nodes = _nodes;
+	if (nodes.empty())
+		nodes.push_back(GPUTLASNode{});
+	if (gpu_instances.empty())
+		gpu_instances.push_back(GPUInstance{});
+
+	if (nodes.size() > _node_capacity)
+	{
+		delete (_node_buffer);
+		_node_capacity = nodes.size();
+		_node_buffer = new Buffer(Buffer::Type::SSBO, TLAS_NODE_BINDING, _node_capacity * sizeof(GPUTLASNode), nodes.data());
+	}
+	else
+		_node_buffer->update(nodes.data(), nodes.size() * sizeof(GPUTLASNode));
+
+	if (gpu_instances.size() > _instance_capacity)
+	{
+		delete (_instance_buffer);
+		_instance_capacity = gpu_instances.size();
+		_instance_buffer = new Buffer(Buffer::Type::SSBO, INSTANCE_BINDING, _instance_capacity * sizeof(GPUInstance), gpu_instances.data());
+	}
+	else
+		_instance_buffer->update(gpu_instances.data(), gpu_instances.size() * sizeof(GPUInstance));
+}
+
+int			TLAS::getInstanceCount() const
+{
+	return (_order.size());
+}
+
+int			TLAS::getNodeCount() const
+{
+	return (_nodes.size());
+}
+
+float		TLAS::getBuildTime() const
+{
+	return (_build_time);
+}
@@ -0,0 +1,319 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TerrainGenerator.cpp                               :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 16:21:37 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 16:21:37 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "TerrainGenerator.hpp"
+
+#include <bit>
+
+// gcc and clang vector extensions, NOISE_LANES points go through every
+// operation at once without tying the code to one instruction set
+typedef float		LaneFloat __attribute__((vector_size(NOISE_LANES * sizeof(float))));
+typedef int32_t		LaneInt __attribute__((vector_size(NOISE_LANES * sizeof(int32_t))));
+typedef uint32_t	LaneUint __attribute__((vector_size(NOISE_LANES * sizeof(uint32_t))));
+
+static inline LaneInt	laneFloor(LaneFloat x)
+{
+	LaneInt i = __builtin_convertvector(x, LaneInt);
+
+	// truncation rounds negatives up, the mask is -1 where it did
+	return (i + (x < __builtin_convertvector(i, LaneFloat)));
+}
+
+static inline LaneFloat	laneFade(LaneFloat t)
+{
+	return (t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f));
+}
+
+static inline LaneUint	laneHash(LaneInt x, LaneInt y, LaneInt z, uint32_t seed)
+{
+	LaneUint h = (LaneUint)x * 0x8da6b343u ^ (LaneUint)y * 0xd8163841u ^ (LaneUint)z * 0xcb1ab31fu ^ seed;
+
+	h ^= h >> 13;
+	h *= 0x5bd1e995u;
+	h ^= h >> 15;
+	return (h);
+}
+
+// one of the diagonal gradients picked by the hash bits, dotted with the offset
+static inline LaneFloat	laneGradient(LaneUint h, LaneFloat x, LaneFloat y, LaneFloat z)
+{
+	LaneFloat gx = __builtin_convertvector((LaneInt)(h & 1u), LaneFloat) * 2.0f - 1.0f;
+	LaneFloat gy = __builtin_convertvector((LaneInt)((h >> 1) & 1u), LaneFloat) * 2.0f - 1.0f;
+	LaneFloat gz = __builtin_convertvector((LaneInt)((h >> 2) & 1u), LaneFloat) * 2.0f - 1.0f;
+
+	return (gx * x + gy * y + gz * z);
+}
+
+// gradient noise in about [-1, 1], 2d when y is zero everywhere
+static LaneFloat		laneNoise(LaneFloat x, LaneFloat y, LaneFloat z, uint32_t seed)
+{
+	LaneInt ix = laneFloor(x);
+	LaneInt iy = laneFloor(y);
+	LaneInt iz = laneFloor(z);
+	LaneFloat fx = x - __builtin_convertvector(ix, LaneFloat);
+	LaneFloat fy = y - __builtin_convertvector(iy, LaneFloat);
+	LaneFloat fz = z - __builtin_convertvector(iz, LaneFloat);
+	LaneFloat u = laneFade(fx);
+	LaneFloat v = laneFade(fy);
+	LaneFloat w = laneFade(fz);
+
+	LaneFloat corners[8];
+	for (int c = 0; c < 8; c++)
+	{
+		int ox = c & 1;
+		int oy = (c >> 1) & 1;
+		int oz = (c >> 2) & 1;
+		corners[c] = laneGradient(laneHash(ix + ox, iy + oy, iz + oz, seed),
+			fx - static_cast<float>(ox), fy - static_cast<float>(oy), fz - static_cast<float>(oz));
+	}
+
+	LaneFloat x00 = corners[0] + u * (corners[1] - corners[0]);
+	LaneFloat x10 = corners[2] + u * (corners[3] - corners[2]);
+	LaneFloat x01 = corners[4] + u * (corners[5] - corners[4]);
+	LaneFloat x11 = corners[6] + u * (corners[7] - corners[6]);
+	LaneFloat y0 = x00 + v * (x10 - x00);
+	LaneFloat y1 = x01 + v * (x11 - x01);
+	return ((y0 + w * (y1 - y0)) * 0.6f);
+}
+
+static LaneFloat		laneFbm(LaneFloat x, LaneFloat y, LaneFloat z, int octaves, uint32_t seed)
+{
+	LaneFloat sum = {};
+	float amplitude = 0.5f;
+	float total = 0.0f;
+
+	for (int o = 0; o < octaves; o++)
+	{
+		sum += laneNoise(x, y, z, seed + o * 0x9e3779b9u) * amplitude;
+		total += amplitude;
+		x *= 2.0f;
+		y *= 2.0f;
+		z *= 2.0f;
+		amplitude *= 0.5f;
+	}
+	return (sum / total);
+}
+
+// fn(lane x, lane y, lane z) for every point of the lists, written to out,
+// the last lanes past count are padded and dropped
+template <typename Function>
+static void				forLanes(const std::vector<glm::vec3> &points, std::vector<float> &out, Function fn)
+{
+	out.resize(points.size());
+	for (size_t i = 0; i < points.size(); i += NOISE_LANES)
+	{
+		LaneFloat x = {};
+		LaneFloat y = {};
+		LaneFloat z = {};
+		size_t count = std::min<size_t>(NOISE_LANES, points.size() - i);
+
+		for (size_t l = 0; l < count; l++)
+		{
+			x[l] = points[i + l].x;
+			y[l] = points[i + l].y;
+			z[l] = points[i + l].z;
+		}
+
+		LaneFloat result = fn(x, y, z);
+		for (size_t l = 0; l < count; l++)
+			out[i + l] = result[l];
+	}
+}
+
+TerrainGenerator::TerrainGenerator(uint32_t seed) : _seed(seed)
+{
+}
+
+// side² columns from origin, heights in voxels, the biome fields in [-1, 1]
+void		TerrainGenerator::columns(glm::ivec2 origin, int side, std::vector<int> &heights, std::vector<float> &temperature, std::vector<float> &moisture) const
+{
+	std::vector<glm::vec3> points(side * side);
+	for (int z = 0; z < side; z++)
+		for (int x = 0; x < side; x++)
+			points[x + z * side] = glm::vec3(origin.x + x, 0.0f, origin.y + z);
+
+	uint32_t seed = _seed;
+	std::vector<float> height;
+	forLanes(points, height, [seed](LaneFloat x, LaneFloat, LaneFloat z)
+	{
+		LaneFloat zero = {};
+		LaneFloat continent = laneFbm(x / 512.0f, zero, z / 512.0f, 3, seed);
+		LaneFloat detail = laneFbm(x / 96.0f, zero, z / 96.0f, 5, seed + 1);
+		LaneFloat ridge = laneNoise(x / 160.0f, zero, z / 160.0f, seed + 2);
+
+		// ridges only rise where the continent is already high
+		ridge = 1.0f - (ridge < 0.0f ? -ridge : ridge);
+		LaneFloat mountains = (continent > 0.0f ? continent : zero) * ridge * ridge;
+		return (16.0f + continent * 12.0f + detail * 8.0f + mountains * 48.0f);
+	});
+	forLanes(points, temperature, [seed](LaneFloat x, LaneFloat, LaneFloat z)
+	{
+		LaneFloat zero = {};
+		return (laneFbm(x / 700.0f, zero, z / 700.0f, 2, seed + 3));
+	});
+	forLanes(points, moisture, [seed](LaneFloat x, LaneFloat, LaneFloat z)
+	{
+		LaneFloat zero = {};
+		return (laneFbm(x / 500.0f, zero, z / 500.0f, 2, seed + 4));
+	});
+
+	heights.resize(points.size());
+	for (size_t i = 0; i < points.size(); i++)
+		heights[i] = std::clamp(static_cast<int>(height[i]), 2, TERRAIN_HEIGHT - 2);
+}
+
+// the cave field on a CAVE_STEP lattice covering the chunk and one cell
+// around it, x and z have a lattice point more on each side
+void		TerrainGenerator::caves(glm::ivec3 origin, std::vector<float> &density) const
+{
+	int side = CHUNK_DIM / CAVE_STEP + 3;
+	int layers = TERRAIN_HEIGHT / CAVE_STEP + 1;
+	std::vector<glm::vec3> points;
+
+	points.reserve(side * side * layers);
+	for (int y = 0; y < layers; y++)
+		for (int z = 0; z < side; z++)
+			for (int x = 0; x < side; x++)
+				points.push_back(glm::vec3(origin + glm::ivec3(x - 1, y, z - 1) * CAVE_STEP));
+
+	uint32_t seed = _seed + 5;
+	forLanes(points, density, [seed](LaneFloat x, LaneFloat y, LaneFloat z)
+	{
+		return (laneFbm(x / 40.0f, y / 24.0f, z / 40.0f, 2, seed));
+	});
+}
+
+// one chunk, only cells with an empty neighbour are kept: every column of
+// the chunk and its border is a bit mask of solid cells, the cells hidden
+// on all six sides drop out with a few ands
+void		TerrainGenerator::generate(glm::ivec3 origin, std::vector<GPUVoxel> &voxels) const
+{
+	RV_TRACE_SCOPE("Terrain");
+
+	static_assert(TERRAIN_HEIGHT <= 64, "a column is one 64 bit mask");
+
+	int side = CHUNK_DIM + 2;
+	std::vector<int> heights;
+	std::vector<float> temperature;
+	std::vector<float> moisture;
+	std::vector<float> density;
+
+	this->columns(glm::ivec2(origin.x, origin.z) - 1, side, heights, temperature, moisture);
+	this->caves(origin, density);
+
+	int lattice = CHUNK_DIM / CAVE_STEP + 3;
+	auto cave = [&](int x, int y, int z)
+	{
+		glm::vec3 p = glm::vec3(x + CAVE_STEP, y, z + CAVE_STEP) / static_cast<float>(CAVE_STEP);
+		glm::ivec3 i = glm::min(glm::ivec3(p), glm::ivec3(lattice - 2, TERRAIN_HEIGHT / CAVE_STEP - 1, lattice - 2));
+		glm::vec3 f = p - glm::vec3(i);
+		auto at = [&](int dx, int dy, int dz) { return (density[(i.x + dx) + lattice * ((i.z + dz) + lattice * (i.y + dy))]); };
+
+		float x00 = glm::mix(at(0, 0, 0), at(1, 0, 0), f.x);
+		float x10 = glm::mix(at(0, 1, 0), at(1, 1, 0), f.x);
+		float x01 = glm::mix(at(0, 0, 1), at(1, 0, 1), f.x);
+		float x11 = glm::mix(at(0, 1, 1), at(1, 1, 1), f.x);
+		return (glm::mix(glm::mix(x00, x10, f.y), glm::mix(x01, x11, f.y), f.z));
+	};
+
+	// bedrock at y 0 and 1 is never carved
+	std::vector<uint64_t> masks(side * side, 0);
+	for (int z = 0; z < side; z++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			uint64_t &mask = masks[x + z * side];
+			int height = heights[x + z * side];
+
+			for (int y = 0; y < height; y++)
+				if (y < 2 || cave(x - 1, y, z - 1) < CAVE_THRESHOLD)
+					mask |= static_cast<uint64_t>(1) << y;
+		}
+	}
+
+	auto filled = [&](glm::ivec3 p)
+	{
+		if (p.y < 0)
+			return (true);
+		if (p.y >= TERRAIN_HEIGHT)
+			return (false);
+		return (((masks[(p.x + 1) + (p.z + 1) * side] >> p.y) & 1) != 0);
+	};
+
+	for (int z = 0; z < CHUNK_DIM; z++)
+	{
+		for (int x = 0; x < CHUNK_DIM; x++)
+		{
+			int column = (x + 1) + (z + 1) * side;
+			uint64_t mask = masks[column];
+			uint64_t hidden = (mask >> 1) & ((mask << 1) | 1)
+				& masks[column - 1] & masks[column + 1] & masks[column - side] & masks[column + side];
+			uint64_t exposed = mask & ~hidden;
+
+			int height = heights[column];
+			int slope = 0;
+			for (int neighbour : {column - 1, column + 1, column - side, column + side})
+				slope = std::max(slope, std::abs(heights[neighbour] - height));
+
+			while (exposed)
+			{
+				int y = std::countr_zero(exposed);
+				exposed &= exposed - 1;
+
+				glm::ivec3 p(x, y, z);
+				glm::ivec3 cell = origin + p;
+				int depth = height - 1 - y;
+
+				// the surface by biome, a few layers of soil, then stone
+				glm::vec3 color(105, 105, 110);
+				if (depth == 0 && (height > 46 || temperature[column] < -0.3f))
+					color = glm::vec3(235, 240, 245);
+				else if (depth == 0 && slope >= 3)
+					color = glm::vec3(120, 118, 112);
+				else if (depth < 4 && temperature[column] > 0.25f && moisture[column] < 0.0f)
+					color = glm::vec3(219, 200, 140);
+				else if (depth == 0)
+					color = moisture[column] > 0.3f ? glm::vec3(40, 110, 45) : glm::vec3(85, 150, 60);
+				else if (depth < 4)
+					color = glm::vec3(120, 85, 55);
+
+				uint32_t jitter = (static_cast<uint32_t>(cell.x) * 0x8da6b343u ^ static_cast<uint32_t>(cell.y) * 0xd8163841u ^ static_cast<uint32_t>(cell.z) * 0xcb1ab31fu ^ _seed) >> 24;
+				glm::ivec3 rgb = glm::clamp(glm::ivec3(color * (0.92f + jitter / 255.0f * 0.16f)), 0, 255);
+
+				GPUVoxel voxel;
+				voxel.position = p;
+				voxel.color = (rgb.r << 24) | (rgb.g << 16) | (rgb.b << 8) | 0xFF;
+				voxel.normal = voxelNormal(p, filled);
+				voxel.light = 0;
+				voxels.push_back(voxel);
+			}
+		}
+	}
+}
+
+// the surface height of one column, the same the chunks get
+int			TerrainGenerator::getHeight(int x, int z) const
+{
+	std::vector<int> heights;
+	std::vector<float> temperature;
+	std::vector<float> moisture;
+
+	this->columns(glm::ivec2(x, z), 1, heights, temperature, moisture);
+	return (heights[0]);
+}
+
+ChunkSource	TerrainGenerator::getSource() const
+{
+	TerrainGenerator generator = *this;
+
+	return ([generator](glm::ivec3 origin, std::vector<GPUVoxel> &voxels) { generator.generate(origin, voxels); });
+}
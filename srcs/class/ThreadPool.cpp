@@ -0,0 +1,137 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ThreadPool.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 13:26:32 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 13:26:32 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ThreadPool.hpp"
+
+// 0 takes one thread per core
+ThreadPool::ThreadPool(int threads)
+{
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	_running = 0;
+	_stop = false;
+	for (int i = 0; i < threads; i++)
+		_threads.emplace_back(&ThreadPool::worker, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+	for (std::thread &thread : _threads)
+		thread.join();
+}
+
+void			ThreadPool::submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push(std::move(job));
+	}
+	_condition.notify_one();
+}
+
+void			ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle.wait(lock, [this] { return (_jobs.empty() && _running == 0); });
+}
+
+// job(begin, end) on a few ranges covering [0, count), returns when all are
+// done, the calling thread takes ranges too so it never waits behind other
+// jobs in the queue, helpers that start late find nothing left and return
+void			ThreadPool::parallelFor(int count, const std::function<void(int, int)> &job)
+{
+	int chunks = std::min(count, static_cast<int>(_threads.size()) * 4);
+	if (chunks <= 1)
+	{
+		if (count > 0)
+			job(0, count);
+		return ;
+	}
+
+	struct Ranges
+	{
+		std::atomic<int>		next;
+		int						remaining;
+		std::condition_variable	done;
+	};
+
+	std::shared_ptr<Ranges> ranges = std::make_shared<Ranges>();
+	ranges->next = 0;
+	ranges->remaining = chunks;
+
+	const std::function<void(int, int)> *body = &job;
+	auto work = [this, ranges, body, count, chunks]
+	{
+		for (int i = ranges->next++; i < chunks; i = ranges->next++)
+		{
+			(*body)(static_cast<int64_t>(count) * i / chunks, static_cast<int64_t>(count) * (i + 1) / chunks);
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (--ranges->remaining == 0)
+				ranges->done.notify_all();
+		}
+	};
+
+	for (int i = 1; i < chunks; i++)
+		this->submit(work);
+	work();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	ranges->done.wait(lock, [&ranges] { return (ranges->remaining == 0); });
+}
+
+int				ThreadPool::getThreadCount() const
+{
+	return (_threads.size());
+}
+
+ThreadPool		&ThreadPool::shared()
+{
+	static ThreadPool pool;
+
+	return (pool);
+}
+
+void			ThreadPool::worker(int index)
+{
+	TraceRecorder::setThreadName("Worker " + std::to_string(index));
+
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this] { return (_stop || !_jobs.empty()); });
+			if (_stop)
+				return ;
+
+			job = std::move(_jobs.front());
+			_jobs.pop();
+			_running++;
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_running--;
+			if (_jobs.empty() && _running == 0)
+				_idle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,153 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Trace.cpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 14:05:37 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 14:05:37 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Trace.hpp"
+
+std::atomic<bool>							TraceRecorder::_enabled(false);
+size_t										TraceRecorder::_capacity = TRACE_EVENTS_PER_THREAD;
+std::chrono::steady_clock::time_point		TraceRecorder::_epoch;
+
+std::mutex									TraceRecorder::_threads_mutex;
+std::vector<std::unique_ptr<TraceThread>>	TraceRecorder::_threads;
+std::set<std::string>						TraceRecorder::_names;
+
+void		TraceRecorder::enable(size_t events_per_thread)
+{
+	_capacity = std::max<size_t>(events_per_thread, 1);
+	_epoch = std::chrono::steady_clock::now();
+	_enabled.store(true, std::memory_order_release);
+
+	setThreadName("Main");
+}
+
+// the lock is only taken the first time a thread records something, the
+// buffers are owned here so they survive the threads that filled them
+TraceThread	*TraceRecorder::getThread()
+{
+	thread_local TraceThread *thread = nullptr;
+
+	if (thread)
+		return (thread);
+
+	std::lock_guard<std::mutex> lock(_threads_mutex);
+
+	std::unique_ptr<TraceThread> created = std::make_unique<TraceThread>();
+	created->events.resize(_capacity);
+	created->head.store(0, std::memory_order_relaxed);
+	created->id = static_cast<int>(_threads.size()) + 1;
+	created->name = "Thread " + std::to_string(created->id);
+
+	thread = created.get();
+	_threads.push_back(std::move(created));
+
+	return (thread);
+}
+
+void		TraceRecorder::setThreadName(const std::string &name)
+{
+	if (!isEnabled())
+		return ;
+
+	TraceThread *thread = getThread();
+
+	std::lock_guard<std::mutex> lock(_threads_mutex);
+	thread->name = name;
+}
+
+const char	*TraceRecorder::intern(const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(_threads_mutex);
+
+	return (_names.insert(name).first->c_str());
+}
+
+void		TraceRecorder::record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	if (!isEnabled())
+		return ;
+
+	TraceThread *thread = getThread();
+	uint64_t head = thread->head.load(std::memory_order_relaxed);
+
+	TraceEvent &event = thread->events[head % thread->events.size()];
+	event.name = name;
+	event.start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(start - _epoch).count();
+	event.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+	thread->head.store(head + 1, std::memory_order_release);
+}
+
+static void	writeJsonString(std::ofstream &file, const std::string &str)
+{
+	file << '"';
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			file << '\\' << c;
+		else if (static_cast<unsigned char>(c) < 0x20)
+			file << ' ';
+		else
+			file << c;
+	}
+	file << '"';
+}
+
+// meant to be called once the recording threads are idle, events still
+// being written while dumping may come out torn
+bool		TraceRecorder::write(const std::string &path)
+{
+	std::ofstream file(path);
+
+	if (!file.is_open())
+	{
+		std::cerr << "Failed to open trace file: " << path << std::endl;
+		return (false);
+	}
+
+	std::lock_guard<std::mutex> lock(_threads_mutex);
+
+	size_t total = 0;
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"RedVox\"}}";
+
+	for (std::unique_ptr<TraceThread> &thread : _threads)
+	{
+		file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id << ",\"args\":{\"name\":";
+		writeJsonString(file, thread->name);
+		file << "}}";
+
+		uint64_t head = thread->head.load(std::memory_order_acquire);
+		uint64_t size = thread->events.size();
+		uint64_t first = head > size ? head - size : 0;
+
+		for (uint64_t i = first; i < head; i++)
+		{
+			const TraceEvent &event = thread->events[i % size];
+
+			file << ",\n{\"name\":";
+			writeJsonString(file, event.name);
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id;
+			file << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0 << "}";
+		}
+		total += head - first;
+
+		if (head > size)
+			std::cout << "Trace: " << thread->name << " dropped its " << head - size << " oldest events" << std::endl;
+	}
+
+	file << "\n]}\n";
+
+	std::cout << "Trace: " << total << " events written to " << path << std::endl;
+	return (file.good());
+}
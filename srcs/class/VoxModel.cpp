@@ -18,6 +18,8 @@ VoxModel::VoxModel(std::string &name)
 	std::string		line;
 
 	_size = glm::vec3(0.0f);
+	_min = glm::ivec3(0);
+	_frame_count = 1;
 	_hasPalette = false;
 	_parsed = false;
 
@@ -29,6 +31,8 @@ VoxModel::VoxModel(std::string &name)
 		return ;
 	}
 
+	RV_TRACE_SCOPE("Parse vox");
+
 	if (VoxModel::parseVoxFile(name, *this))
 	{
 		std::cout << "Vox model parsed successfully" << std::endl;
@@ -52,11 +56,26 @@ glm::ivec3				&VoxModel::getSize()
 	return (_size);
 }
 
+glm::ivec3				VoxModel::getMin() const
+{
+	return (_min);
+}
+
 std::vector<VoxChunk>	&VoxModel::getChunks()
 {
 	return (_chunks);
 }
 
+std::vector<VoxInstance>	&VoxModel::getInstances()
+{
+	return (_instances);
+}
+
+int				VoxModel::getFrameCount() const
+{
+	return (_frame_count);
+}
+
 const uint32_t	*VoxModel::getPalette() const
 {
 	return (_palette);
@@ -67,6 +86,16 @@ void VoxModel::setSize(glm::ivec3 size)
 	_size = size;
 }
 
+void			VoxModel::setMin(glm::ivec3 min)
+{
+	_min = min;
+}
+
+void			VoxModel::setFrameCount(int frame_count)
+{
+	_frame_count = frame_count;
+}
+
 void			VoxModel::setPalette(uint32_t palette[256])
 {
 	memcpy(_palette, palette, sizeof(_palette));
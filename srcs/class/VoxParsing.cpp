@@ -12,6 +12,119 @@
 
 #include "VoxModel.hpp"
 
+// a node of the MagicaVoxel scene graph, only the first frame of a
+// transform is used, a shape node keeps its models with the keyframe (_f)
+// each one starts at
+struct VoxNode
+{
+	enum Type
+	{
+		TRANSFORM,
+		GROUP,
+		SHAPE
+	};
+
+	Type				type;
+	std::vector<int>	children;
+	glm::ivec3			translation = glm::ivec3(0);
+	glm::imat3x3		rotation = glm::imat3x3(1);
+	std::vector<std::pair<int, int>>	models;
+};
+
+static std::string	readString(std::ifstream &file)
+{
+	uint32_t size = 0;
+	file.read(reinterpret_cast<char*>(&size), 4);
+
+	std::string value(size, '\0');
+	file.read(value.data(), size);
+	return (value);
+}
+
+static std::map<std::string, std::string>	readDict(std::ifstream &file)
+{
+	std::map<std::string, std::string> dict;
+
+	uint32_t count = 0;
+	file.read(reinterpret_cast<char*>(&count), 4);
+	for (uint32_t i = 0; i < count && file; i++)
+	{
+		std::string key = readString(file);
+		dict[key] = readString(file);
+	}
+	return (dict);
+}
+
+// _r packs a signed permutation: bits 0-1 and 2-3 give the column of the
+// one in rows 0 and 1, row 2 takes the one left, bits 4-6 the row signs
+static glm::imat3x3	decodeRotation(uint8_t bits)
+{
+	int columns[3];
+	columns[0] = bits & 3;
+	columns[1] = (bits >> 2) & 3;
+	columns[2] = 3 - columns[0] - columns[1];
+
+	// anything but a permutation of 0, 1, 2 would write outside the matrix
+	if (columns[0] > 2 || columns[1] > 2 || columns[0] == columns[1])
+	{
+		std::cerr << "Invalid vox rotation " << static_cast<int>(bits) << ", using none" << std::endl;
+		return (glm::imat3x3(1));
+	}
+
+	glm::imat3x3 rotation(0);
+	for (int row = 0; row < 3; row++)
+		rotation[columns[row]][row] = (bits >> (4 + row)) & 1 ? -1 : 1;
+	return (rotation);
+}
+
+// walks the graph from the root transform and composes the transforms down
+// to each shape, in MagicaVoxel space (z up) where a voxel v of a shape of
+// the given size goes to rotation * (v - size / 2) + translation
+static void	collectInstances(const std::map<int, VoxNode> &nodes, int index, glm::imat3x3 rotation, glm::ivec3 translation,
+	const std::vector<glm::ivec3> &sizes, int frame_count, std::vector<VoxInstance> &instances, int depth)
+{
+	auto it = nodes.find(index);
+	if (it == nodes.end() || depth > 64)
+		return ;
+
+	const VoxNode &node = it->second;
+	if (node.type == VoxNode::TRANSFORM)
+	{
+		translation = translation + rotation * node.translation;
+		rotation = rotation * node.rotation;
+	}
+	else if (node.type == VoxNode::SHAPE && !node.models.empty())
+	{
+		// each frame shows the model of the last keyframe at or before it
+		std::vector<int> frames;
+		for (int frame = 0; frame < frame_count && node.models.size() > 1; frame++)
+		{
+			int chunk = node.models[0].second;
+			for (const std::pair<int, int> &key : node.models)
+				if (key.first <= frame)
+					chunk = key.second;
+			frames.push_back(chunk);
+		}
+
+		int model = frames.empty() ? node.models[0].second : frames[0];
+		for (const std::pair<int, int> &key : node.models)
+			if (key.second < 0 || key.second >= static_cast<int>(sizes.size()))
+				return ;
+
+		// file order is x, z, y here, the chunks are stored y up
+		glm::mat3 swap(1, 0, 0, 0, 0, 1, 0, 1, 0);
+		glm::mat3 turn = swap * glm::mat3(rotation) * swap;
+		glm::vec3 pivot = swap * glm::vec3(sizes[model] / 2) + 0.5f;
+		glm::vec3 offset = swap * glm::vec3(translation) + 0.5f;
+
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), offset) * glm::mat4(turn) * glm::translate(glm::mat4(1.0f), -pivot);
+		instances.push_back(VoxInstance{model, transform, frames});
+	}
+
+	for (int child : node.children)
+		collectInstances(nodes, child, rotation, translation, sizes, frame_count, instances, depth + 1);
+}
+
 bool VoxModel::parseVoxFile(const std::string &filename, VoxModel &model)
 {
 	std::ifstream file(filename, std::ios::binary);
@@ -37,6 +150,9 @@ bool VoxModel::parseVoxFile(const std::string &filename, VoxModel &model)
 		r = i; g = i; b = i; a = 255;
 		palette[i] = (r << 24) | (g << 16) | (b << 8) | a;
 	}
+
+	std::map<int, VoxNode> nodes;
+	std::vector<glm::ivec3> sizes;
 	
 	while (file) {
 		char chunkId[4];
@@ -47,6 +163,7 @@ bool VoxModel::parseVoxFile(const std::string &filename, VoxModel &model)
 		file.read(reinterpret_cast<char*>(&childChunks), 4);
 		
 		std::string chunk(chunkId, 4);
+		std::streampos content = file.tellg();
 
 		if (chunk == "SIZE")
 		{
@@ -58,6 +175,7 @@ bool VoxModel::parseVoxFile(const std::string &filename, VoxModel &model)
 			file.read(reinterpret_cast<char*>(&chunk.depth), 4);
 			file.read(reinterpret_cast<char*>(&chunk.height), 4);
 			chunk.voxels.resize(chunk.depth, std::vector<std::vector<Voxel>>(chunk.height, std::vector<Voxel>(chunk.width)));
+			sizes.push_back(glm::ivec3(chunk.width, chunk.depth, chunk.height));
 		}
 		else if (chunk == "XYZI") {
 			VoxChunk &chunk = model.getChunks().back();
@@ -78,82 +196,78 @@ bool VoxModel::parseVoxFile(const std::string &filename, VoxModel &model)
 		}
 		else if (chunk == "nTRN")
 		{
-			uint32_t nodeID;
+			int32_t nodeID = 0;
 			file.read(reinterpret_cast<char*>(&nodeID), 4);
-			
-			uint32_t dictSize;
-			file.read(reinterpret_cast<char*>(&dictSize), 4);
+			readDict(file);
 
-			for (uint32_t i = 0; i < dictSize; i++)
-			{
-				//just skip dont read
-				uint32_t keySize;
-				file.read(reinterpret_cast<char*>(&keySize), 4);
-				file.seekg(keySize, std::ios::cur);
-
-				uint32_t valueSize;
-				file.read(reinterpret_cast<char*>(&valueSize), 4);
-				file.seekg(valueSize, std::ios::cur);
-			}
+			VoxNode &node = nodes[nodeID];
+			node.type = VoxNode::TRANSFORM;
 
-			uint32_t childID;
+			int32_t childID, reserved, layerID;
+			uint32_t numFrames;
 			file.read(reinterpret_cast<char*>(&childID), 4);
-
-			uint32_t reserved;
 			file.read(reinterpret_cast<char*>(&reserved), 4);
-
-			uint32_t layerID;
 			file.read(reinterpret_cast<char*>(&layerID), 4);
-
-			uint32_t numFrames;
 			file.read(reinterpret_cast<char*>(&numFrames), 4);
+			node.children.push_back(childID);
 
-			// std::cout << "Node ID: " << nodeID << " dictSize " << dictSize  << " Child ID: " << childID << " Reserved " << reserved << " Layer ID: " << layerID << " Num Frames: " << numFrames << std::endl;
-
-			for (uint32_t i = 0; i < numFrames; i++)
-            {
-                uint32_t dictFrameSize;
-                file.read(reinterpret_cast<char*>(&dictFrameSize), 4);
-
-                for (uint32_t j = 0; j < dictFrameSize; j++)
-                {
-                    uint32_t keySize;
-                    file.read(reinterpret_cast<char*>(&keySize), 4);
-
-                    std::string key;
-                    key.resize(keySize);
-                    file.read(key.data(), keySize);
-
-                    uint32_t valueSize;
-                    file.read(reinterpret_cast<char*>(&valueSize), 4);
-
-                    std::string value;
-                    value.resize(valueSize);
-                    file.read(value.data(), valueSize);
-
-                    if (key == "_t")
-                    {
-                        VoxChunk &chunk = model.getChunks()[(nodeID / 2) - 1];
-                        
-                        std::stringstream values(value);
-                        values >> chunk.offset_x >> chunk.offset_z >> chunk.offset_y;
-                    }
-                    else if (key == "_r")
-                        file.seekg(sizeof(uint8_t), std::ios::cur);
-                    else if (key == "_f")
-                        file.seekg(sizeof(uint32_t), std::ios::cur);
-                }
-
-            } 
+			for (uint32_t i = 0; i < numFrames && file; i++)
+			{
+				std::map<std::string, std::string> frame = readDict(file);
+				if (i != 0)
+					continue ;
+
+				if (frame.count("_t"))
+				{
+					std::stringstream values(frame["_t"]);
+					values >> node.translation.x >> node.translation.y >> node.translation.z;
+				}
+				if (frame.count("_r"))
+					node.rotation = decodeRotation(static_cast<uint8_t>(std::atoi(frame["_r"].c_str())));
+			}
 		}
-		else if (chunk == "RGBA")
+		else if (chunk == "nGRP")
 		{
-			if (has_palette)
+			int32_t nodeID = 0;
+			file.read(reinterpret_cast<char*>(&nodeID), 4);
+			readDict(file);
+
+			VoxNode &node = nodes[nodeID];
+			node.type = VoxNode::GROUP;
+
+			uint32_t numChildren = 0;
+			file.read(reinterpret_cast<char*>(&numChildren), 4);
+			for (uint32_t i = 0; i < numChildren && file; i++)
 			{
-				file.seekg(chunkSize, std::ios::cur);
-				continue;
+				int32_t childID;
+				file.read(reinterpret_cast<char*>(&childID), 4);
+				node.children.push_back(childID);
 			}
-			
+		}
+		else if (chunk == "nSHP")
+		{
+			int32_t nodeID = 0;
+			file.read(reinterpret_cast<char*>(&nodeID), 4);
+			readDict(file);
+
+			VoxNode &node = nodes[nodeID];
+			node.type = VoxNode::SHAPE;
+
+			uint32_t numModels = 0;
+			file.read(reinterpret_cast<char*>(&numModels), 4);
+			for (uint32_t i = 0; i < numModels && file; i++)
+			{
+				int32_t modelID;
+				file.read(reinterpret_cast<char*>(&modelID), 4);
+
+				std::map<std::string, std::string> attributes = readDict(file);
+				int keyframe = attributes.count("_f") ? std::atoi(attributes["_f"].c_str()) : 0;
+				node.models.push_back({keyframe, modelID});
+			}
+			std::sort(node.models.begin(), node.models.end());
+		}
+		else if (chunk == "RGBA" && !has_palette)
+		{
 			has_palette = true;
 
 			for (uint32_t i = 0; i < 256; i++)
@@ -167,22 +281,49 @@ bool VoxModel::parseVoxFile(const std::string &filename, VoxModel &model)
 				palette[i] = (r << 24) | (g << 16) | (b << 8) | a;
 			}
 		}
-		else
-			file.seekg(chunkSize, std::ios::cur);
+
+		// whatever a chunk holds past what was read is skipped, MAIN is empty
+		// and only has children
+		if (file)
+			file.seekg(content + static_cast<std::streamoff>(chunkSize));
 	}
 
 	model.setPalette(palette);
+
+	// files from before the scene graph only have shapes at the origin
+	int frame_count = 1;
+	for (auto &[id, node] : nodes)
+		for (const std::pair<int, int> &key : node.models)
+			frame_count = std::max(frame_count, key.first + 1);
+	model.setFrameCount(frame_count);
+
+	std::vector<VoxInstance> &instances = model.getInstances();
+	if (nodes.count(0))
+		collectInstances(nodes, 0, glm::imat3x3(1), glm::ivec3(0), sizes, frame_count, instances, 0);
+	else
+		for (size_t i = 0; i < model.getChunks().size(); i++)
+			instances.push_back(VoxInstance{static_cast<int>(i), glm::mat4(1.0f), {}});
 	
 	glm::ivec3 min(std::numeric_limits<int>::max());
 	glm::ivec3 max(std::numeric_limits<int>::min());
 
-	for (VoxChunk &chunk : model.getChunks())
+	for (VoxInstance &instance : instances)
 	{
-		min = glm::min(min, glm::ivec3(chunk.offset_x, chunk.offset_y, chunk.offset_z));
-		max = glm::max(max, glm::ivec3(chunk.offset_x + chunk.width, chunk.offset_y + chunk.height, chunk.offset_z + chunk.depth));		
+		VoxChunk &chunk = model.getChunks()[instance.chunk];
+
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 local = glm::vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * glm::vec3(chunk.width, chunk.height, chunk.depth);
+			glm::ivec3 position = glm::ivec3(glm::round(glm::vec3(instance.transform * glm::vec4(local, 1.0f))));
+			min = glm::min(min, position);
+			max = glm::max(max, position);
+		}
 	}
+	if (instances.empty())
+		min = max = glm::ivec3(0);
 
+	model.setMin(min);
 	model.setSize(glm::ivec3(max - min));
 	
 	return (true);
-}
\ No newline at end of file
+}
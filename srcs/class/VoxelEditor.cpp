@@ -0,0 +1,579 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   VoxelEditor.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 11:02:17 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 11:02:17 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "VoxelEditor.hpp"
+
+static glm::ivec3	childBox(const FlatSVONode &parent, int child, glm::ivec3 &max)
+{
+	glm::ivec3 mid = (parent.min + parent.max) / 2;
+	glm::ivec3 min;
+
+	min.x = (child & 1) ? mid.x : parent.min.x;
+	min.y = (child & 2) ? mid.y : parent.min.y;
+	min.z = (child & 4) ? mid.z : parent.min.z;
+	max.x = (child & 1) ? parent.max.x : mid.x;
+	max.y = (child & 2) ? parent.max.y : mid.y;
+	max.z = (child & 4) ? parent.max.z : mid.z;
+
+	return (min);
+}
+
+static bool			inWorld(glm::ivec3 position, int world_dim)
+{
+	return (glm::all(glm::greaterThanEqual(position, glm::ivec3(0))) && glm::all(glm::lessThan(position, glm::ivec3(world_dim))));
+}
+
+VoxelEditor::VoxelEditor(Scene &scene) : _scene(scene)
+{
+	_node_end = _scene.flatNodes.size();
+	_voxel_end = _scene.flatVoxels.size();
+
+	FlatSVONode empty{};
+	empty.childOffset = -1;
+	empty.voxelIndex = -1;
+	_scene.flatNodes.resize(std::max(std::min(_node_end + EDIT_NODE_HEADROOM, PagedBuffer::capacity(sizeof(FlatSVONode))), _node_end), empty);
+	_scene.flatVoxels.resize(std::max(std::min(_voxel_end + EDIT_VOXEL_HEADROOM, PagedBuffer::capacity(sizeof(GPUVoxel))), _voxel_end), GPUVoxel{});
+
+	_grown = false;
+	_full = false;
+	_last_edit_ms = 0.0f;
+	_last_upload_bytes = 0;
+}
+
+VoxelEditor::~VoxelEditor()
+{
+}
+
+bool		VoxelEditor::setVoxel(glm::ivec3 position, int color)
+{
+	bool changed = this->add(position, color);
+	this->finish();
+	return (changed);
+}
+
+bool		VoxelEditor::clearVoxel(glm::ivec3 position)
+{
+	bool changed = this->remove(position);
+	this->finish();
+	return (changed);
+}
+
+// min is inclusive, max exclusive, returns how many voxels changed
+int			VoxelEditor::setRegion(glm::ivec3 min, glm::ivec3 max, int color)
+{
+	int changed = 0;
+
+	for (int z = min.z; z < max.z; z++)
+		for (int y = min.y; y < max.y; y++)
+			for (int x = min.x; x < max.x; x++)
+				changed += this->add(glm::ivec3(x, y, z), color);
+	this->finish();
+	return (changed);
+}
+
+int			VoxelEditor::clearRegion(glm::ivec3 min, glm::ivec3 max)
+{
+	int changed = 0;
+
+	for (int z = min.z; z < max.z; z++)
+		for (int y = min.y; y < max.y; y++)
+			for (int x = min.x; x < max.x; x++)
+				changed += this->remove(glm::ivec3(x, y, z));
+	this->finish();
+	return (changed);
+}
+
+// the brush: paint only recolors voxels that are already there
+int			VoxelEditor::applySphere(glm::ivec3 center, int radius, EditMode mode, int color)
+{
+	int changed = 0;
+
+	for (int z = -radius; z <= radius; z++)
+	{
+		for (int y = -radius; y <= radius; y++)
+		{
+			for (int x = -radius; x <= radius; x++)
+			{
+				if (x * x + y * y + z * z > radius * radius)
+					continue ;
+
+				glm::ivec3 position = center + glm::ivec3(x, y, z);
+				if (mode == EDIT_REMOVE)
+					changed += this->remove(position);
+				else if (mode == EDIT_ADD || this->findVoxel(position) >= 0)
+					changed += this->add(position, color);
+			}
+		}
+	}
+	this->finish();
+	return (changed);
+}
+
+// leaf whose box holds position, path goes from the root to it
+int			VoxelEditor::descend(glm::ivec3 position, std::vector<int> &path) const
+{
+	const std::vector<FlatSVONode> &nodes = _scene.flatNodes;
+	int index = 0;
+
+	path.clear();
+	path.push_back(index);
+	while (nodes[index].childOffset >= 0)
+	{
+		glm::ivec3 mid = (nodes[index].min + nodes[index].max) / 2;
+		int child = (position.x >= mid.x) | ((position.y >= mid.y) << 1) | ((position.z >= mid.z) << 2);
+
+		index = nodes[index].childOffset + child;
+		path.push_back(index);
+	}
+	return (index);
+}
+
+int			VoxelEditor::findVoxel(glm::ivec3 position) const
+{
+	if (!inWorld(position, _scene.getWorldDim()) || _scene.flatNodes.empty())
+		return (-1);
+
+	// same walk as descend without keeping the path, normals call it a lot
+	const std::vector<FlatSVONode> &nodes = _scene.flatNodes;
+	int index = 0;
+	while (nodes[index].childOffset >= 0)
+	{
+		glm::ivec3 mid = (nodes[index].min + nodes[index].max) / 2;
+		index = nodes[index].childOffset + ((position.x >= mid.x) | ((position.y >= mid.y) << 1) | ((position.z >= mid.z) << 2));
+	}
+
+	const FlatSVONode &leaf = nodes[index];
+	for (int i = 0; i < leaf.voxelCount; i++)
+		if (_scene.flatVoxels[leaf.voxelIndex + i].position == position)
+			return (leaf.voxelIndex + i);
+	return (-1);
+}
+
+// voxel by voxel walk from where the ray enters the world, before is the
+// empty cell the ray came from, where an added voxel goes
+bool		VoxelEditor::raycast(glm::vec3 origin, glm::vec3 direction, glm::ivec3 &hit, glm::ivec3 &before) const
+{
+	glm::vec3 inv_direction = 1.0f / direction;
+	glm::vec3 t1 = (glm::vec3(0.0f) - origin) * inv_direction;
+	glm::vec3 t2 = (glm::vec3(_scene.getWorldDim()) - origin) * inv_direction;
+	glm::vec3 t_min = glm::min(t1, t2);
+	glm::vec3 t_max = glm::max(t1, t2);
+
+	float enter = std::max(std::max(std::max(t_min.x, t_min.y), t_min.z), 0.0f);
+	float exit = std::min(std::min(t_max.x, t_max.y), t_max.z);
+	if (enter > exit)
+		return (false);
+
+	glm::vec3 start = origin + direction * (enter + 1e-4f);
+	glm::ivec3 cell = glm::ivec3(glm::floor(start));
+	glm::ivec3 step = glm::ivec3(glm::sign(direction));
+	glm::vec3 delta = glm::abs(inv_direction);
+	glm::vec3 next = (glm::vec3(cell) + glm::max(glm::vec3(step), 0.0f) - start) * inv_direction;
+	for (int axis = 0; axis < 3; axis++)
+		if (step[axis] == 0)
+			next[axis] = 1e30f;
+
+	before = cell;
+	for (int i = 0; i < _scene.getWorldDim() * 3 && inWorld(cell, _scene.getWorldDim()); i++)
+	{
+		if (this->findVoxel(cell) >= 0)
+		{
+			hit = cell;
+			return (true);
+		}
+		before = cell;
+
+		if (next.x < next.y && next.x < next.z)
+		{
+			cell.x += step.x;
+			next.x += delta.x;
+		}
+		else if (next.y < next.z)
+		{
+			cell.y += step.y;
+			next.y += delta.y;
+		}
+		else
+		{
+			cell.z += step.z;
+			next.z += delta.z;
+		}
+	}
+	return (false);
+}
+
+bool		VoxelEditor::add(glm::ivec3 position, int color)
+{
+	if (!inWorld(position, _scene.getWorldDim()) || _scene.flatNodes.empty() || !this->reserve())
+		return (false);
+
+	std::vector<int> path;
+	int leaf = this->descend(position, path);
+	FlatSVONode node = _scene.flatNodes[leaf];
+
+	for (int i = 0; i < node.voxelCount; i++)
+	{
+		GPUVoxel &voxel = _scene.flatVoxels[node.voxelIndex + i];
+		if (voxel.position != position)
+			continue ;
+		if (voxel.color == color)
+			return (false);
+
+		voxel.color = color;
+		this->markVoxels(node.voxelIndex + i, 1);
+		this->touch(path);
+		return (true);
+	}
+
+	std::vector<GPUVoxel> voxels(_scene.flatVoxels.begin() + std::max(node.voxelIndex, 0),
+		_scene.flatVoxels.begin() + std::max(node.voxelIndex, 0) + node.voxelCount);
+	this->freeVoxels(node.voxelIndex, node.voxelCount);
+
+	GPUVoxel voxel{};
+	voxel.position = position;
+	voxel.color = color;
+	voxel.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+	voxels.push_back(voxel);
+
+	this->buildLeaf(leaf, voxels);
+
+	for (size_t i = 1; i < path.size(); i++)
+		_scene.flatNodes[path[i - 1]].childMask |= 1 << (path[i] - _scene.flatNodes[path[i - 1]].childOffset);
+	for (int i : path)
+		this->markNode(i);
+
+	for (int z = -1; z <= 1; z++)
+		for (int y = -1; y <= 1; y++)
+			for (int x = -1; x <= 1; x++)
+				_normal_queue.push_back(position + glm::ivec3(x, y, z));
+
+	this->touch(path);
+	return (true);
+}
+
+// an emptied leaf is cleared from its parent mask, a parent left with no
+// children gives its group back and becomes an empty leaf in turn
+bool		VoxelEditor::remove(glm::ivec3 position)
+{
+	if (!inWorld(position, _scene.getWorldDim()) || _scene.flatNodes.empty() || !this->reserve())
+		return (false);
+
+	std::vector<int> path;
+	int leaf = this->descend(position, path);
+	FlatSVONode node = _scene.flatNodes[leaf];
+
+	std::vector<GPUVoxel> voxels;
+	for (int i = 0; i < node.voxelCount; i++)
+		if (_scene.flatVoxels[node.voxelIndex + i].position != position)
+			voxels.push_back(_scene.flatVoxels[node.voxelIndex + i]);
+	if (static_cast<int>(voxels.size()) == node.voxelCount)
+		return (false);
+
+	this->freeVoxels(node.voxelIndex, node.voxelCount);
+	this->buildLeaf(leaf, voxels);
+
+	for (size_t i = path.size() - 1; i > 0 && voxels.empty(); i--)
+	{
+		FlatSVONode &parent = _scene.flatNodes[path[i - 1]];
+		const FlatSVONode &child = _scene.flatNodes[path[i]];
+		if (child.childOffset >= 0 || child.voxelCount > 0)
+			break ;
+
+		parent.childMask &= ~(1 << (path[i] - parent.childOffset));
+		this->markNode(path[i - 1]);
+		if (parent.childMask != 0)
+			break ;
+
+		this->freeNodes(parent.childOffset);
+		parent.childOffset = -1;
+		parent.voxelIndex = -1;
+		parent.voxelCount = 0;
+		path.resize(i);
+	}
+
+	for (int z = -1; z <= 1; z++)
+		for (int y = -1; y <= 1; y++)
+			for (int x = -1; x <= 1; x++)
+				_normal_queue.push_back(position + glm::ivec3(x, y, z));
+
+	this->touch(path);
+	return (true);
+}
+
+// normals of everything next to an edit, then the lod averages of every
+// touched node, deepest first so children are done before their parent
+void		VoxelEditor::finish()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	auto less = [](const glm::ivec3 &a, const glm::ivec3 &b)
+	{
+		return (std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z));
+	};
+	std::sort(_normal_queue.begin(), _normal_queue.end(), less);
+	_normal_queue.erase(std::unique(_normal_queue.begin(), _normal_queue.end()), _normal_queue.end());
+
+	for (glm::ivec3 position : _normal_queue)
+		this->updateNormal(position);
+	_normal_queue.clear();
+
+	for (const std::pair<int, int> &stale : _stale)
+	{
+		SVO::aggregate(_scene.flatNodes, _scene.flatVoxels, stale.second);
+		this->markNode(stale.second);
+	}
+	_stale.clear();
+
+	_last_edit_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// outside the world counts as filled, like the skipped border of the scene build
+void		VoxelEditor::updateNormal(glm::ivec3 position)
+{
+	int index = this->findVoxel(position);
+	if (index < 0)
+		return ;
+
+	glm::vec3 normal = voxelNormal(position, [this](glm::ivec3 neighbour)
+	{
+		return (!inWorld(neighbour, _scene.getWorldDim()) || this->findVoxel(neighbour) >= 0);
+	});
+
+	GPUVoxel &voxel = _scene.flatVoxels[index];
+	if (voxel.normal == normal)
+		return ;
+	voxel.normal = normal;
+	this->markVoxels(index, 1);
+
+	std::vector<int> path;
+	this->descend(position, path);
+	this->touch(path);
+}
+
+// a leaf while the voxels fit, else a new group of 8 children like
+// SVO::subdivide, built and averaged from the bottom
+void		VoxelEditor::buildLeaf(int index, std::vector<GPUVoxel> &voxels)
+{
+	FlatSVONode &node = _scene.flatNodes[index];
+	int side = node.max.x - node.min.x;
+
+	node.childOffset = -1;
+	node.childMask = 0;
+	node.voxelCount = voxels.size();
+	node.voxelIndex = -1;
+
+	if (voxels.size() <= EDIT_LEAF_VOXELS || side <= 1)
+	{
+		if (!voxels.empty())
+		{
+			int first = this->allocateVoxels(voxels.size());
+			std::copy(voxels.begin(), voxels.end(), _scene.flatVoxels.begin() + first);
+			this->markVoxels(first, voxels.size());
+			_scene.flatNodes[index].voxelIndex = first;
+		}
+		SVO::aggregate(_scene.flatNodes, _scene.flatVoxels, index);
+		this->markNode(index);
+		return ;
+	}
+
+	int offset = this->allocateNodes();
+	FlatSVONode parent = _scene.flatNodes[index];
+	parent.childOffset = offset;
+	parent.voxelCount = 0;
+
+	std::vector<GPUVoxel> children[8];
+	glm::ivec3 mid = (parent.min + parent.max) / 2;
+	for (GPUVoxel &voxel : voxels)
+		children[(voxel.position.x >= mid.x) | ((voxel.position.y >= mid.y) << 1) | ((voxel.position.z >= mid.z) << 2)].push_back(voxel);
+
+	for (int c = 0; c < 8; c++)
+	{
+		FlatSVONode &child = _scene.flatNodes[offset + c];
+		child = FlatSVONode{};
+		child.min = childBox(parent, c, child.max);
+		child.childOffset = -1;
+		child.voxelIndex = -1;
+		if (!children[c].empty())
+			parent.childMask |= 1 << c;
+	}
+	_scene.flatNodes[index] = parent;
+
+	for (int c = 0; c < 8; c++)
+		this->buildLeaf(offset + c, children[c]);
+
+	SVO::aggregate(_scene.flatNodes, _scene.flatVoxels, index);
+	this->markNode(index);
+}
+
+// room for one add or remove past the used ends, a leaf that splits takes
+// a group of 8 nodes a level at most, false once the gpu pages could not
+// hold it and the edit is rejected, so the arrays never outgrow them
+bool		VoxelEditor::reserve()
+{
+	int levels = 1;
+	while ((1 << levels) < _scene.getWorldDim())
+		levels++;
+
+	_full = _node_end + 8 * static_cast<size_t>(levels) > PagedBuffer::capacity(sizeof(FlatSVONode))
+		|| _voxel_end + EDIT_LEAF_VOXELS + 1 > PagedBuffer::capacity(sizeof(GPUVoxel));
+	return (!_full);
+}
+
+// child groups all have 8 nodes, past the end the arrays grow up to what
+// the pages hold and the gpu buffers are made again on the next upload
+int			VoxelEditor::allocateNodes()
+{
+	if (!_free_nodes.empty())
+	{
+		int offset = _free_nodes.back();
+		_free_nodes.pop_back();
+		return (offset);
+	}
+
+	if (_node_end + 8 > _scene.flatNodes.size())
+	{
+		FlatSVONode empty{};
+		empty.childOffset = -1;
+		empty.voxelIndex = -1;
+		size_t grown = _scene.flatNodes.size() + std::max<size_t>(EDIT_NODE_HEADROOM, _scene.flatNodes.size() / 4);
+		_scene.flatNodes.resize(std::max(std::min(grown, PagedBuffer::capacity(sizeof(FlatSVONode))), _node_end + 8), empty);
+		_grown = true;
+	}
+
+	int offset = _node_end;
+	_node_end += 8;
+	return (offset);
+}
+
+// one free list per range size, leaves hold at most EDIT_LEAF_VOXELS
+int			VoxelEditor::allocateVoxels(int count)
+{
+	if (count <= EDIT_LEAF_VOXELS && !_free_voxels[count].empty())
+	{
+		int index = _free_voxels[count].back();
+		_free_voxels[count].pop_back();
+		return (index);
+	}
+
+	if (_voxel_end + count > _scene.flatVoxels.size())
+	{
+		size_t grown = _scene.flatVoxels.size() + std::max<size_t>(EDIT_VOXEL_HEADROOM, _scene.flatVoxels.size() / 4);
+		_scene.flatVoxels.resize(std::max(std::min(grown, PagedBuffer::capacity(sizeof(GPUVoxel))), _voxel_end + count), GPUVoxel{});
+		_grown = true;
+	}
+
+	int index = _voxel_end;
+	_voxel_end += count;
+	return (index);
+}
+
+void		VoxelEditor::freeNodes(int offset)
+{
+	for (int c = 0; c < 8; c++)
+	{
+		FlatSVONode &child = _scene.flatNodes[offset + c];
+		if (child.childOffset >= 0)
+			this->freeNodes(child.childOffset);
+		this->freeVoxels(child.voxelIndex, child.voxelCount);
+	}
+	_free_nodes.push_back(offset);
+}
+
+// ranges past EDIT_LEAF_VOXELS only come from a full scene build and are
+// cut in pieces the free lists can hand out again
+void		VoxelEditor::freeVoxels(int index, int count)
+{
+	if (index < 0)
+		return ;
+
+	while (count > 0)
+	{
+		int size = std::min(count, EDIT_LEAF_VOXELS);
+		_free_voxels[size].push_back(index);
+		index += size;
+		count -= size;
+	}
+}
+
+void		VoxelEditor::touch(const std::vector<int> &path)
+{
+	for (size_t depth = 0; depth < path.size(); depth++)
+		_stale.insert({-static_cast<int>(depth), path[depth]});
+}
+
+void		VoxelEditor::markNode(int index)
+{
+	_dirty_nodes.push_back(index);
+}
+
+void		VoxelEditor::markVoxels(int index, int count)
+{
+	for (int i = 0; i < count; i++)
+		_dirty_voxels.push_back(index + i);
+}
+
+// each run of consecutive dirty elements is one range update
+template <typename T>
+static size_t	uploadRuns(PagedBuffer &buffer, const std::vector<T> &data, std::vector<int> &dirty)
+{
+	std::sort(dirty.begin(), dirty.end());
+	dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+	size_t bytes = 0;
+	for (size_t i = 0; i < dirty.size();)
+	{
+		size_t run = 1;
+		while (i + run < dirty.size() && dirty[i + run] == dirty[i] + static_cast<int>(run))
+			run++;
+
+		buffer.updateRange(data.data() + dirty[i], dirty[i], run);
+		bytes += run * sizeof(T);
+		i += run;
+	}
+	dirty.clear();
+	return (bytes);
+}
+
+// false when the arrays grew, the buffers then have to be made again
+bool		VoxelEditor::upload(PagedBuffer &nodes, PagedBuffer &voxels)
+{
+	if (_grown)
+	{
+		_grown = false;
+		_dirty_nodes.clear();
+		_dirty_voxels.clear();
+		return (false);
+	}
+	if (_dirty_nodes.empty() && _dirty_voxels.empty())
+		return (true);
+
+	RV_TRACE_SCOPE("Upload edits");
+
+	_last_upload_bytes = uploadRuns(nodes, _scene.flatNodes, _dirty_nodes);
+	_last_upload_bytes += uploadRuns(voxels, _scene.flatVoxels, _dirty_voxels);
+	return (true);
+}
+
+float		VoxelEditor::getLastEditTime() const
+{
+	return (_last_edit_ms);
+}
+
+size_t		VoxelEditor::getLastUploadBytes() const
+{
+	return (_last_upload_bytes);
+}
+
+bool		VoxelEditor::isFull() const
+{
+	return (_full);
+}
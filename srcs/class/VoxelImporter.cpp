@@ -0,0 +1,430 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   VoxelImporter.cpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: TheRed <TheRed@students.42.fr>             +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 11:27:04 by TheRed            #+#    #+#             */
+/*   Updated: 2026/10/19 11:27:04 by TheRed           ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "VoxelImporter.hpp"
+
+static std::string	lowerExtension(const std::string &path)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (std::tolower(c)); });
+	return (extension);
+}
+
+bool		VoxelImporter::isVoxelFile(const std::string &path)
+{
+	std::string extension = lowerExtension(path);
+
+	return (extension == ".qb" || extension == ".binvox" || extension == ".vxl");
+}
+
+bool		VoxelImporter::isMap(const std::string &path)
+{
+	return (lowerExtension(path) == ".vxl");
+}
+
+SVO			*VoxelImporter::load(const std::string &path, int world_dim)
+{
+	RV_TRACE_SCOPE("Import voxels");
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	if (VoxelImporter::isMap(path))
+		return (VoxelImporter::vxl(path, world_dim));
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Failed to open voxel file: " << path << std::endl;
+		return (nullptr);
+	}
+
+	std::vector<GPUVoxel> voxels;
+	bool parsed = lowerExtension(path) == ".qb" ? VoxelImporter::qubicle(file, voxels) : VoxelImporter::binvox(file, voxels);
+	if (!parsed)
+	{
+		std::cerr << "Failed to parse voxel file: " << path << std::endl;
+		return (nullptr);
+	}
+
+	SVO *root = VoxelImporter::buildTree(voxels, world_dim);
+
+	std::cout << "Imported " << path << ": " << voxels.size() << " voxels in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count() << "ms" << std::endl;
+	return (root);
+}
+
+// the voxels moved so their bounds stand on the ground (y 3) in the middle
+// of the world, ranges go into their own trees on the shared ThreadPool
+SVO			*VoxelImporter::buildTree(std::vector<GPUVoxel> &voxels, int world_dim)
+{
+	glm::ivec3 low(std::numeric_limits<int>::max());
+	glm::ivec3 high(std::numeric_limits<int>::min());
+	for (const GPUVoxel &voxel : voxels)
+	{
+		low = glm::min(low, voxel.position);
+		high = glm::max(high, voxel.position);
+	}
+
+	glm::ivec3 size = high - low + 1;
+	glm::ivec3 offset = glm::ivec3((world_dim - size.x) / 2, 3, (world_dim - size.z) / 2) - low;
+
+	std::vector<SVO *> trees;
+	std::mutex mutex;
+	ThreadPool::shared().parallelFor(voxels.size(), [&](int begin, int end)
+	{
+		SVO *tree = new SVO(glm::ivec3(0), glm::ivec3(world_dim));
+		for (int i = begin; i < end; i++)
+		{
+			voxels[i].position += offset;
+			tree->insert(voxels[i], 16);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		trees.push_back(tree);
+	});
+
+	SVO *root = SVO::mergeAll(trees);
+	return (root ? root : new SVO(glm::ivec3(0), glm::ivec3(world_dim)));
+}
+
+template <typename T>
+static bool	readValue(std::ifstream &file, T &value)
+{
+	file.read(reinterpret_cast<char *>(&value), sizeof(T));
+	return (static_cast<bool>(file));
+}
+
+// the exposed cells of the middle one of three slices, layers[1] is the
+// slice at depth, a cell is 0 when empty or its color, position(x, y)
+// gives where cell x, y of the slice goes and the normal is turned by
+// axes, slices are side.x by side.y
+static void	emitSlice(const std::vector<uint32_t> layers[3], glm::ivec2 side, const std::function<glm::ivec3(int, int)> &position,
+	const glm::mat3 &axes, std::vector<GPUVoxel> &voxels)
+{
+	auto filled = [&](glm::ivec3 p)
+	{
+		if (p.x < 0 || p.y < 0 || p.x >= side.x || p.y >= side.y)
+			return (false);
+		return (layers[p.z + 1][p.x + static_cast<size_t>(side.x) * p.y] != 0);
+	};
+
+	for (int y = 0; y < side.y; y++)
+	{
+		for (int x = 0; x < side.x; x++)
+		{
+			glm::ivec3 p(x, y, 0);
+			uint32_t color = layers[1][x + static_cast<size_t>(side.x) * y];
+			if (color == 0 || (filled(p + glm::ivec3(1, 0, 0)) && filled(p - glm::ivec3(1, 0, 0))
+				&& filled(p + glm::ivec3(0, 1, 0)) && filled(p - glm::ivec3(0, 1, 0))
+				&& filled(p + glm::ivec3(0, 0, 1)) && filled(p - glm::ivec3(0, 0, 1))))
+				continue ;
+
+			GPUVoxel voxel;
+			voxel.position = position(x, y);
+			voxel.color = color;
+			voxel.normal = axes * voxelNormal(p, filled);
+			voxel.light = 0;
+			voxels.push_back(voxel);
+		}
+	}
+}
+
+// header, then per matrix its name, size and position and its z slices of
+// x fastest colors, a slice either raw or runs of (2, count, color) ended
+// by 6, alpha 0 is empty, y is up
+bool		VoxelImporter::qubicle(std::ifstream &file, std::vector<GPUVoxel> &voxels)
+{
+	const uint32_t CODEFLAG = 2;
+	const uint32_t NEXTSLICEFLAG = 6;
+
+	uint32_t header[6];
+	for (uint32_t &value : header)
+		if (!readValue(file, value))
+			return (false);
+
+	bool bgra = header[1] == 1;
+	bool left_handed = header[2] == 0;
+	bool compressed = header[3] != 0;
+
+	for (uint32_t matrix = 0; matrix < header[5]; matrix++)
+	{
+		uint8_t name_length;
+		glm::uvec3 size;
+		glm::ivec3 position;
+
+		if (!readValue(file, name_length))
+			return (false);
+		file.ignore(name_length);
+		for (int i = 0; i < 3; i++)
+			if (!readValue(file, size[i]))
+				return (false);
+		for (int i = 0; i < 3; i++)
+			if (!readValue(file, position[i]))
+				return (false);
+		if (size.x == 0 || size.y == 0 || size.x > 65536 || size.y > 65536)
+			return (false);
+
+		glm::ivec2 side(size.x, size.y);
+		size_t cells = static_cast<size_t>(size.x) * size.y;
+		std::vector<uint32_t> layers[3];
+		for (std::vector<uint32_t> &layer : layers)
+			layer.assign(cells, 0);
+
+		auto color = [bgra](uint32_t data)
+		{
+			if ((data >> 24) == 0)
+				return (0u);
+			uint32_t red = bgra ? (data >> 16) & 0xFF : data & 0xFF;
+			uint32_t blue = bgra ? data & 0xFF : (data >> 16) & 0xFF;
+			return ((red << 24) | (((data >> 8) & 0xFF) << 16) | (blue << 8) | 0xFF);
+		};
+		auto read = [&](std::vector<uint32_t> &layer)
+		{
+			uint32_t data;
+			if (!compressed)
+			{
+				for (size_t i = 0; i < cells; i++)
+				{
+					if (!readValue(file, data))
+						return (false);
+					layer[i] = color(data);
+				}
+				return (true);
+			}
+
+			std::fill(layer.begin(), layer.end(), 0);
+			size_t index = 0;
+			while (readValue(file, data) && data != NEXTSLICEFLAG)
+			{
+				uint32_t count = 1;
+				if (data == CODEFLAG && !(readValue(file, count) && readValue(file, data)))
+					return (false);
+				for (uint32_t j = 0; j < count && index < cells; j++)
+					layer[index++] = color(data);
+			}
+			return (static_cast<bool>(file));
+		};
+
+		// a left handed matrix is mirrored on z
+		glm::mat3 axes(1.0f);
+		if (left_handed)
+			axes[2][2] = -1.0f;
+
+		if (!read(layers[1]))
+			return (false);
+		for (uint32_t z = 0; z < size.z; z++)
+		{
+			if (z + 1 < size.z && !read(layers[2]))
+				return (false);
+			if (z + 1 == size.z)
+				std::fill(layers[2].begin(), layers[2].end(), 0);
+
+			int depth = left_handed ? -(position.z + static_cast<int>(z)) : position.z + static_cast<int>(z);
+			emitSlice(layers, side, [&](int x, int y) { return (glm::ivec3(position.x + x, position.y + y, depth)); }, axes, voxels);
+			std::swap(layers[0], layers[1]);
+			std::swap(layers[1], layers[2]);
+		}
+	}
+	return (true);
+}
+
+// a text header (#binvox 1, dim d w h, translate, scale, data) then
+// (value, count) byte pairs over the d w h cells, y fastest then z then x,
+// so a slice is one x, y is up
+bool		VoxelImporter::binvox(std::ifstream &file, std::vector<GPUVoxel> &voxels)
+{
+	std::string line;
+	glm::ivec3 dim(0);
+
+	if (!std::getline(file, line) || line.rfind("#binvox", 0) != 0)
+		return (false);
+	while (std::getline(file, line) && line.rfind("data", 0) != 0)
+	{
+		std::istringstream stream(line);
+		std::string kind;
+		stream >> kind;
+		if (kind == "dim")
+			stream >> dim.x >> dim.z >> dim.y;
+	}
+	if (!file || glm::any(glm::lessThanEqual(dim, glm::ivec3(0))) || glm::any(glm::greaterThan(dim, glm::ivec3(65536))))
+		return (false);
+
+	// slices are indexed y + height z like the file, so side is height by width
+	glm::ivec2 side(dim.y, dim.z);
+	size_t cells = static_cast<size_t>(dim.y) * dim.z;
+	std::vector<uint32_t> layers[3];
+	for (std::vector<uint32_t> &layer : layers)
+		layer.assign(cells, 0);
+
+	uint8_t value = 0;
+	uint8_t remaining = 0;
+	auto read = [&](std::vector<uint32_t> &layer)
+	{
+		for (size_t i = 0; i < cells; )
+		{
+			if (remaining == 0 && !(readValue(file, value) && readValue(file, remaining)))
+				return (false);
+
+			size_t count = std::min<size_t>(remaining, cells - i);
+			std::fill(layer.begin() + i, layer.begin() + i + count, value ? BINVOX_COLOR : 0);
+			i += count;
+			remaining -= count;
+		}
+		return (true);
+	};
+
+	// slice axes (y, z, x) back to (x, y, z)
+	glm::mat3 axes(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+
+	if (!read(layers[1]))
+		return (false);
+	for (int x = 0; x < dim.x; x++)
+	{
+		if (x + 1 < dim.x && !read(layers[2]))
+			return (false);
+		if (x + 1 == dim.x)
+			std::fill(layers[2].begin(), layers[2].end(), 0);
+
+		emitSlice(layers, side, [x](int y, int z) { return (glm::ivec3(x, y, z)); }, axes, voxels);
+		std::swap(layers[0], layers[1]);
+		std::swap(layers[1], layers[2]);
+	}
+	return (true);
+}
+
+// 512 by 512 columns, y rows then x, each a list of spans of 4 byte
+// words (length, top color start, top color end, air start) followed by
+// the colors of the top run then of the bottom run, z 0 is the top; the
+// first pass keeps where each column starts and a 64 bit solid mask per
+// column, the second decodes rows in parallel, the colored cells are the
+// ones that touch air
+SVO			*VoxelImporter::vxl(const std::string &path, int world_dim)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::ifstream file(path, std::ios::binary);
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!file.is_open() || data.empty())
+	{
+		std::cerr << "Failed to open voxel file: " << path << std::endl;
+		return (nullptr);
+	}
+
+	// calls color(z, bgra) for the colored cells of the column at offset
+	// and returns the solid mask, bit y set when height y is solid, or
+	// 0 past the end of the data
+	auto column = [&data](size_t &offset, const std::function<void(int, const uint8_t *)> &color)
+	{
+		uint64_t mask = ~static_cast<uint64_t>(0);
+		int z = 0;
+
+		while (true)
+		{
+			if (offset + 4 > data.size())
+				return (static_cast<uint64_t>(0));
+
+			const uint8_t *span = &data[offset];
+			int top_start = span[1];
+			int top_end = span[2];
+			int top_count = top_end - top_start + 1;
+			if (top_start >= VXL_HEIGHT || top_end >= VXL_HEIGHT || offset + 4 + std::max(top_count, 0) * 4 > data.size())
+				return (static_cast<uint64_t>(0));
+
+			for (; z < top_start; z++)
+				mask &= ~(static_cast<uint64_t>(1) << (VXL_HEIGHT - 1 - z));
+			for (int i = 0; i < top_count; i++)
+				color(top_start + i, span + 4 + i * 4);
+
+			if (span[0] == 0)
+			{
+				offset += 4 * (std::max(top_count, 0) + 1);
+				return (mask);
+			}
+
+			int bottom_count = (span[0] - 1) - std::max(top_count, 0);
+			size_t next = offset + span[0] * 4;
+			if (next + 4 > data.size() || bottom_count < 0)
+				return (static_cast<uint64_t>(0));
+
+			int bottom_end = data[next + 3];
+			for (int i = 0; i < bottom_count; i++)
+				color(bottom_end - bottom_count + i, span + 4 + (top_count + i) * 4);
+			z = bottom_end;
+			offset = next;
+		}
+	};
+
+	std::vector<size_t> offsets(VXL_SIDE * VXL_SIDE);
+	std::vector<uint64_t> masks(VXL_SIDE * VXL_SIDE);
+	size_t offset = 0;
+	for (int i = 0; i < VXL_SIDE * VXL_SIDE; i++)
+	{
+		offsets[i] = offset;
+		masks[i] = column(offset, [](int, const uint8_t *) {});
+		if (masks[i] == 0)
+		{
+			std::cerr << "Failed to parse voxel file: " << path << std::endl;
+			return (nullptr);
+		}
+	}
+
+	auto filled = [&masks](glm::ivec3 p)
+	{
+		if (p.y < 0)
+			return (true);
+		if (p.y >= VXL_HEIGHT || p.x < 0 || p.z < 0 || p.x >= VXL_SIDE || p.z >= VXL_SIDE)
+			return (false);
+		return (((masks[p.x + VXL_SIDE * p.z] >> p.y) & 1) != 0);
+	};
+
+	glm::ivec3 corner((world_dim - VXL_SIDE) / 2, 0, (world_dim - VXL_SIDE) / 2);
+	std::vector<SVO *> trees;
+	std::mutex mutex;
+	std::atomic<size_t> count(0);
+
+	ThreadPool::shared().parallelFor(VXL_SIDE, [&](int begin, int end)
+	{
+		SVO *tree = new SVO(glm::ivec3(0), glm::ivec3(world_dim));
+		size_t inserted = 0;
+
+		for (int y = begin; y < end; y++)
+		{
+			for (int x = 0; x < VXL_SIDE; x++)
+			{
+				size_t at = offsets[x + VXL_SIDE * y];
+				column(at, [&](int z, const uint8_t *bgra)
+				{
+					GPUVoxel voxel;
+					glm::ivec3 p(x, VXL_HEIGHT - 1 - z, y);
+
+					voxel.position = corner + p;
+					voxel.color = (bgra[2] << 24) | (bgra[1] << 16) | (bgra[0] << 8) | 0xFF;
+					voxel.normal = voxelNormal(p, filled);
+					voxel.light = 0;
+					inserted += tree->insert(voxel, 16);
+				});
+			}
+		}
+
+		count += inserted;
+		std::lock_guard<std::mutex> lock(mutex);
+		trees.push_back(tree);
+	});
+
+	SVO *root = SVO::mergeAll(trees);
+
+	std::cout << "Imported " << path << ": " << count << " voxels in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count()
+		<< "ms on " << ThreadPool::shared().getThreadCount() << " threads" << std::endl;
+	return (root);
+}
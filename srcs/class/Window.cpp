@@ -22,8 +22,10 @@ Window::Window(Scene *scene, int width, int height, const char *title, int sleep
 	_scene = scene;
 	_fps = 0;
 	_frameCount = 0;
-	_pixelisation = 0;
 	_output_texture = 0;
+	_view = VIEW_COLOR;
+	_aov_mask = AOV_NORMAL_DEPTH | AOV_ALBEDO;
+	_recording = new CameraPath();
 
 	glfwSetErrorCallback(GLFWErrorCallback);
 	if (!glfwInit())
@@ -64,6 +66,7 @@ Window::Window(Scene *scene, int width, int height, const char *title, int sleep
 
 Window::~Window(void)
 {
+	delete (_recording);
 	glfwTerminate();
 }
 
@@ -77,7 +80,7 @@ void Window::process_input()
 	bool up = glfwGetKey(_window, GLFW_KEY_SPACE) == GLFW_PRESS;
 	bool down = glfwGetKey(_window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
 
-	if (forward || backward || left || right || up || down)
+	if ((forward || backward || left || right || up || down) && !reproject)
 		_frameCount = 0;
 
 	_scene->getCamera()->processKeyboard(forward, backward, left, right, up, down);
@@ -103,7 +106,8 @@ void Window::mouseMoveCallback(GLFWwindow* window, double xpos, double ypos)
 	if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) 
 	{
 		win->_scene->getCamera()->processMouse(xoffset, yoffset, true);
-		win->_frameCount = 0;
+		if (!win->reproject)
+			win->_frameCount = 0;
 	}
 
 	lastX = xpos;
@@ -114,7 +118,7 @@ void Window::mouseButtonCallback(GLFWwindow* window, int button, int action, int
     Window* win = static_cast<Window*>(glfwGetWindowUserPointer(window));
     (void) win; (void) button; (void) mods;
 	
-    if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE)
+    if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE && !win->reproject)
 		win->_frameCount = 0;
 }
 void Window::keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
@@ -136,6 +140,23 @@ void Window::keyCallback(GLFWwindow *window, int key, int scancode, int action,
 				<< aperture << " " << focus << " " << fov << "\t" << bounce
 				<< std::endl;
 	}
+
+	if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+		win->_screenshot = true;
+
+	if (key == GLFW_KEY_R && action == GLFW_PRESS && !win->_record_path.empty())
+	{
+		win->_record_active = !win->_record_active;
+		if (win->_record_active)
+		{
+			win->_recording->clear();
+			win->_record_start = glfwGetTime();
+			std::cout << "Recording camera path" << std::endl;
+		}
+		else if (win->_recording->save(win->_record_path))
+			std::cout << "Camera path saved: " << win->_recording->getKeyCount() << " keys, "
+				<< win->_recording->getDuration() << "s in " << win->_record_path << std::endl;
+	}
 }
 
 void Window::updateDeltaTime()
@@ -154,9 +175,12 @@ void Window::display()
 	if (accumulate)
 		_frameCount++;
 
-	if (_scene->getCamera()->getVelocity() > 0.0f)
+	if (_scene->getCamera()->getVelocity() > 0.0f && !reproject)
 		_frameCount = 0;
 
+	if (_record_active)
+		_recording->addKey(CameraPath::capture(*_scene->getCamera(), glfwGetTime() - _record_start));
+
     glfwSwapBuffers(_window);
 }
 
@@ -180,30 +204,150 @@ void Window::imGuiNewFrame()
 	ImGui::NewFrame();
 }
 
-void Window::imGuiRender(ShaderProgram &raytracing_program)
+void Window::imGuiRender(Renderer &renderer)
 {
+	DynamicResolution	&resolution = renderer.getResolution();
+	ShaderProgram		&raytracing_program = renderer.getRaytracingProgram();
+
 	bool has_changed = false;
 	
 	ImGui::Begin("Settings");
 
 	ImGui::Text("Fps: %d", int(_fps));
 	ImGui::Text("Frame: %d", _frameCount);
-	ImGui::SliderInt("Output texture", &_output_texture, 0, 7);
+
+	if (ImGui::BeginCombo("View", aov_views[_view].name))
+	{
+		for (int i = 0; i < VIEW_COUNT; i++)
+		{
+			if (ImGui::Selectable(aov_views[i].name, _view == i))
+				_view = i;
+		}
+		ImGui::EndCombo();
+	}
+	if (_view == VIEW_RAW)
+		ImGui::SliderInt("Output texture", &_output_texture, 0, TEXTURE_COUNT - 1);
+	if (ImGui::Button("Read back"))
+		_readback_aov = true;
 	
 	ImGui::Spacing();
 
+	renderer.getProfiler().imGuiRender();
+
+	if (_screenshot)
+		renderer.getCapture().requestScreenshot();
+	_screenshot = false;
+	renderer.getCapture().imGuiRender();
+	if (renderer.getStreamer())
+		renderer.getStreamer()->imGuiRender();
+	if (renderer.getChunks())
+	{
+		renderer.getChunks()->imGuiRender();
+		has_changed |= renderer.getChunks()->consumeChanges();
+	}
+	if (renderer.getLoader())
+	{
+		renderer.getLoader()->imGuiRender();
+		has_changed |= renderer.getLoader()->consumeChanges();
+	}
+
+	VoxelEditor *editor = renderer.getEditor();
+	if (editor && ImGui::CollapsingHeader("Edit"))
+	{
+		ImGui::RadioButton("Off", &_brush_mode, 0);
+		ImGui::SameLine();
+		ImGui::RadioButton("Add", &_brush_mode, 1);
+		ImGui::SameLine();
+		ImGui::RadioButton("Remove", &_brush_mode, 2);
+		ImGui::SameLine();
+		ImGui::RadioButton("Paint", &_brush_mode, 3);
+		ImGui::SliderInt("Radius", &_brush_radius, 0, 16);
+		ImGui::ColorEdit3("Color", _brush_color);
+		ImGui::Text("Last edit %.2f ms, %zu bytes uploaded", editor->getLastEditTime(), editor->getLastUploadBytes());
+		if (editor->isFull())
+			ImGui::Text("The GPU pages are full, edits are rejected");
+		ImGui::TextDisabled("Left click in the view to apply");
+	}
+	if (editor && _brush_mode != 0 && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !ImGui::GetIO().WantCaptureMouse)
+		this->applyBrush(*editor);
+
+	// moving an instance only refits the top level, the model stays as is
+	const std::vector<SceneInstance> &instances = _scene->getInstances();
+	if (renderer.getTLAS() && ImGui::CollapsingHeader("Instances"))
+	{
+		TLAS *tlas = renderer.getTLAS();
+		ImGui::Text("%d instances, %d top level nodes, built in %.2f ms", tlas->getInstanceCount(), tlas->getNodeCount(), tlas->getBuildTime());
+		ImGui::SliderInt("Instance", &_selected_instance, 0, instances.size() - 1);
+		_selected_instance = glm::clamp(_selected_instance, 0, static_cast<int>(instances.size()) - 1);
+
+		const SceneInstance &instance = instances[_selected_instance];
+		glm::vec3 half = glm::vec3(_scene->getModels()[instance.model].size) * 0.5f;
+		glm::vec3 center = glm::vec3(instance.transform * glm::vec4(half, 1.0f));
+		glm::vec3 moved = center;
+
+		float turn = 0.0f;
+		ImGui::DragFloat3("Center", &moved[0], 0.5f);
+		if (ImGui::Button("-15 deg"))
+			turn = -15.0f;
+		ImGui::SameLine();
+		if (ImGui::Button("+15 deg"))
+			turn = 15.0f;
+
+		if (moved != center || turn != 0.0f)
+		{
+			glm::mat4 around = glm::translate(glm::mat4(1.0f), moved);
+			around = glm::rotate(around, glm::radians(turn), glm::vec3(0.0f, 1.0f, 0.0f));
+			around = glm::translate(around, -center);
+			_scene->setInstanceTransform(_selected_instance, around * instance.transform);
+		}
+	}
+
 	if (ImGui::CollapsingHeader("Camera"))
 	{
 
 		if (ImGui::Checkbox("Accumulate", &accumulate))
 			_frameCount = 0;
+		if (ImGui::Checkbox("Reproject", &reproject))
+			_frameCount = 0;
+		ImGui::SliderInt("Moving history", &_moving_history, 1, 64);
 
 		has_changed |= ImGui::SliderInt("Bounce", &_scene->getCamera()->getBounce(), 0, 20);
 		has_changed |= ImGui::SliderFloat("FOV", &_scene->getCamera()->getFov(), 1.0f, 180.0f);
 		has_changed |= ImGui::SliderFloat("Aperture", &_scene->getCamera()->getAperture(), 0.0f, 1.0f);
 		has_changed |= ImGui::SliderFloat("Focus", &_scene->getCamera()->getFocus(), 0.0f, 150.0f);
+		has_changed |= ImGui::SliderFloat("LOD bias", &_lod_bias, 0.0f, 4.0f);
+
+		const std::vector<CameraPreset> &presets = _scene->getCameraPresets();
+		for (size_t i = 0; i < presets.size(); i++)
+		{
+			if (i > 0)
+				ImGui::SameLine();
+			if (ImGui::Button(presets[i].name.c_str()))
+			{
+				_scene->applyCameraPreset(i);
+				has_changed = true;
+			}
+		}
+	}
+
+
+	if (ImGui::CollapsingHeader("Outputs"))
+	{
+		ImGui::CheckboxFlags("Normal / depth", &_aov_mask, AOV_NORMAL_DEPTH);
+		ImGui::CheckboxFlags("Albedo", &_aov_mask, AOV_ALBEDO);
+		ImGui::CheckboxFlags("Voxel ID / visits", &_aov_mask, AOV_TRAVERSAL);
+		ImGui::TextDisabled("Passes and the current view turn on what they need");
 	}
 
+	if (ImGui::CollapsingHeader("Resolution"))
+	{
+		glm::vec2 size = resolution.getResolution();
+
+		ImGui::Text("Render: %dx%d  GPU: %.2f ms", int(size.x), int(size.y), resolution.getGPUTime());
+		ImGui::Checkbox("Dynamic", &resolution.getEnabled());
+		ImGui::SliderFloat("Target (ms)", &resolution.getTarget(), 2.0f, 50.0f);
+		ImGui::SliderFloat("Scale", &resolution.getScale(), 0.25f, 1.0f);
+	}
 
 	if (ImGui::CollapsingHeader("Material"))
 	{
@@ -249,6 +393,24 @@ void Window::imGuiRender(ShaderProgram &raytracing_program)
 
 	}
 
+	if (ImGui::CollapsingHeader("Denoiser"))
+	{
+		GPUDenoise &denoise = _scene->getDenoise();
+
+		ImGui::Checkbox("Enable##denoise", (bool *)(&denoise.enabled));
+		if (ImGui::Checkbox("Temporal variance", (bool *)(&denoise.temporal)))
+			_frameCount = 0;
+		ImGui::SliderInt("Iterations", &denoise.iterations, 1, 5);
+		ImGui::SliderFloat("Color phi", &denoise.phi_color, 0.1f, 20.0f);
+		ImGui::SliderFloat("Normal phi", &denoise.phi_normal, 1.0f, 256.0f);
+		ImGui::SliderFloat("Depth phi", &denoise.phi_depth, 0.001f, 1.0f);
+		ImGui::SliderFloat("Albedo phi", &denoise.phi_albedo, 0.01f, 2.0f);
+		ImGui::SliderFloat("Moments alpha", &denoise.alpha, 0.01f, 1.0f);
+
+		if (ImGui::Button("Validate on CPU"))
+			_validate_denoise = true;
+	}
+
 	if (ImGui::CollapsingHeader("Debug"))
 	{
 		if (ImGui::Checkbox("Enable", (bool *)(&_scene->getDebug().enabled)))
@@ -292,11 +454,106 @@ void		Window::setFrameCount(int nb)
 	_frameCount = nb;
 }
 
+// R starts and stops recording the camera into path
+void		Window::setRecordPath(const std::string &path)
+{
+	_record_path = path;
+}
+
 bool		&Window::getAccumulate(void)
 {
 	return (accumulate);
 }
 
+bool		&Window::getReproject(void)
+{
+	return (reproject);
+}
+
+// frames blended together, kept short while moving so the history does not smear
+int			Window::getMaxHistory(bool moving) const
+{
+	if (!accumulate)
+		return (1);
+	if (moving)
+		return (_moving_history);
+	return (1 << 16);
+}
+
+bool		Window::consumeDenoiseValidation(void)
+{
+	bool validate = _validate_denoise;
+
+	_validate_denoise = false;
+	return (validate);
+}
+
+bool		Window::consumeAovReadback(void)
+{
+	bool readback = _readback_aov;
+
+	_readback_aov = false;
+	return (readback);
+}
+
+// ray under the mouse built like initRay in the trace shader, without the lens
+void		Window::applyBrush(VoxelEditor &editor)
+{
+	Camera *camera = _scene->getCamera();
+	ImVec2 mouse = ImGui::GetIO().MousePos;
+	ImVec2 size = ImGui::GetIO().DisplaySize;
+
+	glm::vec2 uv = glm::vec2(mouse.x / size.x, 1.0f - mouse.y / size.y) * 2.0f - 1.0f;
+	uv.x *= size.x / size.y;
+
+	float focal_length = 1.0f / tan(glm::radians(camera->getFov()) / 2.0f);
+	glm::vec3 view_ray = glm::normalize(glm::vec3(uv, -focal_length));
+	glm::vec3 direction = glm::normalize(glm::vec3(glm::inverse(camera->getViewMatrix()) * glm::vec4(view_ray, 0.0f)));
+
+	glm::ivec3 hit;
+	glm::ivec3 before;
+	if (!editor.raycast(camera->getPosition() / _scene->getVoxelSize(), direction, hit, before))
+		return ;
+
+	glm::ivec3 rgb = glm::ivec3(glm::clamp(glm::vec3(_brush_color[0], _brush_color[1], _brush_color[2]), 0.0f, 1.0f) * 255.0f);
+	int color = (rgb.r << 24) | (rgb.g << 16) | (rgb.b << 8) | 0xFF;
+
+	EditMode mode = _brush_mode == 1 ? EDIT_ADD : _brush_mode == 2 ? EDIT_REMOVE : EDIT_PAINT;
+	if (editor.applySphere(mode == EDIT_ADD ? before : hit, _brush_radius, mode, color) > 0)
+		_frameCount = 0;
+}
+
+FrameSettings	Window::getFrameSettings(void)
+{
+	FrameSettings settings;
+
+	settings.frame_count = _frameCount;
+	settings.max_history = getMaxHistory(_scene->getCamera()->hasMoved());
+	settings.accumulate = accumulate;
+
+	settings.view = getView();
+	settings.aov_mask = _aov_mask;
+	settings.output_texture = _output_texture;
+	settings.lod_bias = _lod_bias;
+
+	settings.validate_denoise = consumeDenoiseValidation();
+	settings.readback_aov = consumeAovReadback();
+
+	settings.time = static_cast<float>(glfwGetTime());
+
+	return (settings);
+}
+
+AovView		Window::getView(void) const
+{
+	return (static_cast<AovView>(_view));
+}
+
+int			Window::getAovMask(void) const
+{
+	return (_aov_mask);
+}
+
 int			Window::getOutputTexture(void) const
 {
 	return (_output_texture);